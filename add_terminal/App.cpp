@@ -1,9 +1,17 @@
 #include "App.h"
-#include "ibkr.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include "renderer.h"
 #include "command.h"
+#include "contracts.h"
+#include "profiler.h"
+#include "snapshot.h"
+#include "memory_budget.h"
+
+static const char* kSnapshotFile = "warm_start.bin";
+static const char* kContractFile = "contracts.bin";
 
 App::App() 
     : m_scannerReqId(0)
@@ -15,8 +23,13 @@ App::~App()
     stop();
 }
 
-void App::init(GLFWwindow* window)
+void App::start()
 {
+	if (m_started) return;
+	m_started = true;
+	m_startNs = Profiler::now();
+	Profiler::setThreadName("Main");
+
 	// Load configuration from file
 	if (!m_config.load("config.json")) {
 		printf("ERROR: Failed to load configuration. Application cannot start.\n");
@@ -24,21 +37,54 @@ void App::init(GLFWwindow* window)
 		throw std::runtime_error("Configuration not loaded");
 	}
 
-	// Create IbkrClient with config values (host, port, clientId)
-	m_ibClient = std::make_unique<IbkrClient>(
+	dataManager.memory.budgetBytes = (size_t)(std::max)(0, m_config.memory.budgetMB) << 20;
+
+	// Workers for everything off the UI thread; the IB threads stay separate
+	TaskScheduler::start(m_config.tasks.threads);
+
+	// Nothing reads dataManager until init() has waited for this
+	m_snapshotLoad = TaskScheduler::async([this]() {
+		uint64_t startNs = Profiler::now();
+		std::string error;
+		bool loaded = loadSnapshot(dataManager, kSnapshotFile, error);
+		dataManager.startup.snapshotLoadMs = (Profiler::now() - startNs) / 1.0e6;
+		if (!loaded) printf("Cold start: %s\n", error.c_str());
+		return loaded;
+	}, TaskPriority::High);
+
+	// Small and needed by the IB threads' first commands, so not deferred
+	std::string contractError;
+	if (loadContractCache(kContractFile, contractError)) {
+		printf("Contract cache: %zu contracts from %s\n", ContractCache::stats().entries, kContractFile);
+	}
+	else {
+		printf("Contract cache empty: %s\n", contractError.c_str());
+	}
+
+	// One IB thread per connection, clientIds from the configured one upwards.
+	// Commands queue until each connection is ready, so nothing waits here.
+	m_ib.start(
 		m_config.ibkr.host,
 		m_config.ibkr.port,
-		m_config.ibkr.clientId
+		m_config.ibkr.clientId,
+		m_config.ibkr.connections
 	);
-	m_ibThread = std::thread([this]() {
-		m_ibClient->processLoop();
-	});
 
+	// Use config values instead of hardcoded ones
+	startScanner(m_config.scanner.defaultScanCode, m_config.scanner.priceAbove);
 
-	std::this_thread::sleep_for(std::chrono::seconds(1));
+	// Request account data using account from config
+	RequestAccountDataCommand cmd;
+	cmd.accountCode = m_config.ibkr.account;
+	m_ib.pushCommand(cmd);
 
-	// Use config values instead of hardcoded ones
-	startScanner(1, m_config.scanner.defaultScanCode, m_config.scanner.priceAbove);
+	printf("✓ Account data requested for: %s\n", 
+		   m_config.ibkr.account.substr(m_config.ibkr.account.length() - 4).c_str());
+}
+
+void App::init(GLFWwindow* window)
+{
+	start();
 
 	m_renderer = std::make_unique<Renderer>();
 
@@ -47,47 +93,125 @@ void App::init(GLFWwindow* window)
 	// Set window user pointer so scroll callback can access renderer
 	glfwSetWindowUserPointer(window, m_renderer.get());
 
-	// Wire up symbol input callback
-	m_renderer->onSymbolEntered = [this](const std::string& symbol) {
-		if (dataManager.charts.find(symbol) != dataManager.charts.end()) {
-			dataManager.activeSymbol = symbol;
-			printf("Switched active chart to %s\n", symbol.c_str());
-		} else {
-			printf("No chart data for %s, requesting...\n", symbol.c_str());
-			requestChart(symbol);
-		}
+	// Wire up symbol input callback. Typed text is interned here; from
+	// this point on symbols travel as ids.
+	m_renderer->onSymbolEntered = [this](const std::string& text) {
+		showChart(SymbolTable::intern(text));
 	};
 
-	m_renderer->onScannerRowClicked = [this](const std::string& symbol) {
-		if (dataManager.charts.find(symbol) != dataManager.charts.end()) {
-			dataManager.activeSymbol = symbol;
-			printf("Switched active chart to %s\n", symbol.c_str());
-		}
-		else {
-			printf("No chart data for %s, requesting...\n", symbol.c_str());
-			requestChart(symbol);
+	m_renderer->onScannerRowClicked = [this](SymbolId symbol) {
+		showChart(symbol);
+	};
+
+	m_renderer->onChartRequested = [this](SymbolId symbol) {
+		requestChart(symbol);
+	};
+
+	m_renderer->onDepthRequested = [this](const std::string& text) {
+		subscribeDepth(SymbolTable::intern(text));
+	};
+
+	m_renderer->onTapeRequested = [this](const std::string& text) {
+		subscribeTape(SymbolTable::intern(text));
+	};
+
+	m_renderer->onTickChartRequested = [this](SymbolId symbol) {
+		startTickChart(symbol);
+	};
+
+	m_renderer->onOrderRequested = [this](const std::string& text, const OrderTemplate& tmpl, std::string& error) {
+		return placeOrder(SymbolTable::intern(text), tmpl, error);
+	};
+
+	m_renderer->onCancelRequested = [this](int orderId) {
+		cancelOrder(orderId);
+	};
+
+	// Accepts a pasted list: "AAPL MSFT, NVDA"
+	m_renderer->onWatchlistAdd = [this](const std::string& text) {
+		size_t start = 0;
+		while (start < text.size()) {
+			size_t end = text.find_first_of(" ,;\t\n", start);
+			if (end == std::string::npos) end = text.size();
+			if (end > start) addToWatchlist(SymbolTable::intern(text.substr(start, end - start)));
+			start = end + 1;
 		}
 	};
 
-	// Request account data using account from config
-	RequestAccountDataCommand cmd;
-	cmd.accountCode = m_config.ibkr.account;
-	m_ibClient->pushCommand(cmd);
+	m_renderer->onWatchlistClear = [this]() {
+		clearWatchlist();
+	};
 
-	printf("✓ Account data requested for: %s\n", 
-		   m_config.ibkr.account.substr(m_config.ibkr.account.length() - 4).c_str());
+	m_renderer->onWatchlistRowClicked = [this](SymbolId symbol) {
+		showChart(symbol);
+	};
+
+	for (size_t i = 0; i < m_ib.size(); i++) {
+		ConnectionPool::ConnectionInfo info = m_ib.info(i);
+		ConnectionStatus status;
+		status.clientId = info.clientId;
+		status.role = ConnectionPool::roleName(info.role);
+		dataManager.connection.connections.push_back(status);
+	}
+
+	// Warm start: the first frame shows the snapshot; only the bars since
+	// each chart's last one are fetched, and open streams are resumed
+	if (m_snapshotLoad.get()) {
+		dataManager.startup.snapshotCharts = dataManager.charts.size();
+		printf("Warm start: %zu charts from %s in %.1f ms\n", dataManager.charts.size(),
+			   kSnapshotFile, dataManager.startup.snapshotLoadMs);
+		requestGapFills();
+
+		// The snapshot only lists the symbols; subscribe them afresh
+		std::vector<SymbolId> watchlist;
+		for (const Watchlist::Row& row : dataManager.watchlist.rows()) watchlist.push_back(row.symbol);
+		dataManager.watchlist.clear();
+		for (SymbolId watched : watchlist) addToWatchlist(watched);
+
+		if (dataManager.depthSymbol != kNoSymbol) subscribeDepth(dataManager.depthSymbol);
+		if (dataManager.tapeSymbol != kNoSymbol) subscribeTape(dataManager.tapeSymbol);
+	}
+	m_initialized = true;
 }
 
 void App::stop()
 {
-    DisconnectCommand disconnectCmd;
+    if (!m_started) return;
+    m_started = false;
+
+    // Disconnects every connection and joins its thread
+    m_ib.stop();
+    printf("IB threads joined\n");
+
+    // Before the pool stops: a worker may be blocked on a request's future
+    m_requests.cancelAll();
+
+    // Finishes queued work; continuations that would have run on the UI
+    // thread are dropped, nothing is left to show them
+    TaskScheduler::stop();
+
+    // Only after a full init; a failed launch must not overwrite a good snapshot
+    if (m_initialized) {
+        std::string error;
+        if (saveSnapshot(dataManager, kSnapshotFile, error)) {
+            printf("Snapshot saved: %zu charts\n", dataManager.charts.size());
+        }
+        else {
+            printf("Snapshot not saved: %s\n", error.c_str());
+        }
+        m_initialized = false;
+    }
+    if (ContractCache::dirty()) {
+        std::string error;
+        if (!saveContractCache(kContractFile, error)) printf("Contract cache not saved: %s\n", error.c_str());
+    }
+    clearSpillFiles();
 
-    m_ibClient->pushCommand(disconnectCmd);
-    // 3. Wait for thread to finish
-    if (m_ibThread.joinable()) {
-        printf("Waiting for IB thread to finish...\n");
-        m_ibThread.join();
-        printf("IB thread joined\n");
+    // The workers are done with every mapped vertex buffer; unmap and delete
+    // them, and the rest of the renderer's GL objects, while the context lives
+    if (m_renderer) {
+        if (GLFWwindow* window = glfwGetCurrentContext()) glfwSetWindowUserPointer(window, nullptr);
+        m_renderer.reset();
     }
 
     //printf("App::stop() finished\n");
@@ -97,79 +221,109 @@ void App::stop()
 
 void App::update()
 {
-    std::queue<Event> eventQueue = m_ibClient->consumeEvents();
+    Profiler::frameMark();
+    PROFILE_ZONE("App::update");
+
+    std::vector<std::unique_ptr<EventBatch>> batches = m_ib.consumeEvents();
 
-    while (!eventQueue.empty())
+    for (const auto& batch : batches)
     {
-        handleEvent(eventQueue.front());
-        eventQueue.pop();
+        for (const Event& event : batch->events) {
+            handleEvent(event);
+        }
     }
+    // Everything handleEvent kept was copied out; rewind the arenas
+    m_ib.recycleEvents(batches);
+    m_requests.expire(Profiler::now());
+    dataManager.connection.requests = m_requests.stats();
+
+    // Results of pool work land here, between events and drawing
+    TaskScheduler::drainMain(kMainTaskBudgetNs);
     m_renderer->draw(dataManager);
+
+    // Charts drawn this frame are marked used, so check the budget after
+    uint64_t now = Profiler::now();
+    if (now - m_lastBudgetCheckNs >= kBudgetCheckIntervalNs) {
+        m_lastBudgetCheckNs = now;
+        m_renderer->gpuResidency(m_gpuResidency);
+        enforceMemoryBudget(dataManager, m_gpuResidency,
+            [this](uint32_t view) { m_renderer->releaseChartView(view); }, now);
+    }
+
+    if (dataManager.startup.firstFrameMs == 0.0) {
+        dataManager.startup.firstFrameMs = (Profiler::now() - m_startNs) / 1.0e6;
+        printf("First frame at %.0f ms after start\n", dataManager.startup.firstFrameMs);
+    }
 }
 
-void App::startScanner(int reqId, const std::string& scanCode, double priceAbove)
+void App::startScanner(const std::string& scanCode, double priceAbove)
 {
     StartScannerCommand command;
-    command.reqId = reqId;
     command.scanCode = scanCode;
     command.locationCode = "STK.US";
     command.priceAbove = priceAbove;
 
-    
-    m_ibClient->pushCommand(std::move(command));
+    // The registry cancels the subscription once the first page arrives
+    Request<std::vector<ScannerResultItem>> scan = m_requests.scanner(std::move(command));
+    scan.onComplete([this, reqId = scan.reqId()](const RequestResult<std::vector<ScannerResultItem>>& result) {
+        if (!result.ok()) {
+            printf("Scanner %s: %s\n", requestStatusName(result.status), result.error.c_str());
+            return;
+        }
+        dataManager.currentScannerResult = ScannerResult{ reqId,
+            std::pmr::vector<ScannerResultItem>(result.value.begin(), result.value.end()) };
+        dataManager.scannerRevision++;
+    });
 
-    printf("UI: Scanner command sent (reqId=%d, scanCode=%s)\n", reqId, scanCode.c_str());
+    printf("UI: Scanner command sent (reqId=%d, scanCode=%s)\n", scan.reqId(), scanCode.c_str());
 }
 
 void App::handleEvent(const Event& event)
 {
+    PROFILE_ZONE("App::handleEvent");
+    // Replies to historical, contract, snapshot and scanner requests
+    // complete their Request there
+    if (m_requests.handle(event)) return;
+
     std::visit([this](auto&& arg) {
         using T = std::decay_t<decltype(arg)>;
 
-        if constexpr (std::is_same_v<T, ScannerResult>) {
-            dataManager.currentScannerResult = arg;
-
-            CancelScannerCommand cancelCmd;
-            cancelCmd.reqId = arg.reqId;
-
-            m_ibClient->pushCommand(std::move(cancelCmd));
+        if constexpr (std::is_same_v<T, QuoteEvent>) {
+            uint64_t now = Profiler::now();
+            for (const QuoteTick& tick : arg.ticks) {
+                dataManager.watchlist.apply(tick, now);
+            }
         }
-        else if constexpr (std::is_same_v<T, HistoricalDataEvent>) {
-            // Store chart data
-            ChartData chartData;
-            chartData.symbol = arg.symbol;
-            chartData.candles = arg.candles;
-            chartData.reqId = arg.reqId;
-
-            dataManager.charts[arg.symbol] = chartData;
-            dataManager.activeSymbol = arg.symbol;
-
-            printf("Chart data received for %s: %zu candles\n", 
-                   arg.symbol.c_str(), arg.candles.size());
+        else if constexpr (std::is_same_v<T, ConnectionEvent>) {
+            handleConnection(arg);
+        }
+        else if constexpr (std::is_same_v<T, RequestErrorEvent>) {
+            handleStreamError(arg);     // One-shot requests were claimed above
         }
         else if constexpr (std::is_same_v<T, AccountSummaryEvent>) {
             // Update account values (NetLiquidation, BuyingPower, etc.)
-            for (const auto& [key, accountValue] : arg.accountValues) {
+            for (const auto& accountValue : arg.accountValues) {
+                const std::pmr::string& key = accountValue.key;
                 dataManager.accountData.accountValues[key] = accountValue;
 
                 // Update summary fields for quick access
                 if (key == "NetLiquidation") {
                     try {
-                        dataManager.accountData.totalValue = std::stod(accountValue.value);
+                        dataManager.accountData.totalValue = std::stod(accountValue.value.c_str());
                     } catch (...) {
                         dataManager.accountData.totalValue = 0.0;
                     }
                 }
                 else if (key == "AvailableFunds") {
                     try {
-                        dataManager.accountData.availableFunds = std::stod(accountValue.value);
+                        dataManager.accountData.availableFunds = std::stod(accountValue.value.c_str());
                     } catch (...) {
                         dataManager.accountData.availableFunds = 0.0;
                     }
                 }
                 else if (key == "BuyingPower") {
                     try {
-                        dataManager.accountData.buyingPower = std::stod(accountValue.value);
+                        dataManager.accountData.buyingPower = std::stod(accountValue.value.c_str());
                     } catch (...) {
                         dataManager.accountData.buyingPower = 0.0;
                     }
@@ -195,28 +349,485 @@ void App::handleEvent(const Event& event)
                 if (!found) {
                     dataManager.accountData.positions.push_back(newPos);
                 }
+                dataManager.accountData.positionsRevision++;
             }
 
             printf("Account data updated: %zu account values, %zu positions\n",
                    arg.accountValues.size(), arg.positions.size());
         }
+        else if constexpr (std::is_same_v<T, OrderStatus>) {
+            dataManager.orders.apply(arg);
+        }
+        else if constexpr (std::is_same_v<T, ExecutionEvent>) {
+            printf("Execution %s: order %d %s %.0f %s @ %.2f\n", arg.execId.c_str(), arg.orderId,
+                   arg.side.c_str(), arg.shares, symbolName(arg.symbol), arg.price);
+            dataManager.orders.apply(arg);
+        }
+        else if constexpr (std::is_same_v<T, TradePrintEvent>) {
+            if (arg.reqId == m_tickChartReqId) {
+                TickChartData& ticks = dataManager.tickChart;
+                for (const TradePrint& print : arg.prints) {
+                    if (ticks.loadingHistory) ticks.pendingLive.push_back(print);
+                    else ticks.series.append(print.time, print.price);
+                }
+                return;
+            }
+            if (arg.reqId != m_tapeReqId) return;
+
+            TradeTape& tape = dataManager.tapes[arg.symbol];
+            for (const TradePrint& print : arg.prints) {
+                tape.push(print);
+            }
+        }
+        else if constexpr (std::is_same_v<T, MarketDepthEvent>) {
+            // Ignore stragglers from a subscription we already cancelled
+            if (arg.reqId != m_depthReqId) return;
+
+            OrderBook& book = dataManager.orderBooks[arg.symbol];
+            for (const DepthUpdate& update : arg.updates) {
+                book.apply(update);
+            }
+        }
     }, event.data);
 }
 
-void App::requestChart(const std::string& symbol)
+void App::showChart(SymbolId symbol)
+{
+    if (symbol == kNoSymbol) return;
+    if (dataManager.charts.find(symbol) != dataManager.charts.end()) {
+        dataManager.activeSymbol = symbol;
+        printf("Switched active chart to %s\n", symbolName(symbol));
+    }
+    else {
+        printf("No chart data for %s, requesting...\n", symbolName(symbol));
+        requestChart(symbol);
+    }
+}
+
+RequestHistoricalDataCommand App::chartRequest(SymbolId symbol, const std::string& duration, const std::string& barSize)
 {
     RequestHistoricalDataCommand cmd;
-    cmd.reqId = m_nextReqId++;
+    cmd.reqId = 0;                  // Assigned by the registry
     cmd.symbol = symbol;
     cmd.endDateTime = "";           // Empty = now
-    cmd.durationStr = "1 Y";        // 1 year of data (maximum for daily bars)
-    cmd.barSizeSetting = "1 day";   // Daily candles
+    cmd.durationStr = duration;
+    cmd.barSizeSetting = barSize;   // 1 min is the base series; charts resample it to their timeframe
     cmd.whatToShow = "TRADES";
     cmd.useRTH = 1;                 // Regular trading hours only
+    return cmd;
+}
+
+void App::requestChart(SymbolId symbol)
+{
+    // Resolve the contract first, so a mistyped symbol fails with TWS's
+    // reason instead of an empty download; after the first time it comes
+    // from the contract cache. Then 1 month of minute bars, ~8k per symbol
+    // with RTH only, and after them a year of daily bars (~250) so D1 and
+    // W1 don't stop at the ~21 days the minute base covers.
+    Request<std::vector<CandleData>> bars = m_requests.resolve(symbol).then(
+        [this, symbol](const ContractInfo&) {
+            return m_requests.historical(chartRequest(symbol, "1 M"));
+        });
+    bars.onComplete([this, bars, symbol](const RequestResult<std::vector<CandleData>>& result) {
+        if (!result.ok()) {
+            printf("No chart data for %s: %s (%s)\n", symbolName(symbol),
+                   requestStatusName(result.status), result.error.c_str());
+            return;
+        }
+        storeChart(symbol, bars.reqId(), result.value);   // The historical stage's id
+        requestDailyHistory(symbol);
+    });
 
-    
-    m_ibClient->pushCommand(std::move(cmd));
+    printf("Requesting 1-minute chart for %s (duration=1 M)\n", symbolName(symbol));
+}
+
+// Without it D1 and W1 still show the days of the minute base
+void App::requestDailyHistory(SymbolId symbol)
+{
+    Request<std::vector<CandleData>> days = m_requests.historical(chartRequest(symbol, "1 Y", "1 day"));
+    days.onComplete([this, symbol](const RequestResult<std::vector<CandleData>>& result) {
+        if (!result.ok()) {
+            printf("No daily history for %s: %s (%s)\n", symbolName(symbol),
+                   requestStatusName(result.status), result.error.c_str());
+            return;
+        }
+        auto chartIt = dataManager.charts.find(symbol);
+        if (chartIt == dataManager.charts.end()) return;
+        chartIt->second.dailyHistory.assign(result.value);
+        chartIt->second.revision++;
+        printf("Daily history received for %s: %zu bars\n", symbolName(symbol), result.value.size());
+    });
+}
+
+void App::storeChart(SymbolId symbol, int reqId, const std::vector<CandleData>& candles)
+{
+    ChartData& chartData = dataManager.charts[symbol];
+    chartData.symbol = symbol;
+    resetCandles(chartData);
+    chartData.candles = candles;
+    chartData.reqId = reqId;
+    chartData.revision++;
+
+    dataManager.activeSymbol = symbol;
+
+    printf("Chart data received for %s: %zu candles\n", symbolName(symbol), candles.size());
+}
+
+// Backfill after a reconnect: replace everything from the first returned
+// bar on (the last stored bar may have been incomplete) and keep the rest
+void App::applyGapFill(SymbolId symbol, const std::vector<CandleData>& received)
+{
+    auto chartIt = dataManager.charts.find(symbol);
+    if (chartIt == dataManager.charts.end() || received.empty()) return;
+
+    std::vector<CandleData>& candles = residentCandles(dataManager, symbol);
+    // IB bar dates sort lexically within one bar size
+    auto cut = std::lower_bound(candles.begin(), candles.end(), received.front().date,
+        [](const CandleData& candle, const std::pmr::string& date) { return candle.date < date; });
+    size_t kept = cut - candles.begin();
+    candles.erase(cut, candles.end());
+    candles.insert(candles.end(), received.begin(), received.end());
+    chartIt->second.revision++;
+    printf("Gap fill for %s: %zu bars kept, %zu received\n", symbolName(symbol), kept, received.size());
+}
+
+void App::subscribeDepth(SymbolId symbol)
+{
+    if (m_depthReqId != 0) {
+        CancelMarketDepthCommand cancelCmd;
+        cancelCmd.reqId = m_depthReqId;
+        cancelCmd.isSmartDepth = true;
+        m_ib.pushCommand(std::move(cancelCmd));
+    }
+
+    SubscribeMarketDepthCommand cmd;
+    cmd.reqId = m_requests.nextReqId();
+    cmd.symbol = symbol;
+    cmd.numRows = 20;
+    cmd.isSmartDepth = true;
+    m_depthReqId = cmd.reqId;
+
+    // Start from an empty book; rows arrive as inserts
+    dataManager.orderBooks[symbol].clear();
+    dataManager.depthSymbol = symbol;
+
+    m_ib.pushCommand(std::move(cmd));
+
+    printf("Requesting market depth for %s (reqId=%d)\n", symbolName(symbol), m_depthReqId);
+}
+
+void App::subscribeTape(SymbolId symbol)
+{
+    if (m_tapeReqId != 0) {
+        CancelTickByTickCommand cancelCmd;
+        cancelCmd.reqId = m_tapeReqId;
+        m_ib.pushCommand(std::move(cancelCmd));
+    }
+
+    SubscribeTickByTickCommand cmd;
+    cmd.reqId = m_requests.nextReqId();
+    cmd.symbol = symbol;
+    m_tapeReqId = cmd.reqId;
+
+    // Keep the existing ring (and its filter) if we've watched this symbol before
+    dataManager.tapes.try_emplace(symbol);
+    dataManager.tapeSymbol = symbol;
+
+    m_ib.pushCommand(std::move(cmd));
+
+    printf("Requesting tick-by-tick trades for %s (reqId=%d)\n", symbolName(symbol), m_tapeReqId);
+}
+
+namespace {
+
+// IB's UTC form, "yyyymmdd-hh:mm:ss"
+std::string ibUtcTime(int64_t unixSeconds)
+{
+    using namespace std::chrono;
+    sys_seconds time{ seconds(unixSeconds) };
+    sys_days day = floor<days>(time);
+    year_month_day date{ day };
+    hh_mm_ss<seconds> clock{ time - day };
+    char text[32];
+    snprintf(text, sizeof(text), "%04d%02u%02u-%02d:%02d:%02d", (int)date.year(), (unsigned)date.month(),
+        (unsigned)date.day(), (int)clock.hours().count(), (int)clock.minutes().count(), (int)clock.seconds().count());
+    return text;
+}
+
+// Today's 04:00 pre-market open in New York; IB converts the time zone.
+// The date there is taken as UTC's five hours ago.
+std::string tickSessionStart()
+{
+    using namespace std::chrono;
+    year_month_day date{ floor<days>(system_clock::now() - hours(5)) };
+    char text[40];
+    snprintf(text, sizeof(text), "%04d%02u%02u 04:00:00 US/Eastern", (int)date.year(), (unsigned)date.month(),
+        (unsigned)date.day());
+    return text;
+}
+
+} // namespace
+
+// The tick chart follows one symbol. Its live prints start straight away
+// and are held back while the session's history is paged in ahead of them.
+void App::startTickChart(SymbolId symbol)
+{
+    TickChartData& ticks = dataManager.tickChart;
+    if (ticks.symbol == symbol) return;
+
+    if (m_tickChartReqId != 0) {
+        CancelTickByTickCommand cancelCmd;
+        cancelCmd.reqId = m_tickChartReqId;
+        m_ib.pushCommand(std::move(cancelCmd));
+    }
+    ticks = TickChartData{};
+    ticks.symbol = symbol;
+    ticks.loadingHistory = true;
+    m_tickHistory.cancel();    // After the reset, so its completion finds another symbol
+
+    SubscribeTickByTickCommand cmd;
+    cmd.reqId = m_requests.nextReqId();
+    cmd.symbol = symbol;
+    m_tickChartReqId = cmd.reqId;
+    m_ib.pushCommand(std::move(cmd));
+
+    printf("Requesting tick chart for %s (reqId=%d)\n", symbolName(symbol), m_tickChartReqId);
+    requestTickPage(symbol, tickSessionStart());
+}
+
+// One page of history at a time, each starting the second after the last
+// one ended (IB completes the last second of a page), until a page comes
+// back empty or reaches the first live print
+void App::requestTickPage(SymbolId symbol, const std::string& start)
+{
+    RequestHistoricalTicksCommand cmd;
+    cmd.symbol = symbol;
+    cmd.startDateTime = start;
+    m_tickHistory = m_requests.historicalTicks(std::move(cmd));
+    m_tickHistory.onComplete([this, symbol](const RequestResult<std::vector<TradePrint>>& result) {
+        TickChartData& ticks = dataManager.tickChart;
+        if (ticks.symbol != symbol) return;
+        ticks.historyPages++;
+        for (const TradePrint& print : result.value) ticks.series.append(print.time, print.price);
+
+        bool caughtUp = !ticks.pendingLive.empty() && ticks.series.lastTime() >= ticks.pendingLive.front().time;
+        if (result.ok() && !result.value.empty() && !caughtUp) {
+            requestTickPage(symbol, ibUtcTime(ticks.series.lastTime() + 1));
+            return;
+        }
+        if (!result.ok()) {
+            ticks.error = result.error;
+            printf("Tick history for %s stopped after %zu pages: %s\n", symbolName(symbol),
+                ticks.historyPages, result.error.c_str());
+        }
+
+        // History already has every print of its last second
+        int64_t historyEnd = ticks.series.empty() ? INT64_MIN : ticks.series.lastTime();
+        for (const TradePrint& print : ticks.pendingLive) {
+            if (print.time > historyEnd) ticks.series.append(print.time, print.price);
+        }
+        std::vector<TradePrint>().swap(ticks.pendingLive);
+        ticks.loadingHistory = false;
+    });
+}
+
+// Limit orders are priced off the touch when the symbol has a depth book,
+// otherwise off the last close of its chart.
+bool App::referencePrice(SymbolId symbol, const OrderTemplate& tmpl, double& price) const
+{
+    bool isBuy = tmpl.action == "BUY";
+
+    auto bookIt = dataManager.orderBooks.find(symbol);
+    if (bookIt != dataManager.orderBooks.end()) {
+        const OrderBook& book = bookIt->second;
+        if (isBuy ? book.hasAsk() : book.hasBid()) {
+            int64_t tick = isBuy ? book.bestAskTick() + tmpl.limitOffsetTicks
+                                 : book.bestBidTick() - tmpl.limitOffsetTicks;
+            price = book.toPrice(tick);
+            return true;
+        }
+    }
+
+    auto chartIt = dataManager.charts.find(symbol);
+    CandleData last;
+    if (chartIt != dataManager.charts.end() && lastCandle(chartIt->second, last)) {
+        // The contract's tick once its details are known, else a cent
+        ContractInfo contract;
+        double tick = ContractCache::find(symbol, contract) && contract.minTick > 0.0 ? contract.minTick : 0.01;
+        double offset = tmpl.limitOffsetTicks * tick;
+        price = std::round((last.close + (isBuy ? offset : -offset)) / tick) * tick;
+        return true;
+    }
+    return false;
+}
+
+bool App::placeOrder(SymbolId symbol, const OrderTemplate& tmpl, std::string& error)
+{
+    uint64_t clickNs = Profiler::now();
+
+    double limitPrice = 0.0;
+    if (tmpl.orderType == "LMT" && !referencePrice(symbol, tmpl, limitPrice)) {
+        error = "No price for " + SymbolTable::name(symbol) + " (load a chart or subscribe depth)";
+        return false;
+    }
+
+    int orderId = m_ib.nextOrderId();
+    if (orderId < 0) {
+        error = "No order id from TWS yet";
+        return false;
+    }
+
+    PlaceOrderCommand cmd;
+    cmd.orderId = orderId;
+    cmd.symbol = symbol;
+    cmd.action = tmpl.action;
+    cmd.orderType = tmpl.orderType;
+    cmd.quantity = tmpl.quantity;
+    cmd.limitPrice = limitPrice;
+    cmd.tif = tmpl.tif;
+    cmd.outsideRth = tmpl.outsideRth;
+
+    dataManager.orders.create(orderId, symbol, tmpl, limitPrice, clickNs);
+    m_ib.submitOrder(std::move(cmd));
+    dataManager.orders.markSent(orderId, Profiler::now());
+    return true;
+}
+
+void App::addToWatchlist(SymbolId symbol)
+{
+    if (symbol == kNoSymbol || dataManager.watchlist.contains(symbol)) return;
+
+    SubscribeQuotesCommand cmd;
+    cmd.reqId = m_requests.nextReqId();
+    cmd.symbol = symbol;
+    dataManager.watchlist.add(symbol, cmd.reqId);
+    m_ib.pushCommand(std::move(cmd));
+}
+
+void App::clearWatchlist()
+{
+    for (const Watchlist::Row& row : dataManager.watchlist.rows()) {
+        if (row.reqId > 0) m_ib.pushCommand(CancelQuotesCommand{ row.reqId });
+    }
+    dataManager.watchlist.clear();
+}
+
+void App::cancelOrder(int orderId)
+{
+    CancelOrderCommand cmd;
+    cmd.orderId = orderId;
+    m_ib.sendCancelOrder(cmd);
+    dataManager.orders.markCancelRequested(orderId);
+}
+
+namespace {
+
+// Calendar days from an IB bar date ("yyyymmdd" or "yyyymmdd hh:mm:ss...")
+// to today, or -1 if the date does not parse
+int daysSince(const std::pmr::string& barDate)
+{
+    if (barDate.size() < 8) return -1;
+    int year = 0, month = 0, day = 0;
+    if (std::sscanf(barDate.c_str(), "%4d%2d%2d", &year, &month, &day) != 3) return -1;
+
+    using namespace std::chrono;
+    year_month_day date{ std::chrono::year(year), std::chrono::month((unsigned)month), std::chrono::day((unsigned)day) };
+    if (!date.ok()) return -1;
+    sys_days today = floor<days>(system_clock::now());
+    return (int)(today - sys_days(date)).count();
+}
+
+} // namespace
+
+void App::handleConnection(const ConnectionEvent& event)
+{
+    ConnectionHealth& health = dataManager.connection;
+    auto status = std::find_if(health.connections.begin(), health.connections.end(),
+        [&](const ConnectionStatus& s) { return s.clientId == event.clientId; });
+    if (status == health.connections.end()) return;
+
+    if (!event.connected) {
+        status->connected = false;
+        if (health.outageStartNs == 0) health.outageStartNs = Profiler::now();
+        printf("Connection clientId:%d lost\n", event.clientId);
+        return;
+    }
+
+    bool wasDown = !status->connected && health.outageStartNs != 0;
+    status->connected = true;
+
+    // Depth restarts from an empty book; inserts would otherwise land on top
+    // of the stale rows
+    if (std::find(event.replayed.begin(), event.replayed.end(), m_depthReqId) != event.replayed.end()) {
+        dataManager.orderBooks[dataManager.depthSymbol].clear();
+    }
+
+    if (event.outageNs == 0 && !wasDown) return;  // First connect or a 1101 stream replay
+
+    status->reconnects++;
+    status->lastOutageMs = event.outageNs / 1.0e6;
+    printf("Connection clientId:%d back after %.0f ms (%d attempts), %zu subscriptions replayed\n",
+           event.clientId, status->lastOutageMs, event.attempts, event.replayed.size());
+
+    bool allUp = std::all_of(health.connections.begin(), health.connections.end(),
+        [](const ConnectionStatus& s) { return s.connected; });
+    if (allUp) {
+        requestGapFills();
+        checkRecovered();
+    }
+}
+
+// TWS already dropped the stream; forget it so switching symbols doesn't
+// send a cancel for it
+void App::handleStreamError(const RequestErrorEvent& event)
+{
+    if (!m_ib.streamEnded(event.reqId)) return;
+    printf("Stream reqId=%d rejected (%d): %s\n", event.reqId, event.code, event.message.c_str());
+    if (event.reqId == m_depthReqId) m_depthReqId = 0;
+    if (event.reqId == m_tapeReqId) m_tapeReqId = 0;
+    if (event.reqId == m_tickChartReqId) m_tickChartReqId = 0;
+}
+
+// Only the bars since each chart's last stored bar are requested; the last
+// bar itself is re-fetched since it may have been in progress
+void App::requestGapFills()
+{
+    ConnectionHealth& health = dataManager.connection;
+    for (const auto& [symbol, chart] : dataManager.charts) {
+        CandleData last;
+        if (!lastCandle(chart, last)) continue;
+        int days = daysSince(last.date);
+        if (days < 0) continue;
+
+        std::string duration = std::to_string(days + 1) + " D";
+        Request<std::vector<CandleData>> fill = m_requests.historical(chartRequest(symbol, duration));
+        int reqId = fill.reqId();
+        health.pendingGapFills.insert(reqId);
+        printf("Requesting gap fill for %s (reqId=%d, duration=%s)\n",
+               symbolName(symbol), reqId, duration.c_str());
+
+        // A fill that fails or times out still counts as settled, so one
+        // bad symbol can't hold recovery open
+        fill.onComplete([this, symbol, reqId](const RequestResult<std::vector<CandleData>>& result) {
+            dataManager.connection.pendingGapFills.erase(reqId);
+            if (result.ok()) applyGapFill(symbol, result.value);
+            else printf("Gap fill for %s %s: %s\n", symbolName(symbol),
+                        requestStatusName(result.status), result.error.c_str());
+            checkRecovered();
+        });
+    }
+}
+
+void App::checkRecovered()
+{
+    ConnectionHealth& health = dataManager.connection;
+    if (health.outageStartNs == 0 || !health.pendingGapFills.empty()) return;
+    for (const ConnectionStatus& status : health.connections) {
+        if (!status.connected) return;
+    }
 
-    printf("Requesting daily chart for %s (reqId=%d, duration=%s)\n", 
-           symbol.c_str(), cmd.reqId, cmd.durationStr.c_str());
+    health.lastRecoveryMs = (Profiler::now() - health.outageStartNs) / 1.0e6;
+    health.recoveries++;
+    health.outageStartNs = 0;
+    printf("Fully recovered in %.0f ms\n", health.lastRecoveryMs);
 }
@@ -5,14 +5,18 @@
 #include <mutex>
 #include <thread>
 #include <queue>
+#include <future>
 
 #include "event.h"
 #include "command.h"
 #include "DataManager.h"
 #include "Config.h"
+#include "connection_pool.h"
+#include "ib_requests.h"
+#include "memory_budget.h"
+#include "task_scheduler.h"
 
 // Forward declarations
-class IbkrClient;
 class Renderer;
 struct GLFWwindow;
 
@@ -21,25 +25,80 @@ public:
     App();
     ~App();
 
+    // Everything that doesn't need a window: config, IB connections and a
+    // worker decoding the warm-start snapshot. Call before creating the
+    // window so TWS connects while GL and ImGui initialise.
+    void start();
+    // Renderer and UI wiring. Calls start() first if main didn't.
     void init(GLFWwindow* window);
+    // Joins the IB threads and the workers, saves state and frees the
+    // renderer's GL objects. Call before the GL context is destroyed; the
+    // destructor's call is a no-op then.
     void stop();
     void update();
 
+    // Make a symbol's chart active, requesting it first if needed
+    void showChart(SymbolId symbol);
+
     // Request chart for a symbol
-    void requestChart(const std::string& symbol);
+    void requestChart(SymbolId symbol);
+
+    // Switch the Level 2 subscription to a symbol (one at a time)
+    void subscribeDepth(SymbolId symbol);
+
+    // Switch the time & sales subscription to a symbol (one at a time)
+    void subscribeTape(SymbolId symbol);
+
+    // Switch the tick chart to a symbol (one at a time): the session's
+    // prints so far, then live
+    void startTickChart(SymbolId symbol);
+
+    // Send an order straight to the socket. Returns false with a reason if
+    // it could not be priced or there is no order id yet.
+    bool placeOrder(SymbolId symbol, const OrderTemplate& tmpl, std::string& error);
+    void cancelOrder(int orderId);
+
+    // Watchlist rows each hold one streaming quote subscription
+    void addToWatchlist(SymbolId symbol);
+    void clearWatchlist();
 
     DataManager dataManager;
 
 private:
     std::mutex mtx;
+    bool m_started = false;
+    bool m_initialized = false;
+    uint64_t m_startNs = 0;
+    std::future<bool> m_snapshotLoad;   // Decodes into dataManager during init
     std::vector<ScannerResultItem> m_latestScannerResults;
-    std::thread m_ibThread;
     int m_scannerReqId = 0;
-    int m_nextReqId = 2;  // Start from 2 (1 is used by scanner)
-    std::unique_ptr<IbkrClient> m_ibClient;
+    int m_depthReqId = 0; // Active market depth subscription, 0 = none
+    int m_tapeReqId = 0;  // Active tick-by-tick subscription, 0 = none
+    int m_tickChartReqId = 0;  // The tick chart's own tick-by-tick subscription
+    Request<std::vector<TradePrint>> m_tickHistory;  // Page of tick history in flight
+    ConnectionPool m_ib;  // One or more TWS connections, see connection_pool.h
+    RequestRegistry m_requests{ m_ib };  // reqIds and one-shot requests, see ib_requests.h
+    std::vector<GpuResidency> m_gpuResidency;   // Scratch for the memory budget
+    uint64_t m_lastBudgetCheckNs = 0;
+    static constexpr uint64_t kBudgetCheckIntervalNs = 250000000;
+    static constexpr uint64_t kMainTaskBudgetNs = 2000000;  // UI thread time per frame for continuations
     std::unique_ptr<Renderer> m_renderer;
     Config m_config;  // Configuration loaded from file
 
-    void startScanner(int reqId, const std::string& scanCode, double priceAbove = 5.0);
+    void startScanner(const std::string& scanCode, double priceAbove = 5.0);
     void handleEvent(const Event& event);
+    RequestHistoricalDataCommand chartRequest(SymbolId symbol, const std::string& duration,
+                                              const std::string& barSize = "1 min");
+    void storeChart(SymbolId symbol, int reqId, const std::vector<CandleData>& candles);
+    void requestDailyHistory(SymbolId symbol);
+    void applyGapFill(SymbolId symbol, const std::vector<CandleData>& candles);
+    void requestTickPage(SymbolId symbol, const std::string& start);
+
+    // Reconnect recovery: backfill every chart from its last bar, then
+    // record the time to fully recovered once nothing is outstanding
+    void handleConnection(const ConnectionEvent& event);
+    void requestGapFills();
+    void checkRecovered();
+    void handleStreamError(const RequestErrorEvent& event);
+    bool referencePrice(SymbolId symbol, const OrderTemplate& tmpl, double& price) const;
 };
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -11,6 +12,7 @@ struct IBKRConfig {
     std::string host = "127.0.0.1";
     int port = 7497;  // 7497 = TWS paper trading, 7496 = TWS live
     int clientId = 0;
+    int connections = 3;  // Uses clientId .. clientId + connections - 1
 };
 
 struct ScannerConfig {
@@ -18,10 +20,20 @@ struct ScannerConfig {
     double priceAbove = 5.0;
 };
 
+struct MemoryConfig {
+    int budgetMB = 512;  // Charts: GPU buffers + candles in RAM, LRU-evicted above this
+};
+
+struct TaskConfig {
+    int threads = 0;     // Worker threads; 0 = one per core, less the UI thread
+};
+
 class Config {
 public:
     IBKRConfig ibkr;
     ScannerConfig scanner;
+    MemoryConfig memory;
+    TaskConfig tasks;
 
     bool load(const std::string& filename = "config.json") {
         std::ifstream file(filename);
@@ -51,6 +63,9 @@ public:
                 if (ibkrJson.contains("clientId")) {
                     ibkr.clientId = ibkrJson["clientId"].get<int>();
                 }
+                if (ibkrJson.contains("connections")) {
+                    ibkr.connections = ibkrJson["connections"].get<int>();
+                }
             }
 
             // Load scanner config
@@ -64,6 +79,22 @@ public:
                 }
             }
 
+            // Load memory config
+            if (j.contains("memory")) {
+                auto memoryJson = j["memory"];
+                if (memoryJson.contains("budgetMB")) {
+                    memory.budgetMB = memoryJson["budgetMB"].get<int>();
+                }
+            }
+
+            // Load task config
+            if (j.contains("tasks")) {
+                auto tasksJson = j["tasks"];
+                if (tasksJson.contains("threads")) {
+                    tasks.threads = (std::max)(0, tasksJson["threads"].get<int>());
+                }
+            }
+
             // Validate required fields
             if (ibkr.account.empty() || ibkr.account == "YOUR_ACCOUNT_NUMBER_HERE") {
                 std::cerr << "ERROR: Account number not configured in config.json!\n";
@@ -74,6 +105,9 @@ public:
             std::cout << "✓ Configuration loaded successfully\n";
             std::cout << "  Account: " << maskAccount(ibkr.account) << "\n";
             std::cout << "  Host: " << ibkr.host << ":" << ibkr.port << "\n";
+            std::cout << "  Connections: " << ibkr.connections << " (clientId " << ibkr.clientId << "+)\n";
+            std::cout << "  Memory budget: " << memory.budgetMB << " MB\n";
+            std::cout << "  Worker threads: " << (tasks.threads > 0 ? std::to_string(tasks.threads) : std::string("auto")) << "\n";
             return true;
 
         } catch (const json::exception& e) {
@@ -94,8 +128,10 @@ public:
         j["ibkr"]["host"] = "127.0.0.1";
         j["ibkr"]["port"] = 7497;
         j["ibkr"]["clientId"] = 0;
+        j["ibkr"]["connections"] = 3;
         j["scanner"]["defaultScanCode"] = "TOP_PERC_GAIN";
         j["scanner"]["priceAbove"] = 5.0;
+        j["memory"]["budgetMB"] = 512;
 
         file << j.dump(2);
         return true;
@@ -1,33 +1,138 @@
 #pragma once
 #include "event.h"
+#include "order.h"
+#include "candle_store.h"
+#include "chart_types.h"
+#include "ib_requests.h"
+#include "resample.h"
+#include "tick_chart.h"
+#include "volume_profile.h"
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 
+// Where a chart's bars live. The memory budget moves idle charts down the
+// list; residentCandles() (memory_budget.h) brings them back.
+enum class CandleTier : uint8_t { Resident, Compressed, Spilled };
+
 struct ChartData {
-	std::string symbol;
-	std::vector<CandleData> candles;
+	SymbolId symbol;
+	std::vector<CandleData> candles;    // Only while Resident, see residentCandles()
 	int reqId;
+	uint64_t revision = 0;              // Bumped whenever candles change
+	TimeframeCache timeframes;          // Resampled from candles, see timeframeBars()
+	DailyHistory dailyHistory;          // A year of daily bars for D1 and W1
+	ChartTypeCache chartTypes;          // Derived from timeframes, see chartTypeBars()
+	std::array<VolumeProfile, kTimeframeCount> volumeProfiles;  // Per timeframe, built when shown
+
+	CandleTier tier = CandleTier::Resident;
+	CompressedSeries compressed;        // The bars while Compressed
+	size_t spilledBars = 0;             // While Spilled, bars and bytes in the spill file
+	size_t spilledBytes = 0;
+	uint64_t lastUsedNs = 0;            // Last read or write, for LRU eviction
+	size_t residentBytes = 0;           // Cached candleBytes() of candles...
+	uint64_t residentBytesRevision = UINT64_MAX;  // ...as of this revision
 };
 
 // Account data storage
 struct AccountData {
-	std::unordered_map<std::string, AccountValueUpdate> accountValues;
+	std::unordered_map<std::pmr::string, AccountValueUpdate> accountValues;
 	std::vector<PositionUpdate> positions;
 	double totalValue = 0.0;
 	double availableFunds = 0.0;
 	double buyingPower = 0.0;
+	uint64_t positionsRevision = 0;     // Bumped whenever positions change
+};
+
+struct ConnectionStatus {
+	int clientId = 0;
+	std::string role;
+	bool connected = false;
+	int reconnects = 0;
+	double lastOutageMs = 0.0;          // Drop -> socket back up
+};
+
+// Reconnect bookkeeping. Recovery runs from the first drop until every
+// connection is back and every chart's gap has been backfilled.
+struct ConnectionHealth {
+	std::vector<ConnectionStatus> connections;
+	uint64_t outageStartNs = 0;         // 0 while healthy
+	std::unordered_set<int> pendingGapFills;   // reqIds of outstanding backfills
+	RequestStats requests;              // Copied from the RequestRegistry each frame
+	int recoveries = 0;
+	double lastRecoveryMs = 0.0;        // Time to fully recovered, last outage
+};
+
+struct MemoryTier {
+	size_t bytes = 0;
+	size_t charts = 0;
+	uint64_t evictions = 0;             // Charts moved out of this tier
+};
+
+// Chart memory by tier against the budget, shown in the profiler window.
+// Spilled bytes are on disk and don't count against the budget.
+struct MemoryUsage {
+	size_t budgetBytes = 0;
+	MemoryTier gpu;                     // Vertex buffers and chart framebuffers
+	MemoryTier candles;                 // Resident std::vector<CandleData>
+	MemoryTier compressed;
+	MemoryTier spilled;
+	uint64_t restores = 0;              // Evicted charts brought back on access
+
+	size_t totalBytes() const { return gpu.bytes + candles.bytes + compressed.bytes; }
+};
+
+// Launch timing, shown in the profiler window
+struct StartupStats {
+	double snapshotLoadMs = 0.0;
+	size_t snapshotCharts = 0;          // 0 on a cold start
+	double firstFrameMs = 0.0;          // App::start() -> first frame drawn
+};
+
+// The tick chart's symbol and every print of its session. History is
+// paged in from the session open while live prints wait in pendingLive;
+// once it has caught up they are appended as they arrive.
+struct TickChartData {
+	SymbolId symbol = kNoSymbol;
+	TickSeries series;
+	bool loadingHistory = false;
+	size_t historyPages = 0;
+	std::vector<TradePrint> pendingLive;
+	std::string error;                  // Why the history stopped short, if it did
 };
 
 class DataManager {
 public:
 	ScannerResult currentScannerResult;
+	uint64_t scannerRevision = 0;       // Bumped on every new scanner result
 
 	// Store charts by symbol
-	std::unordered_map<std::string, ChartData> charts;
+	std::unordered_map<SymbolId, ChartData> charts;
 
 	// Active chart symbol (what's currently displayed)
-	std::string activeSymbol;
+	SymbolId activeSymbol = kNoSymbol;
 
 	// Account information
 	AccountData accountData;
+
+	// Level 2 books by symbol, and the one shown in the Market Depth ladder
+	std::unordered_map<SymbolId, OrderBook> orderBooks;
+	SymbolId depthSymbol = kNoSymbol;
+
+	// Time & sales by symbol, and the one shown in the tape window
+	std::unordered_map<SymbolId, TradeTape> tapes;
+	SymbolId tapeSymbol = kNoSymbol;
+
+	// Tick-level line chart, one symbol at a time
+	TickChartData tickChart;
+
+	// Quote board; rows with a negative reqId are simulated, not subscribed
+	Watchlist watchlist;
+
+	// Orders placed this session and any reported by TWS
+	OrderTracker orders;
+
+	ConnectionHealth connection;
+	StartupStats startup;
+	MemoryUsage memory;
 };
@@ -0,0 +1,602 @@
+#include "candle_store.h"
+#include "event.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <numeric>
+
+namespace {
+
+enum Field { TimeField, OpenField, CloseField, HighField, LowField, VolumeField, FieldCount };
+
+inline uint64_t zigzag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+inline int64_t unzigzag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+uint8_t widthFor(uint64_t maxValue)
+{
+	if (maxValue == 0) return 0;
+	if (maxValue <= 0xFF) return 1;
+	if (maxValue <= 0xFFFF) return 2;
+	if (maxValue <= 0xFFFFFFFFull) return 4;
+	return 8;
+}
+
+template <typename T>
+void pack(const uint64_t* values, size_t count, uint8_t* out)
+{
+	for (size_t i = 0; i < count; i++) {
+		T value = (T)values[i];
+		std::memcpy(out + i * sizeof(T), &value, sizeof(T));
+	}
+}
+
+// Widening copy plus zigzag; both are plain element-wise loops the
+// compiler vectorises for each width
+template <typename T>
+void unpack(const uint8_t* in, size_t count, int64_t* out)
+{
+	for (size_t i = 0; i < count; i++) {
+		T value;
+		std::memcpy(&value, in + i * sizeof(T), sizeof(T));
+		out[i] = unzigzag((uint64_t)value);
+	}
+}
+
+const uint8_t* unpackField(const uint8_t* in, uint8_t width, size_t count, int64_t* out)
+{
+	switch (width) {
+	case 0: std::fill(out, out + count, 0); break;
+	case 1: unpack<uint8_t>(in, count, out); break;
+	case 2: unpack<uint16_t>(in, count, out); break;
+	case 4: unpack<uint32_t>(in, count, out); break;
+	default: unpack<uint64_t>(in, count, out); break;
+	}
+	return in + (size_t)width * count;
+}
+
+// Howard Hinnant's days_from_civil / civil_from_days
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d)
+{
+	y -= m <= 2;
+	int64_t era = (y >= 0 ? y : y - 399) / 400;
+	unsigned yoe = (unsigned)(y - era * 400);
+	unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (int64_t)doe - 719468;
+}
+
+void civilFromDays(int64_t z, int& year, unsigned& month, unsigned& day)
+{
+	z += 719468;
+	int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+	unsigned doe = (unsigned)(z - era * 146097);
+	unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	unsigned mp = (5 * doy + 2) / 153;
+	day = doy - (153 * mp + 2) / 5 + 1;
+	month = mp < 10 ? mp + 3 : mp - 9;
+	year = (int)(yoe + era * 400 + (month <= 2));
+}
+
+bool digits(std::string_view text, size_t pos, size_t count, unsigned& value)
+{
+	if (pos + count > text.size()) return false;
+	value = 0;
+	for (size_t i = pos; i < pos + count; i++) {
+		if (text[i] < '0' || text[i] > '9') return false;
+		value = value * 10 + (unsigned)(text[i] - '0');
+	}
+	return true;
+}
+
+bool onGrid(double price, int64_t ticksPerUnit)
+{
+	return (double)std::llround(price * (double)ticksPerUnit) / (double)ticksPerUnit == price;
+}
+
+} // namespace
+
+CompressedSeries::CompressedSeries(int64_t ticksPerUnit)
+	: m_ticksPerUnit((std::max)(ticksPerUnit, (int64_t)1))
+{
+}
+
+void CompressedSeries::clear()
+{
+	m_size = 0;
+	m_blocks.clear();
+	m_data.clear();
+	m_tail.clear();
+}
+
+bool CompressedSeries::parseDate(std::string_view date, int64_t& time, DateStyle* style,
+	std::string* separator, std::string* suffix)
+{
+	unsigned y, m, d;
+	size_t length = date.find_first_not_of("0123456789");
+	if (length == std::string_view::npos) length = date.size();
+
+	// formatDate=2 bars carry epoch seconds
+	if (length != 8) {
+		if (length == 0 || length > 18 || length != date.size()) return false;
+		std::from_chars(date.data(), date.data() + date.size(), time);
+		if (style) *style = DateStyle::Epoch;
+		return true;
+	}
+	if (!digits(date, 0, 4, y) || !digits(date, 4, 2, m) || !digits(date, 6, 2, d)) return false;
+	if (m < 1 || m > 12 || d < 1 || d > 31) return false;
+	time = daysFromCivil(y, m, d) * 86400;
+	if (date.size() == 8) {
+		if (style) *style = DateStyle::Day;
+		return true;
+	}
+
+	size_t timePos = date.find_first_not_of(' ', 8);
+	unsigned hh, mm, ss;
+	if (timePos == std::string_view::npos || !digits(date, timePos, 2, hh) || date[timePos + 2] != ':' ||
+		!digits(date, timePos + 3, 2, mm) || date[timePos + 5] != ':' || !digits(date, timePos + 6, 2, ss)) {
+		return false;
+	}
+	time += hh * 3600 + mm * 60 + ss;
+	if (style) *style = DateStyle::DayTime;
+	if (separator) *separator = date.substr(8, timePos - 8);
+	if (suffix) *suffix = date.substr(timePos + 8);
+	return true;
+}
+
+bool CompressedSeries::parseBarTime(std::string_view date, int64_t& time)
+{
+	return parseDate(date, time, nullptr, nullptr, nullptr);
+}
+
+std::pmr::string CompressedSeries::formatTime(int64_t time) const
+{
+	char buffer[32];
+	if (m_dateStyle == DateStyle::Epoch) {
+		snprintf(buffer, sizeof(buffer), "%lld", (long long)time);
+		return buffer;
+	}
+
+	int64_t days = time >= 0 ? time / 86400 : (time - 86399) / 86400;
+	int64_t seconds = time - days * 86400;
+	int year;
+	unsigned month, day;
+	civilFromDays(days, year, month, day);
+	snprintf(buffer, sizeof(buffer), "%04d%02u%02u", year, month, day);
+	if (m_dateStyle == DateStyle::Day) return buffer;
+
+	std::pmr::string text = buffer;
+	snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", (int)(seconds / 3600), (int)(seconds / 60 % 60), (int)(seconds % 60));
+	text += m_dateSeparator;
+	text += buffer;
+	text += m_dateSuffix;
+	return text;
+}
+
+bool CompressedSeries::assign(const std::vector<CandleData>& candles)
+{
+	PROFILE_ZONE("CompressedSeries::assign");
+	clear();
+	m_ticksPerUnit = 100;
+	for (const CandleData& candle : candles) {
+		if (!onGrid(candle.open, 100) || !onGrid(candle.high, 100) ||
+			!onGrid(candle.low, 100) || !onGrid(candle.close, 100)) {
+			m_ticksPerUnit = 10000;
+			break;
+		}
+	}
+	// append() rejects anything finer (5-decimal FX), so those stay uncompressed
+
+	m_tail.reserve((std::min)(candles.size(), kBlockBars + 1));
+	for (const CandleData& candle : candles) {
+		if (!append(candle)) return false;
+	}
+	if (m_tail.size() > 1) seal(m_tail.size() - 1);
+	m_tail.shrink_to_fit();
+	m_blocks.shrink_to_fit();
+	m_data.shrink_to_fit();
+	return true;
+}
+
+bool CompressedSeries::append(const CandleData& candle)
+{
+	int64_t time;
+	if (m_size == 0) {
+		if (!parseDate(candle.date, time, &m_dateStyle, &m_dateSeparator, &m_dateSuffix)) return false;
+	}
+	else if (!parseBarTime(candle.date, time)) {
+		return false;
+	}
+	return append(time, candle.open, candle.high, candle.low, candle.close, (double)candle.volume);
+}
+
+bool CompressedSeries::append(int64_t time, double open, double high, double low, double close, double volume)
+{
+	// Rounding would be silent and compression must be lossless
+	if (!onGrid(open, m_ticksPerUnit) || !onGrid(high, m_ticksPerUnit) ||
+		!onGrid(low, m_ticksPerUnit) || !onGrid(close, m_ticksPerUnit)) {
+		return false;
+	}
+	const double scale = (double)m_ticksPerUnit;
+	RawBar bar{ time, std::llround(open * scale), std::llround(high * scale),
+		std::llround(low * scale), std::llround(close * scale), std::llround(volume) };
+	// Keep high/low bracketing open/close so their residuals stay unsigned
+	bar.high = (std::max)({ bar.high, bar.open, bar.close });
+	bar.low = (std::min)({ bar.low, bar.open, bar.close });
+
+	if (!m_tail.empty()) {
+		if (time < m_tail.back().time) return false;
+		if (time == m_tail.back().time) {
+			m_tail.back() = bar;
+			return true;
+		}
+	}
+	m_tail.push_back(bar);
+	m_size++;
+	if (m_tail.size() > kBlockBars) seal(kBlockBars);
+	return true;
+}
+
+void CompressedSeries::seal(size_t count)
+{
+	if (count == 0) return;
+	const RawBar* bars = m_tail.data();
+
+	Block block{};
+	block.offset = (uint32_t)m_data.size();
+	block.count = (uint16_t)count;
+	block.firstTime = bars[0].time;
+	block.firstTick = bars[0].open;
+	block.firstVolume = bars[0].volume;
+
+	int64_t unit = 0;
+	for (size_t i = 1; i < count; i++) unit = std::gcd(unit, bars[i].time - bars[i - 1].time);
+	block.timeUnit = unit > 0 ? unit : 1;
+	block.firstDelta = count > 1 ? (bars[1].time - bars[0].time) / block.timeUnit : 0;
+
+	uint64_t values[FieldCount][kBlockBars];
+	uint64_t maxValue[FieldCount] = {};
+	int64_t previousDelta = block.firstDelta;
+	int64_t previousClose = block.firstTick;
+	int64_t previousVolume = block.firstVolume;
+	for (size_t i = 0; i < count; i++) {
+		const RawBar& bar = bars[i];
+		int64_t delta = i > 0 ? (bar.time - bars[i - 1].time) / block.timeUnit : block.firstDelta;
+		values[TimeField][i] = zigzag(delta - previousDelta);
+		values[OpenField][i] = zigzag(bar.open - previousClose);
+		values[CloseField][i] = zigzag(bar.close - bar.open);
+		values[HighField][i] = zigzag(bar.high - (std::max)(bar.open, bar.close));
+		values[LowField][i] = zigzag((std::min)(bar.open, bar.close) - bar.low);
+		values[VolumeField][i] = zigzag(bar.volume - previousVolume);
+		previousDelta = delta;
+		previousClose = bar.close;
+		previousVolume = bar.volume;
+		for (int field = 0; field < FieldCount; field++) maxValue[field] = (std::max)(maxValue[field], values[field][i]);
+	}
+
+	size_t bytes = 0;
+	for (int field = 0; field < FieldCount; field++) {
+		block.width[field] = widthFor(maxValue[field]);
+		bytes += (size_t)block.width[field] * count;
+	}
+	m_data.resize(m_data.size() + bytes);
+	uint8_t* out = m_data.data() + block.offset;
+	for (int field = 0; field < FieldCount; field++) {
+		switch (block.width[field]) {
+		case 0: break;
+		case 1: pack<uint8_t>(values[field], count, out); break;
+		case 2: pack<uint16_t>(values[field], count, out); break;
+		case 4: pack<uint32_t>(values[field], count, out); break;
+		default: pack<uint64_t>(values[field], count, out); break;
+		}
+		out += (size_t)block.width[field] * count;
+	}
+
+	m_blocks.push_back(block);
+	m_tail.erase(m_tail.begin(), m_tail.begin() + (ptrdiff_t)count);
+}
+
+void CompressedSeries::decodeChunk(size_t chunk, DecodedBars& out) const
+{
+	const double scale = (double)m_ticksPerUnit;
+
+	if (chunk >= m_blocks.size()) {
+		out.count = m_tail.size();
+		for (size_t i = 0; i < out.count; i++) {
+			const RawBar& bar = m_tail[i];
+			out.time[i] = bar.time;
+			out.open[i] = (double)bar.open / scale;
+			out.high[i] = (double)bar.high / scale;
+			out.low[i] = (double)bar.low / scale;
+			out.close[i] = (double)bar.close / scale;
+			out.volume[i] = (double)bar.volume;
+		}
+		return;
+	}
+
+	const Block& block = m_blocks[chunk];
+	const size_t count = block.count;
+	out.count = count;
+
+	int64_t open[kBlockBars], close[kBlockBars], high[kBlockBars], low[kBlockBars], volume[kBlockBars];
+	const uint8_t* in = m_data.data() + block.offset;
+	in = unpackField(in, block.width[TimeField], count, out.time);
+	in = unpackField(in, block.width[OpenField], count, open);
+	in = unpackField(in, block.width[CloseField], count, close);
+	in = unpackField(in, block.width[HighField], count, high);
+	in = unpackField(in, block.width[LowField], count, low);
+	unpackField(in, block.width[VolumeField], count, volume);
+
+	// The running sums are the only serial part
+	int64_t time = block.firstTime, delta = block.firstDelta;
+	int64_t tick = block.firstTick, vol = block.firstVolume;
+	for (size_t i = 0; i < count; i++) {
+		if (i > 0) {
+			delta += out.time[i];
+			time += delta * block.timeUnit;
+		}
+		out.time[i] = time;
+		open[i] = tick + open[i];
+		tick = open[i] + close[i];
+		close[i] = tick;
+		vol += volume[i];
+		volume[i] = vol;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		high[i] = (std::max)(open[i], close[i]) + high[i];
+		low[i] = (std::min)(open[i], close[i]) - low[i];
+	}
+	// Division, not a reciprocal multiply: n / 100.0 is exactly the double
+	// the original decimal price parsed to
+	for (size_t i = 0; i < count; i++) {
+		out.open[i] = (double)open[i] / scale;
+		out.high[i] = (double)high[i] / scale;
+		out.low[i] = (double)low[i] / scale;
+		out.close[i] = (double)close[i] / scale;
+		out.volume[i] = (double)volume[i];
+	}
+}
+
+void CompressedSeries::toCandles(std::vector<CandleData>& out) const
+{
+	auto bars = std::make_unique<DecodedBars>();
+	out.clear();
+	out.reserve(m_size);
+	for (size_t chunk = 0; chunk < chunkCount(); chunk++) {
+		decodeChunk(chunk, *bars);
+		for (size_t i = 0; i < bars->count; i++) {
+			out.push_back({ formatTime(bars->time[i]), bars->open[i], bars->high[i],
+				bars->low[i], bars->close[i], (long)bars->volume[i] });
+		}
+	}
+}
+
+CandleData CompressedSeries::back() const
+{
+	const double scale = (double)m_ticksPerUnit;
+	const RawBar& bar = m_tail.back();
+	return { formatTime(bar.time), (double)bar.open / scale, (double)bar.high / scale,
+		(double)bar.low / scale, (double)bar.close / scale, (long)bar.volume };
+}
+
+namespace {
+
+constexpr uint32_t kSpillMagic = 0x53424353;    // "SCBS"
+
+template <typename T>
+void putPod(std::string& out, const T& value)
+{
+	out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void putVector(std::string& out, const std::vector<T>& values)
+{
+	putPod<uint64_t>(out, values.size());
+	out.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+void putString(std::string& out, const std::string& text)
+{
+	putPod<uint64_t>(out, text.size());
+	out.append(text);
+}
+
+// Bounds-checked reads; the first short read fails every later one
+struct SpillReader {
+	const char* cursor;
+	const char* end;
+	bool ok = true;
+
+	bool take(void* out, size_t bytes)
+	{
+		if (!ok || (size_t)(end - cursor) < bytes) return ok = false;
+		std::memcpy(out, cursor, bytes);
+		cursor += bytes;
+		return true;
+	}
+
+	template <typename T>
+	T pod()
+	{
+		T value{};
+		take(&value, sizeof(T));
+		return value;
+	}
+
+	template <typename T>
+	void vector(std::vector<T>& values)
+	{
+		uint64_t count = pod<uint64_t>();
+		if (!ok || count > (size_t)(end - cursor) / sizeof(T)) {
+			ok = false;
+			return;
+		}
+		values.resize((size_t)count);
+		take(values.data(), values.size() * sizeof(T));
+	}
+
+	void string(std::string& text)
+	{
+		uint64_t length = pod<uint64_t>();
+		if (!ok || length > (size_t)(end - cursor)) {
+			ok = false;
+			return;
+		}
+		text.assign(cursor, (size_t)length);
+		cursor += length;
+	}
+};
+
+} // namespace
+
+void CompressedSeries::save(std::string& out) const
+{
+	out.clear();
+	out.reserve(64 + m_blocks.size() * sizeof(Block) + m_data.size() + m_tail.size() * sizeof(RawBar));
+	putPod(out, kSpillMagic);
+	putPod(out, m_ticksPerUnit);
+	putPod<uint64_t>(out, m_size);
+	putPod(out, m_dateStyle);
+	putString(out, m_dateSeparator);
+	putString(out, m_dateSuffix);
+	putVector(out, m_blocks);
+	putVector(out, m_data);
+	putVector(out, m_tail);
+}
+
+bool CompressedSeries::load(const char* data, size_t size)
+{
+	SpillReader in{ data, data + size };
+	if (in.pod<uint32_t>() != kSpillMagic) return false;
+
+	CompressedSeries loaded(in.pod<int64_t>());
+	loaded.m_size = (size_t)in.pod<uint64_t>();
+	loaded.m_dateStyle = in.pod<DateStyle>();
+	in.string(loaded.m_dateSeparator);
+	in.string(loaded.m_dateSuffix);
+	in.vector(loaded.m_blocks);
+	in.vector(loaded.m_data);
+	in.vector(loaded.m_tail);
+	if (!in.ok) return false;
+
+	// Blocks must stay inside the data they index
+	size_t bars = loaded.m_tail.size();
+	for (const Block& block : loaded.m_blocks) {
+		size_t bytes = 0;
+		for (uint8_t width : block.width) {
+			if (width != 0 && width != 1 && width != 2 && width != 4 && width != 8) return false;
+			bytes += (size_t)width * block.count;
+		}
+		if (block.count > kBlockBars || block.offset + bytes > loaded.m_data.size()) return false;
+		bars += block.count;
+	}
+	if (bars != loaded.m_size) return false;
+
+	*this = std::move(loaded);
+	return true;
+}
+
+size_t stringHeapBytes(const std::string& text)
+{
+	// Heap block beyond the small-string buffer (15 chars in MSVC and libstdc++)
+	return text.capacity() > 15 ? text.capacity() + 1 : 0;
+}
+
+size_t stringHeapBytes(const std::pmr::string& text)
+{
+	return text.capacity() > 15 ? text.capacity() + 1 : 0;
+}
+
+size_t CompressedSeries::memoryBytes() const
+{
+	return sizeof(*this) + m_blocks.capacity() * sizeof(Block) + m_data.capacity() +
+		m_tail.capacity() * sizeof(RawBar) + stringHeapBytes(m_dateSeparator) + stringHeapBytes(m_dateSuffix);
+}
+
+size_t CompressedSeries::candleBytes(const std::vector<CandleData>& candles)
+{
+	size_t bytes = sizeof(candles) + candles.capacity() * sizeof(CandleData);
+	for (const CandleData& candle : candles) bytes += stringHeapBytes(candle.date);
+	return bytes;
+}
+
+CompressionStats measureCandleCompression(const std::vector<CandleData>& candles)
+{
+	CompressionStats stats;
+	stats.bars = candles.size();
+	stats.rawBytes = CompressedSeries::candleBytes(candles);
+
+	CompressedSeries series;
+	uint64_t start = Profiler::now();
+	series.assign(candles);
+	stats.encodeSeconds = (Profiler::now() - start) / 1.0e9;
+	stats.compressedBytes = series.memoryBytes();
+
+	// Touch every decoded value so the loop can't be dropped
+	auto bars = std::make_unique<DecodedBars>();
+	volatile double checksum = 0.0;
+	start = Profiler::now();
+	for (size_t chunk = 0; chunk < series.chunkCount(); chunk++) {
+		series.decodeChunk(chunk, *bars);
+		checksum = checksum + bars->close[bars->count - 1];
+	}
+	stats.decodeSeconds = (Profiler::now() - start) / 1.0e9;
+	return stats;
+}
+
+void syntheticMinuteBars(size_t bars, std::vector<CandleData>& candles)
+{
+	candles.clear();
+	candles.reserve(bars);
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+	auto next = [&state]() {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	};
+
+	int64_t day = daysFromCivil(2015, 1, 5);
+	int minute = 0;
+	int64_t price = 10000;
+	char date[48];
+	while (candles.size() < bars) {
+		int weekday = (int)((day + 4) % 7);     // 1970-01-01 was a Thursday
+		if (weekday == 0 || weekday == 6) {
+			day++;
+			continue;
+		}
+		int year;
+		unsigned month, dayOfMonth;
+		civilFromDays(day, year, month, dayOfMonth);
+		int clock = 9 * 60 + 30 + minute;
+		snprintf(date, sizeof(date), "%04d%02u%02u %02d:%02d:00 US/Eastern", year, month, dayOfMonth, clock / 60, clock % 60);
+
+		int64_t open = price + (int64_t)(next() % 5) - 2;
+		int64_t close = (std::max)((int64_t)100, open + (int64_t)(next() % 41) - 20);
+		int64_t high = (std::max)(open, close) + (int64_t)(next() % 8);
+		int64_t low = (std::min)(open, close) - (int64_t)(next() % 8);
+		price = close;
+		candles.push_back({ date, open / 100.0, high / 100.0, low / 100.0, close / 100.0,
+			(long)(100 * (1 + next() % 500)) });
+
+		if (++minute == 390) {
+			minute = 0;
+			day++;
+		}
+	}
+}
+
+CompressionStats benchmarkCandleCompression(size_t bars)
+{
+	std::vector<CandleData> candles;
+	syntheticMinuteBars(bars, candles);
+	return measureCandleCompression(candles);
+}
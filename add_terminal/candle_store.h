@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct CandleData;
+
+// Column-wise bars for one chunk of a CompressedSeries. Fixed arrays so a
+// reader can keep one around and decode chunk after chunk without
+// allocating; at 512 bars the decoded chunk (24 KB) stays in L1/L2.
+struct DecodedBars {
+	static constexpr size_t kCapacity = 512;
+
+	size_t count = 0;
+	int64_t time[kCapacity];        // Unix seconds (dates: midnight UTC)
+	double open[kCapacity];
+	double high[kCapacity];
+	double low[kCapacity];
+	double close[kCapacity];
+	double volume[kCapacity];
+};
+
+// Compressed in-memory candle history.
+//
+// Prices are stored as integer ticks (1/ticksPerUnit). Within a block each
+// bar is encoded relative to the previous one:
+//   time    delta-of-delta (regular bars encode as 0)
+//   open    open - previous close
+//   close   close - open
+//   high    high - max(open, close)        (never negative)
+//   low     min(open, close) - low         (never negative)
+//   volume  volume - previous volume
+// Each field is zigzagged and packed at the narrowest byte width that fits
+// the whole block (0, 1, 2, 4 or 8 bytes), so decode is a widening copy, a
+// few vectorisable element-wise passes and one running sum per field.
+//
+// Times are stored in units of the block's smallest bar spacing (60 for
+// minute bars, 86400 for dailies), so regular bars cost nothing beyond the
+// width of the rare gap.
+//
+// Blocks hold up to kBlockBars bars. New bars go to an uncompressed hot
+// tail that live updates can rewrite in place; the tail is sealed into a
+// block once it holds more than kBlockBars bars, always keeping the newest
+// bar editable.
+class CompressedSeries {
+public:
+	static constexpr size_t kBlockBars = DecodedBars::kCapacity;
+
+	explicit CompressedSeries(int64_t ticksPerUnit = 100);
+
+	// Replaces the contents with candles, on the coarsest tick grid (cents,
+	// else 1/10000) every price sits on, and seals all but the newest bar.
+	// False if a date can't be parsed, bars go back in time or a price is
+	// finer than 1/10000 (e.g. 5-decimal FX): those series aren't compressed.
+	bool assign(const std::vector<CandleData>& candles);
+
+	// Appends a bar, or replaces the newest one if it has the same time.
+	// False for a bar older than the newest or a price off the tick grid
+	// chosen by assign() (a sub-penny bar on a cents series is not rounded);
+	// dates are re-formatted in the style of the first bar.
+	bool append(const CandleData& candle);
+	bool append(int64_t time, double open, double high, double low, double close, double volume);
+	void clear();
+
+	size_t size() const { return m_size; }
+	bool empty() const { return size() == 0; }
+	int64_t ticksPerUnit() const { return m_ticksPerUnit; }
+
+	// Sealed blocks first, then the hot tail as the last chunk
+	size_t chunkCount() const { return m_blocks.size() + (m_tail.empty() ? 0 : 1); }
+	void decodeChunk(size_t chunk, DecodedBars& out) const;
+
+	// Full round trip back to CandleData (dates re-formatted from times)
+	void toCandles(std::vector<CandleData>& out) const;
+	CandleData back() const;                    // Newest bar; series must not be empty
+
+	// Flat image for spilling to disk. load() rejects a short or garbled one.
+	void save(std::string& out) const;
+	bool load(const char* data, size_t size);
+
+	size_t memoryBytes() const;                 // What this series holds
+	static size_t candleBytes(const std::vector<CandleData>& candles);  // Same bars as CandleData
+
+	// IB bar dates: "yyyymmdd", "yyyymmdd hh:mm:ss[ zone]" or epoch seconds
+	static bool parseBarTime(std::string_view date, int64_t& time);
+
+private:
+	struct Block {
+		uint32_t offset;                // Into m_data
+		uint16_t count;
+		uint8_t width[6];               // Bytes per value, per field
+		int64_t firstTime;
+		int64_t timeUnit;               // Seconds per time step
+		int64_t firstDelta;             // Steps from bar 0 to bar 1
+		int64_t firstTick;              // Open of bar 0
+		int64_t firstVolume;            // Volume of bar 0
+	};
+	struct RawBar {
+		int64_t time;
+		int64_t open, high, low, close; // Ticks
+		int64_t volume;
+	};
+
+	int64_t m_ticksPerUnit;
+	size_t m_size = 0;
+	std::vector<Block> m_blocks;
+	std::vector<uint8_t> m_data;        // All sealed blocks, back to back
+	std::vector<RawBar> m_tail;
+
+	// How dates were written, so toCandles() can reproduce them
+	enum class DateStyle : uint8_t { Day, DayTime, Epoch };
+	DateStyle m_dateStyle = DateStyle::Day;
+	std::string m_dateSeparator = " ";  // Between date and time ("  " from older TWS)
+	std::string m_dateSuffix;           // After the time, e.g. " US/Eastern"
+
+	// The out-pointers may be null when only the time is wanted
+	static bool parseDate(std::string_view date, int64_t& time, DateStyle* style,
+		std::string* separator, std::string* suffix);
+	void seal(size_t count);
+	std::pmr::string formatTime(int64_t time) const;
+};
+
+// What a string holds on the heap, e.g. a CandleData date
+size_t stringHeapBytes(const std::string& text);
+size_t stringHeapBytes(const std::pmr::string& text);
+
+// Bars, bytes and timings from benchmarkCandleCompression
+struct CompressionStats {
+	size_t bars = 0;
+	size_t rawBytes = 0;                // As std::vector<CandleData>
+	size_t compressedBytes = 0;
+	double encodeSeconds = 0.0;
+	double decodeSeconds = 0.0;         // Every chunk into DecodedBars
+
+	double ratio() const { return compressedBytes ? (double)rawBytes / compressedBytes : 0.0; }
+};
+
+// Random-walk regular-hours 1-minute bars, dated the way TWS sends them
+void syntheticMinuteBars(size_t bars, std::vector<CandleData>& candles);
+
+// Compresses and decodes syntheticMinuteBars
+CompressionStats benchmarkCandleCompression(size_t bars);
+// Same for real bars (e.g. every loaded chart)
+CompressionStats measureCandleCompression(const std::vector<CandleData>& candles);
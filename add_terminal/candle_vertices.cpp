@@ -0,0 +1,211 @@
+#include "candle_vertices.h"
+#include "candle_store.h"
+#include "event.h"
+#include "profiler.h"
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VERTEX_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t kParallelChunkCandles = 65536;    // Below this a chunk isn't worth a thread
+constexpr float kBodyHalfWidth = 0.3f;
+
+// high and low are loaded together as one SSE2 pair
+static_assert(offsetof(CandleData, low) == offsetof(CandleData, high) + sizeof(double),
+	"CandleData::high and low must be adjacent");
+static_assert(offsetof(CandlePrices, low) == offsetof(CandlePrices, high) + sizeof(double),
+	"CandlePrices::high and low must be adjacent");
+
+struct PriceRange {
+	double low = 1e300;
+	double high = -1e300;
+};
+
+inline float* writeVertex(float* out, float x, float y, float r, float g, float b)
+{
+	out[0] = x;
+	out[1] = y;
+	out[2] = r;
+	out[3] = g;
+	out[4] = b;
+	return out + kFloatsPerVertex;
+}
+
+// Candles [begin, end) into their wick and body slots of vertices
+template <bool Line, typename Candle>
+PriceRange writeCandles(const Candle* candles, size_t begin, size_t end, size_t count, float* vertices)
+{
+	float* wick = vertices + begin * kWickFloats;
+	float* body = vertices + count * kWickFloats + begin * kBodyFloats;
+#ifdef VERTEX_SIMD_SSE2
+	__m128d highs = _mm_set1_pd(-1e300);   // Lane 0 tracks the highest high
+	__m128d lows = _mm_set1_pd(1e300);     // Lane 1 the lowest low
+#else
+	PriceRange range;
+#endif
+	for (size_t i = begin; i < end; i++) {
+		const Candle& candle = candles[i];
+#ifdef VERTEX_SIMD_SSE2
+		__m128d highLow = _mm_loadu_pd(&candle.high);
+		highs = _mm_max_pd(highs, highLow);
+		lows = _mm_min_pd(lows, highLow);
+#else
+		range.low = (std::min)(range.low, candle.low);
+		range.high = (std::max)(range.high, candle.high);
+#endif
+		float o = (float)candle.open;
+		float c = (float)candle.close;
+		float x = (float)i;
+		if constexpr (Line) {
+			wick = writeVertex(wick, i > 0 ? x - 1.0f : x, o, 0.3f, 0.7f, 1.0f);
+			wick = writeVertex(wick, x, c, 0.3f, 0.7f, 1.0f);
+			for (int v = 0; v < 6; v++) body = writeVertex(body, x, c, 0.0f, 0.0f, 0.0f);
+			continue;
+		}
+		float r = (c >= o) ? 0.0f : 1.0f;
+		float g = (c >= o) ? 1.0f : 0.0f;
+		float top = (std::max)(o, c);
+		float bot = (std::min)(o, c);
+
+		wick = writeVertex(wick, x, (float)candle.high, 1.0f, 1.0f, 1.0f);
+		wick = writeVertex(wick, x, (float)candle.low, 1.0f, 1.0f, 1.0f);
+
+		body = writeVertex(body, x - kBodyHalfWidth, bot, r, g, 0.0f);
+		body = writeVertex(body, x + kBodyHalfWidth, bot, r, g, 0.0f);
+		body = writeVertex(body, x + kBodyHalfWidth, top, r, g, 0.0f);
+		body = writeVertex(body, x - kBodyHalfWidth, bot, r, g, 0.0f);
+		body = writeVertex(body, x + kBodyHalfWidth, top, r, g, 0.0f);
+		body = writeVertex(body, x - kBodyHalfWidth, top, r, g, 0.0f);
+	}
+#ifdef VERTEX_SIMD_SSE2
+	PriceRange range;
+	range.high = _mm_cvtsd_f64(highs);
+	range.low = _mm_cvtsd_f64(_mm_unpackhi_pd(lows, lows));
+#endif
+	return range;
+}
+
+// Pool workers plus the calling thread, which works while it waits
+unsigned vertexThreads(size_t count)
+{
+	unsigned threads = TaskScheduler::threadCount() + 1;
+	return (unsigned)(std::min)((size_t)threads, (std::max)((size_t)1, count / kParallelChunkCandles));
+}
+
+// The build this module replaced, kept as the benchmark baseline
+size_t legacyCandleVertices(const std::vector<CandleData>& candles)
+{
+	std::vector<float> wickData;
+	std::vector<float> bodyData;
+	float minPrice = 1e9f;
+	float maxPrice = -1e9f;
+	for (const auto& candle : candles) {
+		minPrice = (std::min)(minPrice, (float)candle.low);
+		maxPrice = (std::max)(maxPrice, (float)candle.high);
+	}
+	int i = 0;
+	for (const auto& candle : candles) {
+		float o = (float)candle.open, h = (float)candle.high, l = (float)candle.low, c = (float)candle.close;
+		float x = (float)i++;
+		float r = (c >= o) ? 0.0f : 1.0f;
+		float g = (c >= o) ? 1.0f : 0.0f;
+		wickData.insert(wickData.end(), { x, h, 1.0f, 1.0f, 1.0f, x, l, 1.0f, 1.0f, 1.0f });
+		float top = (std::max)(o, c), bot = (std::min)(o, c), w = 0.3f;
+		bodyData.insert(bodyData.end(), {
+			x - w, bot, r, g, 0.0f,  x + w, bot, r, g, 0.0f,  x + w, top, r, g, 0.0f,
+			x - w, bot, r, g, 0.0f,  x + w, top, r, g, 0.0f,  x - w, top, r, g, 0.0f
+		});
+	}
+	std::vector<float> totalData = wickData;
+	totalData.insert(totalData.end(), bodyData.begin(), bodyData.end());
+	return totalData.size() + (minPrice <= maxPrice);
+}
+
+template <typename Candle>
+PriceRange writeCandles(CandleStyle style, const Candle* candles, size_t begin, size_t end, size_t count, float* vertices)
+{
+	return style == CandleStyle::Line ? writeCandles<true>(candles, begin, end, count, vertices)
+		: writeCandles<false>(candles, begin, end, count, vertices);
+}
+
+template <typename Candle>
+void buildInto(const Candle* candles, size_t count, float* out, float& minPrice, float& maxPrice, unsigned threads,
+	CandleStyle style = CandleStyle::Candles)
+{
+	minPrice = 1e9f;
+	maxPrice = -1e9f;
+	if (count == 0) return;
+
+	threads = threads == 0 ? vertexThreads(count) : (unsigned)(std::min)((size_t)threads, count);
+	std::vector<PriceRange> parts(threads);
+	TaskGroup jobs;
+	for (unsigned t = 1; t < threads; t++) {
+		jobs.run([=, &parts]() { parts[t] = writeCandles(style, candles, count * t / threads, count * (t + 1) / threads, count, out); });
+	}
+	PriceRange range = writeCandles(style, candles, 0, count / threads, count, out);
+	jobs.wait();
+	for (unsigned t = 1; t < threads; t++) {
+		range.low = (std::min)(range.low, parts[t].low);
+		range.high = (std::max)(range.high, parts[t].high);
+	}
+	minPrice = (float)range.low;
+	maxPrice = (float)range.high;
+}
+
+} // namespace
+
+void buildCandleVertices(const CandleData* candles, size_t count, CandleVertices& out, unsigned threads)
+{
+	PROFILE_ZONE("buildCandleVertices");
+	out.floats = count * kCandleFloats;
+	if (out.capacity < out.floats) {
+		out.data.reset(new float[out.floats]);
+		out.capacity = out.floats;
+	}
+	buildInto(candles, count, out.data.get(), out.minPrice, out.maxPrice, threads);
+}
+
+void buildCandleVertices(const CandlePrices* candles, size_t count, float* out,
+	float& minPrice, float& maxPrice, unsigned threads, CandleStyle style)
+{
+	PROFILE_ZONE("buildCandleVertices");
+	buildInto(candles, count, out, minPrice, maxPrice, threads, style);
+}
+
+VertexBenchmark benchmarkCandleVertices(size_t candles)
+{
+	VertexBenchmark result;
+	std::vector<CandleData> bars;
+	syntheticMinuteBars(candles, bars);
+	result.candles = bars.size();
+	result.threads = vertexThreads(bars.size());
+
+	uint64_t start = 0;
+	if (bars.size() <= 2000000) {
+		start = Profiler::now();
+		legacyCandleVertices(bars);
+		result.legacyMs = (Profiler::now() - start) / 1.0e6;
+	}
+
+	// Fresh buffers each time, so page faults count as they would for a new chart
+	{
+		CandleVertices vertices;
+		start = Profiler::now();
+		buildCandleVertices(bars.data(), bars.size(), vertices, 1);
+		result.serialMs = (Profiler::now() - start) / 1.0e6;
+	}
+	CandleVertices vertices;
+	start = Profiler::now();
+	buildCandleVertices(bars.data(), bars.size(), vertices, result.threads);
+	result.parallelMs = (Profiler::now() - start) / 1.0e6;
+	result.bytes = vertices.bytes();
+	return result;
+}
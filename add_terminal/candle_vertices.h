@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct CandleData;
+
+// Chart vertex layout, 5 floats per vertex (x, y, r, g, b): every wick
+// first (2 vertices per candle, drawn as GL_LINES), then every body (6
+// vertices per candle, GL_TRIANGLES). Candle i sits at x = i.
+constexpr size_t kFloatsPerVertex = 5;
+constexpr size_t kWickFloats = 2 * kFloatsPerVertex;
+constexpr size_t kBodyFloats = 6 * kFloatsPerVertex;
+constexpr size_t kCandleFloats = kWickFloats + kBodyFloats;
+
+struct CandleVertices {
+	std::unique_ptr<float[]> data;      // Left uninitialised; every float gets written
+	size_t floats = 0;
+	size_t capacity = 0;
+	float minPrice = 1e9f;              // Lowest low and highest high
+	float maxPrice = -1e9f;
+
+	size_t candles() const { return floats / kCandleFloats; }
+	size_t bytes() const { return floats * sizeof(float); }
+};
+
+// Candles: a wick from high to low and a body from open to close.
+// Line: the wick slot joins (i - 1, open) to (i, close), so a series whose
+// open is the previous close draws as one polyline; the body is empty.
+enum class CandleStyle : uint8_t { Candles, Line };
+
+// Fills out with one allocation, none if it already has the capacity.
+// Each candle's wick and body are written in place, so long series are
+// split across threads with no merge step; min/max is folded into the
+// same pass with SSE2. threads = 0 picks one per 64k candles, up to the
+// TaskScheduler's workers plus the caller.
+void buildCandleVertices(const CandleData* candles, size_t count, CandleVertices& out, unsigned threads = 0);
+
+// The prices a candle's vertices need, copied out of CandleData so a
+// worker thread can build from them while the bars keep changing
+struct CandlePrices {
+	double open;
+	double high;
+	double low;
+	double close;
+};
+
+// Same build into caller memory of count * kCandleFloats floats, e.g. a
+// mapped GL buffer
+void buildCandleVertices(const CandlePrices* candles, size_t count, float* out,
+	float& minPrice, float& maxPrice, unsigned threads = 0, CandleStyle style = CandleStyle::Candles);
+
+struct VertexBenchmark {
+	size_t candles = 0;
+	unsigned threads = 0;
+	double legacyMs = 0.0;              // Growing wick/body vectors, then concatenating; 0 if skipped
+	double serialMs = 0.0;
+	double parallelMs = 0.0;
+	size_t bytes = 0;                   // Vertex buffer size
+};
+
+// Builds vertices for syntheticMinuteBars(candles). The old insert-based
+// build needs three copies of the buffer, so it is only timed up to 2M.
+VertexBenchmark benchmarkCandleVertices(size_t candles);
@@ -0,0 +1,163 @@
+#include "chart_builds.h"
+#include "profiler.h"
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+ChartBuildQueue::~ChartBuildQueue()
+{
+	for (auto& job : m_jobs) {
+		if (job->stage != Stage::Building) continue;
+		job->work.wait();
+		job->cancelled = true;
+		finish(*job);
+	}
+}
+
+void ChartBuildQueue::request(ChartViewId view, SymbolId symbol, uint64_t revision, Timeframe timeframe,
+	ChartType chartType, std::vector<CandlePrices>&& prices)
+{
+	cancel(view);
+	auto job = std::make_unique<Job>();
+	job->geometry.view = view;
+	job->geometry.symbol = symbol;
+	job->geometry.revision = revision;
+	job->geometry.timeframe = timeframe;
+	job->geometry.chartType = chartType;
+	job->prices = std::move(prices);
+	m_jobs.push_back(std::move(job));
+}
+
+void ChartBuildQueue::cancel(ChartViewId view)
+{
+	for (auto& job : m_jobs) {
+		if (job->geometry.view != view || job->cancelled) continue;
+		job->cancelled = true;
+		m_stats.superseded++;
+	}
+}
+
+bool ChartBuildQueue::pending(ChartViewId view) const
+{
+	return std::any_of(m_jobs.begin(), m_jobs.end(),
+		[view](const auto& job) { return job->geometry.view == view && !job->cancelled; });
+}
+
+void ChartBuildQueue::pump(uint64_t budgetNs, const std::function<void(ChartGeometry&)>& install)
+{
+	PROFILE_ZONE("ChartBuildQueue::pump");
+	const uint64_t startNs = Profiler::now();
+	bool progressed = false;
+	auto withinBudget = [&]() { return !progressed || Profiler::now() - startNs < budgetNs; };
+
+	m_stats.queued = m_stats.building = 0;
+	for (size_t i = 0; i < m_jobs.size();) {
+		Job& job = *m_jobs[i];
+		if (job.stage == Stage::Queued) {
+			if (job.cancelled) {
+				m_jobs.erase(m_jobs.begin() + i);
+				continue;
+			}
+			if (withinBudget()) {
+				start(job);
+				progressed = true;
+			}
+			else {
+				m_stats.queued++;
+			}
+			i++;
+			continue;
+		}
+
+		bool ready = job.work.wait_for(std::chrono::seconds(0)) != std::future_status::timeout;
+		if (!ready || (!job.cancelled && !withinBudget())) {
+			m_stats.building++;
+			i++;
+			continue;
+		}
+		progressed = true;
+		if (!finish(job)) {
+			job.stage = Stage::Queued;     // Mapping was lost (e.g. mode switch), build it again
+			i++;
+			continue;
+		}
+		// Off the queue first, so install() sees the view as no longer pending
+		ChartGeometry geometry = job.geometry;
+		bool cancelled = job.cancelled;
+		m_jobs.erase(m_jobs.begin() + i);
+		if (!cancelled) {
+			install(geometry);
+			m_stats.completed++;
+		}
+	}
+
+	m_stats.lastPumpMs = (Profiler::now() - startNs) / 1.0e6;
+	m_stats.maxPumpMs = (std::max)(m_stats.maxPumpMs, m_stats.lastPumpMs);
+}
+
+void ChartBuildQueue::start(Job& job)
+{
+	ChartGeometry& geometry = job.geometry;
+	const size_t count = job.prices.size();
+	geometry.numCandles = (int)count;
+	geometry.vertexBytes = count * kCandleFloats * sizeof(float);
+	if (count == 0) {
+		job.work = std::async(std::launch::deferred, [] {});
+		job.stage = Stage::Building;
+		return;
+	}
+
+	glGenBuffers(1, &geometry.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, geometry.vbo);
+	glBufferData(GL_ARRAY_BUFFER, geometry.vertexBytes, nullptr, GL_STATIC_DRAW);
+	float* target = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, geometry.vertexBytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (!target) {
+		job.staging.reset(new float[count * kCandleFloats]);
+		target = job.staging.get();
+	}
+
+	Job* building = &job;   // Jobs are heap-allocated, so the address is stable
+	job.work = TaskScheduler::async([building, target]() {
+		buildCandleVertices(building->prices.data(), building->prices.size(), target,
+			building->geometry.minPrice, building->geometry.maxPrice, 0, candleStyle(building->geometry.chartType));
+	}, TaskPriority::High);     // Someone is looking at a placeholder
+	job.stage = Stage::Building;
+}
+
+bool ChartBuildQueue::finish(Job& job)
+{
+	ChartGeometry& geometry = job.geometry;
+	job.work.get();
+	if (geometry.vbo == 0) return true;     // No candles
+
+	glBindBuffer(GL_ARRAY_BUFFER, geometry.vbo);
+	bool uploaded = true;
+	if (job.staging) {
+		if (!job.cancelled) glBufferSubData(GL_ARRAY_BUFFER, 0, geometry.vertexBytes, job.staging.get());
+		job.staging.reset();
+	}
+	else {
+		uploaded = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+	}
+
+	if (job.cancelled || !uploaded) {
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &geometry.vbo);
+		geometry.vbo = 0;
+		return job.cancelled || uploaded;
+	}
+
+	glGenVertexArrays(1, &geometry.vao);
+	glBindVertexArray(geometry.vao);
+	// Position (x, y) then colour (r, g, b)
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, kFloatsPerVertex * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, kFloatsPerVertex * sizeof(float), (void*)(2 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return true;
+}
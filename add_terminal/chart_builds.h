@@ -0,0 +1,86 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include "candle_vertices.h"
+#include "chart_types.h"
+#include "resample.h"
+#include "symbols.h"
+
+// The Renderer's key for one chart window. A symbol can have several,
+// each with its own timeframe and chart type over the same base bars.
+using ChartViewId = uint32_t;
+
+// A chart's uploaded vertex buffer, ready to draw
+struct ChartGeometry {
+	ChartViewId view = 0;               // Who it's for
+	SymbolId symbol = kNoSymbol;
+	uint64_t revision = 0;              // ChartData::revision it was built from
+	Timeframe timeframe = Timeframe::M15;
+	ChartType chartType = ChartType::Candles;
+	GLuint vao = 0;
+	GLuint vbo = 0;
+	int numCandles = 0;
+	float minPrice = 1e9f;
+	float maxPrice = -1e9f;
+	size_t vertexBytes = 0;
+};
+
+struct ChartBuildStats {
+	size_t queued = 0;                  // Waiting for pump() to map a buffer
+	size_t building = 0;                // Worker writing into the mapping
+	uint64_t completed = 0;
+	uint64_t superseded = 0;            // Replaced by a newer request before finishing
+	double lastPumpMs = 0.0;            // UI thread time spent in pump()
+	double maxPumpMs = 0.0;
+};
+
+// Builds chart geometry over several frames so a new chart never stalls one:
+//
+//   1. request() copies the prices out of the bars (UI thread)
+//   2. pump() allocates the VBO at full size and maps it; a worker thread
+//      then writes the vertices straight into the mapping
+//   3. a later pump() unmaps it, sets up the VAO and hands the geometry to
+//      its install callback
+//
+// GL calls stay on the UI thread. pump() starts no more GL work once its
+// budget is spent (it always makes one step of progress), so a page of
+// grid tiles appearing at once is spread over frames. A newer request for
+// a view supersedes the older one, whose buffer is dropped once its
+// worker is done with it.
+class ChartBuildQueue {
+public:
+	// Waits for the workers and unmaps what they wrote into, so the GL
+	// context must still be current (App::stop, before main tears it down)
+	~ChartBuildQueue();
+
+	void request(ChartViewId view, SymbolId symbol, uint64_t revision, Timeframe timeframe,
+		ChartType chartType, std::vector<CandlePrices>&& prices);
+	void cancel(ChartViewId view);
+	bool pending(ChartViewId view) const;
+
+	void pump(uint64_t budgetNs, const std::function<void(ChartGeometry&)>& install);
+	const ChartBuildStats& stats() const { return m_stats; }
+
+private:
+	enum class Stage { Queued, Building };
+
+	struct Job {
+		ChartGeometry geometry;
+		std::vector<CandlePrices> prices;
+		Stage stage = Stage::Queued;
+		bool cancelled = false;
+		std::unique_ptr<float[]> staging;   // Only if the driver wouldn't map the buffer
+		std::future<void> work;
+	};
+
+	std::vector<std::unique_ptr<Job>> m_jobs;   // Oldest first
+	ChartBuildStats m_stats;
+
+	void start(Job& job);
+	bool finish(Job& job);              // False if the upload was lost and must be redone
+};
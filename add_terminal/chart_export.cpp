@@ -0,0 +1,146 @@
+// Headless chart pack exporter.
+//
+//   chart_export --data <dir> --out <dir> [--symbols <file> | --list AAPL,MSFT]
+//                [--width 800] [--height 500] [--bars 120] [--threads N]
+//
+// Reads <dir>/<SYMBOL>.json (Polygon aggregates format), rasterizes each
+// chart on the CPU and writes <out>/<SYMBOL>.png. No GPU or display needed.
+
+#include "raster.h"
+#include "polygon_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct ExportOptions {
+    std::string dataDir = ".";
+    std::string outDir = ".";
+    std::vector<std::string> symbols;
+    int width = 800;
+    int height = 500;
+    int bars = 120;
+    int threads = 0;    // 0 = hardware_concurrency
+};
+
+void printUsage()
+{
+    printf("Usage: chart_export --data <dir> --out <dir> [--symbols <file> | --list A,B,C]\n"
+           "                    [--width 800] [--height 500] [--bars 120] [--threads N]\n");
+}
+
+void addSymbols(std::vector<std::string>& symbols, std::istream& in, char separator)
+{
+    std::string symbol;
+    while (std::getline(in, symbol, separator)) {
+        symbol.erase(0, symbol.find_first_not_of(" \t\r\n"));
+        symbol.erase(symbol.find_last_not_of(" \t\r\n") + 1);
+        if (!symbol.empty()) symbols.push_back(symbol);
+    }
+}
+
+bool parseArgs(int argc, char** argv, ExportOptions& options)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printf("Missing value for %s\n", arg.c_str());
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--data") options.dataDir = value;
+        else if (arg == "--out") options.outDir = value;
+        else if (arg == "--width") options.width = std::stoi(value);
+        else if (arg == "--height") options.height = std::stoi(value);
+        else if (arg == "--bars") options.bars = std::stoi(value);
+        else if (arg == "--threads") options.threads = std::stoi(value);
+        else if (arg == "--list") {
+            std::istringstream in(value);
+            addSymbols(options.symbols, in, ',');
+        }
+        else if (arg == "--symbols") {
+            std::ifstream in(value);
+            if (!in.is_open()) {
+                printf("Cannot open symbol list %s\n", value.c_str());
+                return false;
+            }
+            addSymbols(options.symbols, in, '\n');
+        }
+        else {
+            printf("Unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return !options.symbols.empty() && options.width > 0 && options.height > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ExportOptions options;
+    try {
+        if (!parseArgs(argc, argv, options)) {
+            printUsage();
+            return 1;
+        }
+    }
+    catch (const std::exception&) {
+        printUsage();
+        return 1;
+    }
+
+    int threadCount = options.threads > 0 ? options.threads : (int)std::thread::hardware_concurrency();
+    threadCount = (std::max)(1, (std::min)(threadCount, (int)options.symbols.size()));
+
+    std::atomic<size_t> nextSymbol{ 0 };
+    std::atomic<int> written{ 0 };
+    std::atomic<int> failed{ 0 };
+    auto start = std::chrono::steady_clock::now();
+
+    // Each worker keeps its own candle and pixel buffers across symbols
+    auto worker = [&]() {
+        std::vector<CandleData> candles;
+        RasterImage image;
+        image.resize(options.width, options.height);
+
+        for (size_t i = nextSymbol++; i < options.symbols.size(); i = nextSymbol++) {
+            const std::string& symbol = options.symbols[i];
+            if (!Polygon_io::loadCandles(options.dataDir + "/" + symbol + ".json", candles)) {
+                printf("Skipping %s: no data\n", symbol.c_str());
+                failed++;
+                continue;
+            }
+            rasterizeChart(candles, options.bars, image);
+            if (writePng(options.outDir + "/" + symbol + ".png", image)) {
+                written++;
+            }
+            else {
+                printf("Failed to write %s.png\n", symbol.c_str());
+                failed++;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Exported %d charts (%d failed) in %.2f s on %d threads (%.1f charts/s)\n",
+           written.load(), failed.load(), seconds, threadCount, seconds > 0 ? written / seconds : 0.0);
+    return failed > 0 ? 2 : 0;
+}
@@ -0,0 +1,236 @@
+#include "chart_types.h"
+#include "DataManager.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr size_t kAppendHeadroom = 4096;
+
+// Average true range over the whole source, rounded down to 1, 2, 2.5 or 5
+// times a power of ten. Averaging over everything rather than the last few
+// bars keeps the brick count near the bar count whatever the history did.
+double boxSizeFor(const std::vector<CandleData>& source)
+{
+	if (source.empty()) return 0.0;
+	double total = source[0].high - source[0].low;
+	for (size_t i = 1; i < source.size(); i++) {
+		const CandleData& bar = source[i];
+		double previousClose = source[i - 1].close;
+		total += (std::max)(bar.high, previousClose) - (std::min)(bar.low, previousClose);
+	}
+	double range = total / source.size();
+	if (!(range > 0.0)) range = (std::max)(std::abs(source.back().close) * 0.001, 0.01);
+
+	double power = std::pow(10.0, std::floor(std::log10(range)));
+	double mantissa = range / power;
+	double step = mantissa >= 5.0 ? 5.0 : mantissa >= 2.5 ? 2.5 : mantissa >= 2.0 ? 2.0 : 1.0;
+	return step * power;
+}
+
+} // namespace
+
+const char* chartTypeName(ChartType type)
+{
+	switch (type) {
+	case ChartType::Candles: return "Candles";
+	case ChartType::HeikinAshi: return "Heikin-Ashi";
+	case ChartType::Renko: return "Renko";
+	case ChartType::Range: return "Range";
+	case ChartType::Line: return "Line";
+	default: return "?";
+	}
+}
+
+void DerivedSeries::update(const std::vector<CandleData>& source, uint64_t revision)
+{
+	if (m_built && revision == m_revision) return;
+	m_revision = revision;
+
+	// Incremental only if everything before the last source bar is as it was
+	bool incremental = m_built && m_lastSource < source.size() &&
+		source[m_lastSource].date == m_lastSourceDate && source.front().date == m_firstDate;
+	if (!incremental) {
+		rebuild(source);
+		return;
+	}
+
+	PROFILE_ZONE("DerivedSeries::update");
+	m_bars.resize(m_barsBefore);
+	if (!m_bars.empty()) m_bars.back() = m_lastBefore;
+	foldFrom(source, m_lastSource);
+}
+
+void DerivedSeries::rebuild(const std::vector<CandleData>& source)
+{
+	PROFILE_ZONE("DerivedSeries::rebuild");
+	m_bars.clear();
+	m_built = true;
+	m_lastSource = 0;
+	m_lastSourceDate.clear();
+	m_barsBefore = 0;
+	m_firstDate.clear();
+	if (source.empty()) return;
+
+	m_firstDate = source.front().date;
+	m_boxSize = (m_type == ChartType::Renko || m_type == ChartType::Range) ? boxSizeFor(source) : 0.0;
+	if (m_type == ChartType::Renko) m_anchor = std::floor(source.front().close / m_boxSize) * m_boxSize;
+	// Room for a session of live bars, so the first append doesn't copy everything
+	m_bars.reserve((m_type == ChartType::Range ? source.size() * 2 : source.size()) + kAppendHeadroom);
+	foldFrom(source, 0);
+}
+
+void DerivedSeries::foldFrom(const std::vector<CandleData>& source, size_t begin)
+{
+	for (size_t i = begin; i < source.size(); i++) {
+		if (i + 1 == source.size()) {
+			m_lastSource = i;
+			m_lastSourceDate = source[i].date;
+			m_barsBefore = m_bars.size();
+			if (!m_bars.empty()) m_lastBefore = m_bars.back();
+		}
+		fold(source[i], i > 0 ? &source[i - 1] : nullptr);
+	}
+}
+
+void DerivedSeries::fold(const CandleData& bar, const CandleData* previous)
+{
+	switch (m_type) {
+	case ChartType::HeikinAshi: {
+		double close = (bar.open + bar.high + bar.low + bar.close) * 0.25;
+		double open = m_bars.empty() ? (bar.open + bar.close) * 0.5 : (m_bars.back().open + m_bars.back().close) * 0.5;
+		m_bars.push_back({ open, (std::max)({ bar.high, open, close }), (std::min)({ bar.low, open, close }), close });
+		break;
+	}
+	case ChartType::Renko: {
+		double top = m_anchor;
+		double bottom = m_anchor;
+		if (!m_bars.empty()) {
+			top = (std::max)(m_bars.back().open, m_bars.back().close);
+			bottom = (std::min)(m_bars.back().open, m_bars.back().close);
+		}
+		const double box = m_boxSize;
+		while (bar.close >= top + box) {
+			m_bars.push_back({ top, top + box, top, top + box });
+			bottom = top;
+			top += box;
+		}
+		while (bar.close <= bottom - box) {
+			m_bars.push_back({ bottom, bottom, bottom - box, bottom - box });
+			top = bottom;
+			bottom -= box;
+		}
+		break;
+	}
+	case ChartType::Range: {
+		if (m_bars.empty()) m_bars.push_back({ bar.open, bar.open, bar.open, bar.open });
+		// The nearer extreme is taken to have come first
+		bool lowFirst = bar.open - bar.low < bar.high - bar.open;
+		foldRangePrice(bar.open);
+		foldRangePrice(lowFirst ? bar.low : bar.high);
+		foldRangePrice(lowFirst ? bar.high : bar.low);
+		foldRangePrice(bar.close);
+		break;
+	}
+	case ChartType::Line: {
+		double open = previous ? previous->close : bar.close;
+		m_bars.push_back({ open, (std::max)(open, bar.close), (std::min)(open, bar.close), bar.close });
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+// Walks the forming range bar (m_bars.back()) to price, closing it off
+// each time it spans a full box
+void DerivedSeries::foldRangePrice(double price)
+{
+	const double box = m_boxSize;
+	while (price > m_bars.back().low + box) {
+		CandlePrices& forming = m_bars.back();
+		double top = forming.low + box;
+		forming.high = forming.close = top;
+		m_bars.push_back({ top, top, top, top });
+	}
+	while (price < m_bars.back().high - box) {
+		CandlePrices& forming = m_bars.back();
+		double bottom = forming.high - box;
+		forming.low = forming.close = bottom;
+		m_bars.push_back({ bottom, bottom, bottom, bottom });
+	}
+	CandlePrices& forming = m_bars.back();
+	forming.high = (std::max)(forming.high, price);
+	forming.low = (std::min)(forming.low, price);
+	forming.close = price;
+}
+
+void DerivedSeries::clear()
+{
+	m_bars = std::vector<CandlePrices>();
+	m_built = false;
+	m_lastSourceDate.clear();
+	m_firstDate.clear();
+}
+
+DerivedSeries& ChartTypeCache::series(ChartType type, Timeframe timeframe)
+{
+	for (DerivedSeries& series : m_series) {
+		if (series.type() == type && series.timeframe() == timeframe) return series;
+	}
+	return m_series.emplace_back(type, timeframe);
+}
+
+size_t ChartTypeCache::bytes() const
+{
+	size_t total = m_series.capacity() * sizeof(DerivedSeries);
+	for (const DerivedSeries& series : m_series) total += series.bytes();
+	return total;
+}
+
+void ChartTypeCache::clear()
+{
+	std::vector<DerivedSeries>().swap(m_series);
+}
+
+const std::vector<CandlePrices>& chartTypeBars(DataManager& dataManager, SymbolId symbol,
+	Timeframe timeframe, ChartType type)
+{
+	const std::vector<CandleData>& source = timeframeBars(dataManager, symbol, timeframe);
+	ChartData& chart = dataManager.charts[symbol];
+	DerivedSeries& series = chart.chartTypes.series(type, timeframe);
+	series.update(source, chart.revision);
+	return series.bars();
+}
+
+ChartTypeBenchmark benchmarkChartTypes(size_t baseBars)
+{
+	const int kAppends = 100;
+	ChartTypeBenchmark result;
+	std::vector<CandleData> base;
+	syntheticMinuteBars(baseBars + kAppends, base);
+	std::vector<CandleData> appends(base.end() - kAppends, base.end());
+	base.resize(baseBars);
+	result.baseBars = base.size();
+
+	ChartTypeCache cache;
+	uint64_t revision = 1;
+	for (size_t type = 1; type < kChartTypeCount; type++) {
+		uint64_t start = Profiler::now();
+		cache.series((ChartType)type, Timeframe::M1).update(base, revision);
+		result.materialiseMs[type] = (Profiler::now() - start) / 1.0e6;
+	}
+
+	uint64_t start = Profiler::now();
+	for (const CandleData& bar : appends) {
+		base.push_back(bar);
+		revision++;
+		for (size_t type = 1; type < kChartTypeCount; type++) {
+			cache.series((ChartType)type, Timeframe::M1).update(base, revision);
+		}
+	}
+	result.appendUs = (Profiler::now() - start) / 1.0e3 / kAppends;
+	return result;
+}
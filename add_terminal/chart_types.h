@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "candle_vertices.h"
+#include "resample.h"
+#include "symbols.h"
+
+struct CandleData;
+class DataManager;
+
+// How a chart's bars are drawn. Everything but Candles is derived from the
+// timeframe's bars, see chartTypeBars().
+enum class ChartType : uint8_t { Candles, HeikinAshi, Renko, Range, Line, Count };
+constexpr size_t kChartTypeCount = (size_t)ChartType::Count;
+
+const char* chartTypeName(ChartType type);
+
+// Line charts use the candle layout: the wick slot is the segment from the
+// previous close, the body is left empty
+inline CandleStyle candleStyle(ChartType type)
+{
+	return type == ChartType::Line ? CandleStyle::Line : CandleStyle::Candles;
+}
+
+struct ChartTypeBenchmark {
+	size_t baseBars = 0;
+	double materialiseMs[kChartTypeCount] = {};   // First display, from scratch
+	double appendUs = 0.0;              // One new bar, every derived type
+};
+
+// One chart type of one timeframe, as prices ready for buildCandleVertices().
+//
+//   Heikin-Ashi  one bar per source bar, smoothed: close is the OHLC mean,
+//                open the midpoint of the previous Heikin-Ashi body
+//   Renko        a brick each time the close moves a box beyond the last
+//                brick, two boxes to reverse; no time axis, no wicks
+//   Range        a new bar each time high - low reaches the box size, the
+//                price walked open, nearer extreme, farther extreme, close
+//   Line         the closes; open is the previous close
+//
+// Renko and range bars need a box size: the source's average true range,
+// rounded to a 1/2/2.5/5 step, fixed when the series is built from scratch.
+//
+// Like ResampledSeries, update() is incremental: the state before the last
+// source bar is kept, so an append or a rewritten live bar only refolds
+// that bar and anything after it. Each bar depends on the one before, so
+// a rebuild is a single linear pass; it happens the first time a chart is
+// shown as this type and when the source changed anywhere but at its end.
+class DerivedSeries {
+public:
+	DerivedSeries(ChartType type, Timeframe timeframe) : m_type(type), m_timeframe(timeframe) {}
+
+	// No-op while revision (ChartData::revision) is unchanged
+	void update(const std::vector<CandleData>& source, uint64_t revision);
+	void clear();
+
+	ChartType type() const { return m_type; }
+	Timeframe timeframe() const { return m_timeframe; }
+	const std::vector<CandlePrices>& bars() const { return m_bars; }
+	double boxSize() const { return m_boxSize; }    // Renko and range bars, 0 until built
+	size_t bytes() const { return m_bars.capacity() * sizeof(CandlePrices); }
+
+private:
+	ChartType m_type;
+	Timeframe m_timeframe;
+	std::vector<CandlePrices> m_bars;
+	bool m_built = false;
+	uint64_t m_revision = 0;
+	double m_boxSize = 0.0;
+	double m_anchor = 0.0;              // Renko grid origin
+	std::pmr::string m_firstDate;
+
+	// State before the last source bar was folded in
+	size_t m_lastSource = 0;
+	std::pmr::string m_lastSourceDate;
+	size_t m_barsBefore = 0;
+	CandlePrices m_lastBefore{};        // m_bars.back() then (a range bar still forming)
+
+	void rebuild(const std::vector<CandleData>& source);
+	void foldFrom(const std::vector<CandleData>& source, size_t begin);
+	void fold(const CandleData& bar, const CandleData* previous);
+	void foldRangePrice(double price);
+};
+
+// The derived series a chart has been shown as, each created the first
+// time it is asked for. References from series() stay valid until the
+// next call.
+class ChartTypeCache {
+public:
+	DerivedSeries& series(ChartType type, Timeframe timeframe);
+	size_t bytes() const;
+	void clear();                       // Frees them all; they rebuild when next shown
+
+private:
+	std::vector<DerivedSeries> m_series;
+};
+
+// A chart's bars at a timeframe drawn as type (not Candles): resampled and
+// derived as needed, see timeframeBars()
+const std::vector<CandlePrices>& chartTypeBars(DataManager& dataManager, SymbolId symbol,
+	Timeframe timeframe, ChartType type);
+
+// Derives every chart type from a synthetic 1-minute series from scratch,
+// then appends bars one at a time
+ChartTypeBenchmark benchmarkChartTypes(size_t baseBars);
@@ -1,6 +1,7 @@
 #pragma once
 #include <variant>
 #include <string>
+#include "symbols.h"
 
 struct StartScannerCommand {
     int reqId;
@@ -20,7 +21,7 @@ struct DisconnectCommand {
 
 struct RequestHistoricalDataCommand {
     int reqId;
-    std::string symbol;
+    SymbolId symbol;
     std::string endDateTime;    // Format: "20230101 23:59:59" or empty for now
     std::string durationStr;    // "1 D", "1 W", "1 M", "1 Y"
     std::string barSizeSetting; // "1 min", "5 mins", "1 hour", "1 day"
@@ -28,14 +29,104 @@ struct RequestHistoricalDataCommand {
     int useRTH;                 // 1 = regular trading hours only, 0 = all hours
 };
 
+struct CancelHistoricalDataCommand {
+    int reqId;
+};
+
+// reqHistoricalTicks: trades from startDateTime on. IB sends at most 1000
+// a request (plus the rest of the last second) and can't cancel one.
+struct RequestHistoricalTicksCommand {
+    int reqId;
+    SymbolId symbol;
+    std::string startDateTime;  // "20230101-13:30:00" (UTC) or "20230101 04:00:00 US/Eastern"
+    int numberOfTicks = 1000;
+    int useRTH = 0;
+};
+
+// One-shot lookups; see ib_requests.h
+struct RequestContractDetailsCommand {
+    int reqId;
+    SymbolId symbol;
+};
+
+// reqMktData with snapshot=true: one set of ticks, then tickSnapshotEnd
+struct RequestSnapshotCommand {
+    int reqId;
+    SymbolId symbol;
+};
+
+struct CancelSnapshotCommand {
+    int reqId;
+};
+
 struct RequestAccountDataCommand {
     std::string accountCode;    // Account code, or empty for all accounts
 };
 
+struct SubscribeMarketDepthCommand {
+    int reqId;
+    SymbolId symbol;
+    int numRows;                // Rows per side
+    bool isSmartDepth;          // Aggregate across exchanges (L2 via updateMktDepthL2)
+};
+
+struct CancelMarketDepthCommand {
+    int reqId;
+    bool isSmartDepth;
+};
+
+struct SubscribeTickByTickCommand {
+    int reqId;
+    SymbolId symbol;
+};
+
+struct CancelTickByTickCommand {
+    int reqId;
+};
+
+// Streaming top-of-book quote (reqMktData) for a watchlist row
+struct SubscribeQuotesCommand {
+    int reqId;
+    SymbolId symbol;
+};
+
+struct CancelQuotesCommand {
+    int reqId;
+};
+
+// Orders come from a validated OrderTemplate; the IB thread does no checks
+struct PlaceOrderCommand {
+    int orderId;                // From IbkrClient::nextOrderId()
+    SymbolId symbol;
+    std::string action;         // BUY / SELL
+    std::string orderType;      // MKT / LMT
+    double quantity;
+    double limitPrice;          // LMT only
+    std::string tif;
+    bool outsideRth;
+};
+
+struct CancelOrderCommand {
+    int orderId;
+};
+
 using Command = std::variant<
     StartScannerCommand,
     CancelScannerCommand,
     RequestHistoricalDataCommand,
+    CancelHistoricalDataCommand,
+    RequestHistoricalTicksCommand,
+    RequestContractDetailsCommand,
+    RequestSnapshotCommand,
+    CancelSnapshotCommand,
     RequestAccountDataCommand,
+    SubscribeMarketDepthCommand,
+    CancelMarketDepthCommand,
+    SubscribeTickByTickCommand,
+    CancelTickByTickCommand,
+    SubscribeQuotesCommand,
+    CancelQuotesCommand,
+    PlaceOrderCommand,
+    CancelOrderCommand,
     DisconnectCommand
 >;
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "connection_pool.h"
+#include "ibkr.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <variant>
+
+struct ConnectionPool::Connection {
+	std::unique_ptr<IbkrClient> client;
+	std::thread thread;
+	std::string threadName;
+	int clientId = 0;
+	Role role = Role::Primary;
+	std::atomic<bool> alive{ true };
+	int subscriptions = 0;          // UI thread only
+};
+
+ConnectionPool::ConnectionPool() = default;
+
+ConnectionPool::~ConnectionPool()
+{
+	stop();
+}
+
+void ConnectionPool::start(const std::string& host, int port, int baseClientId, int count)
+{
+	count = (std::max)(1, (std::min)(count, 32));
+
+	for (int i = 0; i < count; ++i) {
+		auto conn = std::make_unique<Connection>();
+		conn->clientId = baseClientId + i;
+		conn->role = i == 0 ? Role::Primary : i == 1 ? Role::History : Role::MarketData;
+		conn->client = std::make_unique<IbkrClient>(host, port, conn->clientId);
+		conn->threadName = "IB " + std::to_string(i) + " (" + roleName(conn->role) + ")";
+		m_connections.push_back(std::move(conn));
+	}
+	m_consumedCounts.assign(m_connections.size(), 0);
+
+	// Threads start once the vector is final; each only touches its own entry
+	for (auto& conn : m_connections) {
+		Connection* c = conn.get();
+		c->thread = std::thread([c]() {
+			Profiler::setThreadName(c->threadName.c_str());
+			c->client->processLoop();
+			c->alive = false;
+			printf("IB connection clientId:%d (%s) stopped\n", c->clientId, roleName(c->role));
+		});
+	}
+}
+
+void ConnectionPool::stop()
+{
+	for (auto& conn : m_connections) {
+		if (conn->alive) conn->client->pushCommand(DisconnectCommand{});
+	}
+	for (auto& conn : m_connections) {
+		if (conn->thread.joinable()) {
+			printf("Waiting for IB thread clientId:%d to finish...\n", conn->clientId);
+			conn->thread.join();
+		}
+	}
+}
+
+bool ConnectionPool::streamEnded(int reqId)
+{
+	auto it = m_streamConnection.find(reqId);
+	if (it == m_streamConnection.end()) return false;
+	m_connections[it->second]->subscriptions--;
+	m_streamConnection.erase(it);
+	return true;
+}
+
+const char* ConnectionPool::roleName(Role role)
+{
+	switch (role) {
+	case Role::Primary:    return "primary";
+	case Role::History:    return "history";
+	case Role::MarketData: return "market data";
+	}
+	return "";
+}
+
+ConnectionPool::ConnectionInfo ConnectionPool::info(size_t index) const
+{
+	const Connection& conn = *m_connections[index];
+	return { conn.clientId, conn.role, conn.alive.load(), conn.subscriptions };
+}
+
+size_t ConnectionPool::liveOr(size_t index) const
+{
+	return m_connections[index]->alive ? index : 0;
+}
+
+// Connection with the fewest live streams among those holding `role`, or
+// the primary when no such connection is up
+size_t ConnectionPool::leastLoaded(Role role) const
+{
+	size_t best = 0;
+	int bestLoad = -1;
+	for (size_t i = 0; i < m_connections.size(); ++i) {
+		const Connection& conn = *m_connections[i];
+		if (conn.role != role || !conn.alive) continue;
+		if (bestLoad < 0 || conn.subscriptions < bestLoad) {
+			best = i;
+			bestLoad = conn.subscriptions;
+		}
+	}
+	return best;
+}
+
+size_t ConnectionPool::route(const Command& command)
+{
+	return std::visit([this](auto&& arg) -> size_t {
+		using T = std::decay_t<decltype(arg)>;
+
+		// One-shot requests and their cancels; with a single history
+		// connection the cancel always follows its request
+		if constexpr (std::is_same_v<T, RequestHistoricalDataCommand> ||
+		              std::is_same_v<T, CancelHistoricalDataCommand> ||
+		              std::is_same_v<T, RequestHistoricalTicksCommand> ||
+		              std::is_same_v<T, RequestContractDetailsCommand> ||
+		              std::is_same_v<T, RequestSnapshotCommand> ||
+		              std::is_same_v<T, CancelSnapshotCommand>) {
+			return leastLoaded(Role::History);
+		}
+		else if constexpr (std::is_same_v<T, SubscribeMarketDepthCommand> ||
+		                   std::is_same_v<T, SubscribeTickByTickCommand> ||
+		                   std::is_same_v<T, SubscribeQuotesCommand>) {
+			size_t index = leastLoaded(Role::MarketData);
+			m_connections[index]->subscriptions++;
+			m_streamConnection[arg.reqId] = index;
+			return index;
+		}
+		else if constexpr (std::is_same_v<T, CancelMarketDepthCommand> ||
+		                   std::is_same_v<T, CancelTickByTickCommand> ||
+		                   std::is_same_v<T, CancelQuotesCommand>) {
+			auto it = m_streamConnection.find(arg.reqId);
+			if (it == m_streamConnection.end()) return 0;
+			size_t index = it->second;
+			m_connections[index]->subscriptions--;
+			m_streamConnection.erase(it);
+			return liveOr(index);
+		}
+		else {
+			return 0;
+		}
+	}, command);
+}
+
+void ConnectionPool::pushCommand(Command command)
+{
+	if (m_connections.empty()) return;
+
+	if (std::holds_alternative<DisconnectCommand>(command)) {
+		for (auto& conn : m_connections) {
+			conn->client->pushCommand(command);
+		}
+		return;
+	}
+	m_connections[route(command)]->client->pushCommand(std::move(command));
+}
+
+void ConnectionPool::submitOrder(PlaceOrderCommand command)
+{
+	m_connections[0]->client->submitOrder(std::move(command));
+}
+
+void ConnectionPool::sendCancelOrder(CancelOrderCommand command)
+{
+	m_connections[0]->client->sendCancelOrder(command);
+}
+
+int ConnectionPool::nextOrderId()
+{
+	return m_connections[0]->client->nextOrderId();
+}
+
+std::vector<std::unique_ptr<EventBatch>> ConnectionPool::consumeEvents()
+{
+	std::vector<std::unique_ptr<EventBatch>> merged;
+	for (size_t i = 0; i < m_connections.size(); ++i) {
+		std::vector<std::unique_ptr<EventBatch>> batches = m_connections[i]->client->consumeEvents();
+		m_consumedCounts[i] = batches.size();
+		if (merged.empty()) {
+			merged = std::move(batches);
+		}
+		else {
+			for (auto& batch : batches) merged.push_back(std::move(batch));
+		}
+	}
+	return merged;
+}
+
+// Batches are still in consumeEvents() order, so the counts say which
+// connection each run of batches goes back to
+void ConnectionPool::recycleEvents(std::vector<std::unique_ptr<EventBatch>>& batches)
+{
+	size_t next = 0;
+	for (size_t i = 0; i < m_connections.size() && next < batches.size(); ++i) {
+		size_t end = (std::min)(next + m_consumedCounts[i], batches.size());
+		for (; next < end; ++next) {
+			m_recycleScratch.push_back(std::move(batches[next]));
+		}
+		m_connections[i]->client->recycleEvents(m_recycleScratch);
+	}
+	batches.clear();
+	std::fill(m_consumedCounts.begin(), m_consumedCounts.end(), 0);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "command.h"
+#include "event_batch.h"
+
+class IbkrClient;
+
+// Spreads IB traffic over several IbkrClient connections, each with its own
+// clientId (base, base+1, ...) and its own IB thread.
+//
+//   connection 0      primary: orders, account, scanner
+//   connection 1      history: historical backfills, contract details and
+//                     snapshots, so a large download never queues in front
+//                     of live ticks on the same socket
+//   connection 2..N-1 market data: depth, tick-by-tick and watchlist quotes,
+//                     each subscription on the least loaded connection
+//
+// With fewer connections the roles fold onto the lower indices, so a pool of
+// one behaves exactly like the single client it replaces. Commands for a
+// connection whose loop has exited fall back to the primary.
+class ConnectionPool {
+public:
+	enum class Role { Primary, History, MarketData };
+
+	struct ConnectionInfo {
+		int clientId;
+		Role role;
+		bool alive;             // IB loop still running
+		int subscriptions;      // Live market data streams routed here
+	};
+
+	ConnectionPool();
+	~ConnectionPool();
+	ConnectionPool(const ConnectionPool&) = delete;
+	ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+	// Create `count` clients and start their IB threads (clamped to 1..32,
+	// the TWS limit on API clients)
+	void start(const std::string& host, int port, int baseClientId, int count);
+	// Disconnect every client and join its thread
+	void stop();
+
+	void pushCommand(Command command);
+	// A stream TWS rejected: stop counting it against its connection. False
+	// if reqId isn't a routed stream.
+	bool streamEnded(int reqId);
+
+	// Order fast path and order ids always use the primary connection: TWS
+	// only reports an order's status to the client that placed it.
+	void submitOrder(PlaceOrderCommand command);
+	void sendCancelOrder(CancelOrderCommand command);
+	int nextOrderId();
+
+	// Merged event stream. Batches keep their per-connection order; there
+	// is no ordering between connections. Pass the same vector back to
+	// recycleEvents() once it has been handled.
+	std::vector<std::unique_ptr<EventBatch>> consumeEvents();
+	void recycleEvents(std::vector<std::unique_ptr<EventBatch>>& batches);
+
+	size_t size() const { return m_connections.size(); }
+	ConnectionInfo info(size_t index) const;
+
+	static const char* roleName(Role role);
+
+private:
+	struct Connection;   // Client, thread and routing state; see the .cpp
+	std::vector<std::unique_ptr<Connection>> m_connections;
+
+	// UI thread only: which connection each live stream was sent to, so the
+	// cancel follows it
+	std::unordered_map<int, size_t> m_streamConnection;
+
+	// Batches taken from each connection by the last consumeEvents()
+	std::vector<size_t> m_consumedCounts;
+	std::vector<std::unique_ptr<EventBatch>> m_recycleScratch;
+
+	size_t route(const Command& command);
+	size_t liveOr(size_t index) const;
+	size_t leastLoaded(Role role) const;
+};
@@ -0,0 +1,101 @@
+#include "contracts.h"
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+struct CacheState {
+	std::shared_mutex mutex;
+	std::unordered_map<SymbolId, ContractInfo> contracts;
+	bool dirty = false;
+	std::atomic<uint64_t> hits{ 0 };
+	std::atomic<uint64_t> misses{ 0 };
+};
+
+CacheState& cache()
+{
+	static CacheState s;
+	return s;
+}
+
+} // namespace
+
+bool ContractCache::find(SymbolId symbol, ContractInfo& out)
+{
+	CacheState& c = cache();
+	{
+		std::shared_lock<std::shared_mutex> lock(c.mutex);
+		auto it = c.contracts.find(symbol);
+		if (it != c.contracts.end()) {
+			out = it->second;
+			c.hits++;
+			return true;
+		}
+	}
+	c.misses++;
+	return false;
+}
+
+bool ContractCache::contains(SymbolId symbol)
+{
+	CacheState& c = cache();
+	std::shared_lock<std::shared_mutex> lock(c.mutex);
+	return c.contracts.count(symbol) > 0;
+}
+
+void ContractCache::store(SymbolId symbol, const ContractInfo& info)
+{
+	if (symbol == kNoSymbol || info.conId == 0) return;
+	SymbolTable::bindConId(symbol, info.conId);
+	CacheState& c = cache();
+	std::unique_lock<std::shared_mutex> lock(c.mutex);
+	c.contracts[symbol] = info;
+	c.dirty = true;
+}
+
+void ContractCache::learn(SymbolId symbol, const ContractInfo& info)
+{
+	if (symbol == kNoSymbol || info.conId == 0) return;
+	SymbolTable::bindConId(symbol, info.conId);
+	CacheState& c = cache();
+	std::unique_lock<std::shared_mutex> lock(c.mutex);
+	if (c.contracts.try_emplace(symbol, info).second) c.dirty = true;
+}
+
+std::vector<std::pair<SymbolId, ContractInfo>> ContractCache::entries()
+{
+	CacheState& c = cache();
+	std::shared_lock<std::shared_mutex> lock(c.mutex);
+	return std::vector<std::pair<SymbolId, ContractInfo>>(c.contracts.begin(), c.contracts.end());
+}
+
+bool ContractCache::dirty()
+{
+	CacheState& c = cache();
+	std::shared_lock<std::shared_mutex> lock(c.mutex);
+	return c.dirty;
+}
+
+void ContractCache::markSaved()
+{
+	CacheState& c = cache();
+	std::unique_lock<std::shared_mutex> lock(c.mutex);
+	c.dirty = false;
+}
+
+ContractCacheStats ContractCache::stats()
+{
+	CacheState& c = cache();
+	ContractCacheStats stats;
+	{
+		std::shared_lock<std::shared_mutex> lock(c.mutex);
+		stats.entries = c.contracts.size();
+		for (const auto& [symbol, info] : c.contracts) stats.complete += info.minTick > 0.0;
+	}
+	stats.hits = c.hits;
+	stats.misses = c.misses;
+	return stats;
+}
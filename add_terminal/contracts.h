@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "symbols.h"
+
+// What IB needs to address an instrument without looking it up again
+struct ContractInfo {
+	long conId = 0;
+	std::string secType;                // STK, FUT, CASH, ...
+	std::string currency;
+	std::string exchange;               // Routing exchange (SMART where IB allows it)
+	std::string primaryExchange;        // Listing exchange, e.g. NASDAQ
+	double minTick = 0.0;               // 0 until contract details have been seen
+	std::string longName;
+};
+
+struct ContractCacheStats {
+	size_t entries = 0;
+	size_t complete = 0;                // With contract details (min tick known)
+	uint64_t hits = 0;                  // find() answered from the cache
+	uint64_t misses = 0;
+};
+
+// Process-wide conId cache, keyed by symbol.
+//
+// Filled from every callback that hands us a contract: contract details
+// (complete), scanner rows and portfolio updates (conId, type and currency
+// only, and only for stocks, since other types are named by their
+// underlying). Once a symbol is in here every request for it is sent by
+// conId, so TWS does no symbol lookup, nothing is ambiguous, and
+// instruments that are not US stocks work without a resolve round trip. Persisted across
+// runs, see saveContractCache() in snapshot.h.
+//
+// Safe from any thread; the IB threads read it for every command.
+class ContractCache {
+public:
+	static bool find(SymbolId symbol, ContractInfo& out);
+	static bool contains(SymbolId symbol);
+	// From contract details: replaces whatever was known
+	static void store(SymbolId symbol, const ContractInfo& info);
+	// From a partial contract: only fills a symbol not yet known
+	static void learn(SymbolId symbol, const ContractInfo& info);
+
+	static std::vector<std::pair<SymbolId, ContractInfo>> entries();
+	static bool dirty();                // Changed since the last markSaved()
+	static void markSaved();
+	static ContractCacheStats stats();
+};
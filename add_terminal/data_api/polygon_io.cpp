@@ -51,3 +51,36 @@ void Polygon_io::readfile() {
     }
 }
 
+bool Polygon_io::loadCandles(const std::string& filename, std::vector<CandleData>& candles)
+{
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        return false;
+    }
+
+    try {
+        json data = json::parse(inFile);
+        if (!data.contains("results") || !data["results"].is_array()) {
+            return false;
+        }
+
+        const auto& results = data["results"];
+        candles.clear();
+        candles.reserve(results.size());
+        for (const auto& bar : results) {
+            CandleData candle;
+            candle.date = bar.contains("t") ? formatTimestamp(bar["t"].get<long long>()) : "";
+            candle.open = bar["o"].get<double>();
+            candle.high = bar["h"].get<double>();
+            candle.low = bar["l"].get<double>();
+            candle.close = bar["c"].get<double>();
+            candle.volume = bar.contains("v") ? (long)bar["v"].get<double>() : 0;
+            candles.push_back(candle);
+        }
+        return true;
+    }
+    catch (const json::exception& e) {
+        std::cerr << "Failed to parse " << filename << ": " << e.what() << std::endl;
+        return false;
+    }
+}
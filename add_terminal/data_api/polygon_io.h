@@ -4,14 +4,18 @@
 
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <vector>
+#include "event.h"
 using json = nlohmann::json;
 
 class Polygon_io
 {
 
     private:
-        std::string formatTimestamp(long long ms); 
+        static std::string formatTimestamp(long long ms); 
     public:
         void readfile();
+        // Load a Polygon aggregates file ({"results":[{t,o,h,l,c,v}...]})
+        static bool loadCandles(const std::string& filename, std::vector<CandleData>& candles);
 };
 
@@ -1,13 +1,27 @@
 #pragma once
+#include <cstdint>
+#include <memory_resource>
 #include <variant>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include "contracts.h"
+#include "orderbook.h"
+#include "symbols.h"
+#include "tape.h"
+#include "watchlist.h"
 
+// Payload containers are std::pmr so the IB thread can build them in the
+// current EventBatch arena (see event_batch.h). Copies out of an event
+// (e.g. into DataManager) fall back to the default heap, so nothing the UI
+// keeps points into an arena. Never move a payload container out of an event.
+// Strings that outgrow the small-string buffer (bar dates, exec ids, reject
+// reasons) are std::pmr too and must be constructed with the arena: assigning
+// to a member built with the default resource copies to the heap.
 
 struct ScannerResultItem {
 	int rank;
-	std::string symbol;
+	SymbolId symbol;
 	std::string secType;
 	std::string currency;
 	long conId;
@@ -16,7 +30,7 @@ struct ScannerResultItem {
 struct ScannerResult
 {
 	int reqId;
-	std::vector<ScannerResultItem> items;
+	std::pmr::vector<ScannerResultItem> items;
 };
 
 struct TickPrice
@@ -25,14 +39,40 @@ struct TickPrice
 	double price;
 };
 
+// From orderStatus, openOrder, or an order rejection in error()
 struct OrderStatus
 {
+	OrderStatus() = default;
+	explicit OrderStatus(std::pmr::memory_resource* resource) : status(resource), message(resource) {}
+
+	int orderId;
+	std::pmr::string status;
+	SymbolId symbol = kNoSymbol; // Only known from openOrder
+	double filled = 0.0;
+	double remaining = 0.0;
+	double avgFillPrice = 0.0;
+	std::pmr::string message;   // whyHeld, or the reject reason
+	uint64_t recvNs = 0;        // Profiler::now() when the IB thread received it
+};
+
+struct ExecutionEvent
+{
+	ExecutionEvent() = default;
+	explicit ExecutionEvent(std::pmr::memory_resource* resource) : execId(resource), side(resource) {}
+
 	int orderId;
-	std::string status;
+	std::pmr::string execId;
+	SymbolId symbol;
+	std::pmr::string side;
+	double shares;
+	double price;
+	double cumQty;
+	double avgPrice;
+	uint64_t recvNs = 0;
 };
 
 struct CandleData {
-	std::string date;  // Or use time_t
+	std::pmr::string date;  // "20240102 09:30:00" is past the small-string limit
 	double open;
 	double high;
 	double low;
@@ -40,24 +80,60 @@ struct CandleData {
 	long volume;
 };
 
+// Empty candles mean the request failed (see IbkrClient::error)
 struct HistoricalDataEvent {
 	int reqId;
-	std::string symbol;
-	std::vector<CandleData> candles;
+	SymbolId symbol;
+	std::pmr::vector<CandleData> candles;
+};
+
+// Answer to a RequestHistoricalTicksCommand, oldest first
+struct HistoricalTicksEvent {
+	int reqId;
+	SymbolId symbol;
+	std::pmr::vector<TradePrint> prints;
+};
+
+// Answer to a RequestContractDetailsCommand (the first match; a plain US
+// stock symbol has one). Already in the ContractCache when it arrives.
+struct ContractDetailsEvent {
+	int reqId;
+	SymbolId symbol;
+	ContractInfo contract;
+};
+
+// Answer to a RequestSnapshotCommand; 0 for fields TWS did not send
+struct SnapshotEvent {
+	int reqId;
+	SymbolId symbol;
+	double bid = 0.0;
+	double ask = 0.0;
+	double last = 0.0;
+	double close = 0.0;
+	double volume = 0.0;
+};
+
+// A one-shot request (contract details, snapshot, scanner) or a stream
+// (depth, tick-by-tick, quotes) that TWS rejected. Historical requests
+// report failure as an empty HistoricalDataEvent instead.
+struct RequestErrorEvent {
+	int reqId;
+	int code;
+	std::string message;
 };
 
 // Account value update (e.g., NetLiquidation, AvailableFunds, etc.)
 struct AccountValueUpdate {
-	std::string key;        // "NetLiquidation", "TotalCashValue", etc.
-	std::string value;      // The value as string
-	std::string currency;   // "USD", "EUR", etc.
-	std::string accountName;
+	std::pmr::string key;       // "NetLiquidation", "TotalCashValue", etc.
+	std::pmr::string value;     // The value as string
+	std::pmr::string currency;  // "USD", "EUR", etc.
+	std::pmr::string accountName;
 };
 
 // Position update (holdings in account)
 struct PositionUpdate {
 	std::string account;
-	std::string symbol;
+	SymbolId symbol;
 	std::string secType;
 	double position;        // Number of shares/contracts
 	double marketPrice;     // Current market price
@@ -69,16 +145,53 @@ struct PositionUpdate {
 
 // Account summary event
 struct AccountSummaryEvent {
-	std::unordered_map<std::string, AccountValueUpdate> accountValues;
-	std::vector<PositionUpdate> positions;
+	std::pmr::vector<AccountValueUpdate> accountValues;
+	std::pmr::vector<PositionUpdate> positions;
+};
+
+// Depth updates for one subscription, batched per IB message cycle
+struct MarketDepthEvent {
+	int reqId;
+	SymbolId symbol;
+	std::pmr::vector<DepthUpdate> updates;
+};
+
+// Tick-by-tick trades for one subscription, batched like depth
+struct TradePrintEvent {
+	int reqId;
+	SymbolId symbol;
+	std::pmr::vector<TradePrint> prints;
+};
+
+// Watchlist quote ticks from every subscription, batched per message cycle
+struct QuoteEvent {
+	std::pmr::vector<QuoteTick> ticks;
+};
+
+// A connection came up or dropped. Sent by the IB thread that owns it.
+struct ConnectionEvent {
+	int clientId;
+	bool connected;
+	int attempts = 0;               // Connect attempts it took (connected only)
+	uint64_t outageNs = 0;          // Lost -> back up; 0 for the first connect and for drops
+	std::pmr::vector<int> replayed; // reqIds of subscriptions replayed on reconnect
 };
 
 using EventData = std::variant<
 	ScannerResult,
 	TickPrice,
 	OrderStatus,
+	ExecutionEvent,
 	HistoricalDataEvent,
-	AccountSummaryEvent
+	HistoricalTicksEvent,
+	ContractDetailsEvent,
+	SnapshotEvent,
+	RequestErrorEvent,
+	AccountSummaryEvent,
+	MarketDepthEvent,
+	TradePrintEvent,
+	QuoteEvent,
+	ConnectionEvent
 >;
 
 struct Event
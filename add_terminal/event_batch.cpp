@@ -0,0 +1,157 @@
+#include "event_batch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment)
+{
+	m_allocations++;
+	m_bytes += bytes;
+	return m_upstream->allocate(bytes, alignment);
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	m_upstream->deallocate(p, bytes, alignment);
+}
+
+EventBatch::EventBatch(size_t initialBytes)
+	: m_buffer(new std::byte[initialBytes])
+	, m_bufferSize(initialBytes)
+{
+	m_arena.emplace(m_buffer.get(), m_bufferSize, &m_upstream);
+}
+
+void EventBatch::reset()
+{
+	events.clear();     // Payload destructors return nothing to a monotonic arena
+
+	// The last cycle spilled to the heap: grow the buffer to cover it
+	size_t needed = m_bufferSize + (size_t)m_upstream.bytes();
+	m_arena.reset();
+	if (needed > m_bufferSize) {
+		m_bufferSize = needed + needed / 2;
+		m_buffer.reset(new std::byte[m_bufferSize]);
+	}
+	m_upstream.resetCounts();
+	m_arena.emplace(m_buffer.get(), m_bufferSize, &m_upstream);
+}
+
+namespace {
+
+// One cycle of a busy session: a depth burst, a tape burst, a few order
+// updates and a fill, and now and then a scanner refresh, account lines and
+// a page of bars. Exec ids, bar dates and some account keys are longer than
+// the small-string buffer, as they are from TWS.
+template <typename Push>
+void buildCycle(size_t cycle, std::pmr::memory_resource* resource, Push&& push)
+{
+	MarketDepthEvent depth{ 1, 1, std::pmr::vector<DepthUpdate>(resource) };
+	for (int i = 0; i < 20; i++) {
+		depth.updates.push_back(DepthUpdate{ i % 10, 1, i & 1, 100.0 + i * 0.01, 100.0 * i });
+	}
+	push(Event{ std::move(depth) });
+
+	TradePrintEvent tape{ 2, 1, std::pmr::vector<TradePrint>(resource) };
+	for (int i = 0; i < 50; i++) {
+		tape.prints.push_back(TradePrint{ (int64_t)cycle, 100.0 + (i % 5) * 0.01, 100.0, 0, "ARCA" });
+	}
+	push(Event{ std::move(tape) });
+
+	for (int i = 0; i < 4; i++) {
+		OrderStatus status(resource);
+		status.orderId = i;
+		status.status = "Submitted";
+		push(Event{ std::move(status) });
+	}
+
+	ExecutionEvent fill(resource);
+	fill.orderId = 1;
+	fill.execId = "0000e0d5.65b2e1a4.01.01";
+	fill.symbol = 1;
+	fill.side = "BOT";
+	fill.shares = fill.cumQty = 100.0;
+	fill.price = fill.avgPrice = 100.0;
+	push(Event{ std::move(fill) });
+
+	if (cycle % 10 == 0) {
+		ScannerResult scan{ 3, std::pmr::vector<ScannerResultItem>(resource) };
+		for (int i = 0; i < 50; i++) {
+			scan.items.push_back(ScannerResultItem{ i, (SymbolId)i, "STK", "USD", 1000L + i });
+		}
+		push(Event{ std::move(scan) });
+
+		AccountSummaryEvent account{ std::pmr::vector<AccountValueUpdate>(resource),
+			std::pmr::vector<PositionUpdate>(resource) };
+		account.positions.push_back(PositionUpdate{ "U1", 1, "STK", 100, 10, 1000, 9, 100, 0 });
+		for (const char* key : { "NetLiquidation", "AvailableFunds", "FullExcessLiquidity", "LookAheadInitMarginReq" }) {
+			account.accountValues.push_back(AccountValueUpdate{ std::pmr::string(key, resource),
+				std::pmr::string("104250.37", resource), std::pmr::string("USD", resource),
+				std::pmr::string("DU1234567", resource) });
+		}
+		push(Event{ std::move(account) });
+
+		HistoricalDataEvent bars{ 4, 1, std::pmr::vector<CandleData>(resource) };
+		char date[32];
+		for (int i = 0; i < 100; i++) {
+			snprintf(date, sizeof(date), "20240102 %02d:%02d:00", 9 + (30 + i) / 60, (30 + i) % 60);
+			bars.candles.push_back(CandleData{ std::pmr::string(date, resource), 100.0, 100.1, 99.9, 100.0, 1000 });
+		}
+		push(Event{ std::move(bars) });
+	}
+}
+
+// Stand-in for App::handleEvent: touch every payload
+size_t consume(const Event& event)
+{
+	return std::visit([](auto&& arg) -> size_t {
+		using T = std::decay_t<decltype(arg)>;
+		if constexpr (std::is_same_v<T, MarketDepthEvent>) return arg.updates.size();
+		else if constexpr (std::is_same_v<T, TradePrintEvent>) return arg.prints.size();
+		else if constexpr (std::is_same_v<T, ScannerResult>) return arg.items.size();
+		else if constexpr (std::is_same_v<T, HistoricalDataEvent>) return arg.candles.size() + arg.candles.back().date.size();
+		else if constexpr (std::is_same_v<T, ExecutionEvent>) return arg.execId.size();
+		else return 1;
+	}, event.data);
+}
+
+} // namespace
+
+void benchmarkEventAllocations(size_t cycles, EventAllocStats& heap, EventAllocStats& arena)
+{
+	size_t checksum = 0;
+
+	// Before: payloads and queue nodes straight from the heap, the way
+	// std::vector / std::queue<Event> did it
+	{
+		CountingResource counter;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t cycle = 0; cycle < cycles; cycle++) {
+			std::pmr::deque<Event> queue(&counter);
+			buildCycle(cycle, &counter, [&](Event&& e) { queue.push_back(std::move(e)); });
+			for (const Event& e : queue) checksum += consume(e);
+		}
+		heap.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		heap.allocations = counter.allocations();
+	}
+
+	// After: two batches ping-ponging between producer and consumer
+	{
+		EventBatch batches[2];
+		uint64_t allocations = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t cycle = 0; cycle < cycles; cycle++) {
+			EventBatch& batch = batches[cycle & 1];
+			size_t capacity = batch.events.capacity();
+			buildCycle(cycle, batch.resource(), [&](Event&& e) { batch.events.push_back(std::move(e)); });
+			for (const Event& e : batch.events) checksum += consume(e);
+			allocations += batch.overflowAllocations() + (batch.events.capacity() != capacity ? 1 : 0);
+			batch.reset();
+		}
+		arena.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		arena.allocations = allocations;
+	}
+
+	if (checksum == 0) printf("benchmarkEventAllocations: empty workload\n");
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+#include "event.h"
+
+// Counts what reaches the upstream resource, i.e. real heap allocations
+class CountingResource : public std::pmr::memory_resource {
+public:
+	explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+		: m_upstream(upstream) {}
+
+	uint64_t allocations() const { return m_allocations; }
+	uint64_t bytes() const { return m_bytes; }
+	void resetCounts() { m_allocations = m_bytes = 0; }
+
+private:
+	std::pmr::memory_resource* m_upstream;
+	uint64_t m_allocations = 0;
+	uint64_t m_bytes = 0;
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// One IB message cycle's worth of events plus the arena their payloads
+// live in.
+//
+// The IB thread builds payloads with resource() and appends events; the
+// batch is then handed to the UI whole. After App::update has handled the
+// events, reset() drops them and rewinds the arena in one step. The arena
+// starts from an owned buffer that grows to the largest cycle seen, so in
+// steady state a cycle makes no heap allocations at all.
+class EventBatch {
+public:
+	explicit EventBatch(size_t initialBytes = 64 * 1024);
+
+	std::pmr::memory_resource* resource() { return &*m_arena; }
+	std::vector<Event> events;          // Capacity is kept across resets
+
+	void reset();
+
+	// Heap allocations the arena needed beyond its buffer since the last reset
+	uint64_t overflowAllocations() const { return m_upstream.allocations(); }
+
+private:
+	std::unique_ptr<std::byte[]> m_buffer;
+	size_t m_bufferSize;
+	CountingResource m_upstream;
+	std::optional<std::pmr::monotonic_buffer_resource> m_arena;
+};
+
+struct EventAllocStats {
+	uint64_t allocations = 0;           // Heap allocations, all cycles
+	double seconds = 0.0;
+};
+
+// Build, queue and drain `cycles` synthetic streaming cycles (depth, tape,
+// order status, executions, scanner, account and historical bar events)
+// twice: once with every payload and queue node on the heap, as before
+// batching, and once through a recycled EventBatch.
+void benchmarkEventAllocations(size_t cycles, EventAllocStats& heap, EventAllocStats& arena);
@@ -0,0 +1,746 @@
+#include "expression.h"
+#include "event.h"
+#include "candle_store.h"
+
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EXPR_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+SeriesColumns SeriesColumns::fromCandles(const std::vector<CandleData>& candles)
+{
+    SeriesColumns cols;
+    size_t n = candles.size();
+    cols.open.resize(n);
+    cols.high.resize(n);
+    cols.low.resize(n);
+    cols.close.resize(n);
+    cols.volume.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        cols.open[i] = candles[i].open;
+        cols.high[i] = candles[i].high;
+        cols.low[i] = candles[i].low;
+        cols.close[i] = candles[i].close;
+        cols.volume[i] = (double)candles[i].volume;
+    }
+    return cols;
+}
+
+SeriesColumns SeriesColumns::fromSeries(const CompressedSeries& series)
+{
+    SeriesColumns cols;
+    size_t n = series.size();
+    cols.open.resize(n);
+    cols.high.resize(n);
+    cols.low.resize(n);
+    cols.close.resize(n);
+    cols.volume.resize(n);
+
+    auto bars = std::make_unique<DecodedBars>();
+    size_t at = 0;
+    for (size_t chunk = 0; chunk < series.chunkCount(); chunk++) {
+        series.decodeChunk(chunk, *bars);
+        std::copy_n(bars->open, bars->count, cols.open.begin() + at);
+        std::copy_n(bars->high, bars->count, cols.high.begin() + at);
+        std::copy_n(bars->low, bars->count, cols.low.begin() + at);
+        std::copy_n(bars->close, bars->count, cols.close.begin() + at);
+        std::copy_n(bars->volume, bars->count, cols.volume.begin() + at);
+        at += bars->count;
+    }
+    return cols;
+}
+
+namespace {
+
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+enum ColumnId { COL_OPEN, COL_HIGH, COL_LOW, COL_CLOSE, COL_VOLUME };
+
+const std::vector<double>& columnRef(const SeriesColumns& cols, int id)
+{
+    switch (id) {
+    case COL_OPEN:   return cols.open;
+    case COL_HIGH:   return cols.high;
+    case COL_LOW:    return cols.low;
+    case COL_VOLUME: return cols.volume;
+    default:         return cols.close;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Parser: recursive descent straight into a typed AST
+// ---------------------------------------------------------------------------
+
+struct Token {
+    enum Kind { End, Number, Ident, Op, LParen, RParen, Comma } kind = End;
+    std::string text;
+    double number = 0.0;
+    size_t pos = 0;
+};
+
+class Parser {
+public:
+    explicit Parser(const std::string& src) : m_src(src) { next(); }
+
+    std::unique_ptr<ExprNode> parse(std::string& error)
+    {
+        auto node = parseOr();
+        if (node && m_tok.kind != Token::End) {
+            fail("unexpected '" + m_tok.text + "'");
+        }
+        if (!m_error.empty()) {
+            error = m_error;
+            return nullptr;
+        }
+        return node;
+    }
+
+private:
+    const std::string& m_src;
+    size_t m_pos = 0;
+    Token m_tok;
+    std::string m_error;
+
+    void fail(const std::string& msg)
+    {
+        if (m_error.empty()) {
+            m_error = msg + " at column " + std::to_string(m_tok.pos + 1);
+        }
+    }
+
+    void next()
+    {
+        while (m_pos < m_src.size() && std::isspace((unsigned char)m_src[m_pos])) m_pos++;
+        m_tok = Token();
+        m_tok.pos = m_pos;
+        if (m_pos >= m_src.size()) return;
+
+        char c = m_src[m_pos];
+        if (std::isdigit((unsigned char)c) || c == '.') {
+            size_t len = 0;
+            try {
+                m_tok.number = std::stod(m_src.substr(m_pos), &len);
+            } catch (...) {
+                len = 1;
+                m_tok.number = 0.0;
+                fail("malformed number");
+            }
+            m_tok.kind = Token::Number;
+            m_tok.text = m_src.substr(m_pos, len);
+            m_pos += len;
+        }
+        else if (std::isalpha((unsigned char)c) || c == '_') {
+            size_t start = m_pos;
+            while (m_pos < m_src.size() && (std::isalnum((unsigned char)m_src[m_pos]) || m_src[m_pos] == '_')) m_pos++;
+            m_tok.kind = Token::Ident;
+            m_tok.text = m_src.substr(start, m_pos - start);
+            std::transform(m_tok.text.begin(), m_tok.text.end(), m_tok.text.begin(),
+                [](unsigned char ch) { return (char)std::tolower(ch); });
+        }
+        else if (c == '(') { m_tok.kind = Token::LParen; m_tok.text = "("; m_pos++; }
+        else if (c == ')') { m_tok.kind = Token::RParen; m_tok.text = ")"; m_pos++; }
+        else if (c == ',') { m_tok.kind = Token::Comma; m_tok.text = ","; m_pos++; }
+        else {
+            static const char* twoChar[] = { ">=", "<=", "==", "!=", "&&", "||" };
+            m_tok.kind = Token::Op;
+            for (const char* op : twoChar) {
+                if (m_src.compare(m_pos, 2, op) == 0) {
+                    m_tok.text = op;
+                    m_pos += 2;
+                    return;
+                }
+            }
+            m_tok.text = std::string(1, c);
+            m_pos++;
+        }
+    }
+
+    bool isOp(const char* op) const { return m_tok.kind == Token::Op && m_tok.text == op; }
+    bool isWord(const char* word) const { return m_tok.kind == Token::Ident && m_tok.text == word; }
+
+    static std::unique_ptr<ExprNode> makeNode(ExprOp op, ExprType type,
+        std::unique_ptr<ExprNode> lhs = nullptr, std::unique_ptr<ExprNode> rhs = nullptr)
+    {
+        auto node = std::make_unique<ExprNode>();
+        node->op = op;
+        node->type = type;
+        node->lhs = std::move(lhs);
+        node->rhs = std::move(rhs);
+        return node;
+    }
+
+    bool expect(std::unique_ptr<ExprNode>& node, ExprType type, const char* what)
+    {
+        if (!node) return false;
+        if (node->type != type) {
+            fail(std::string(what) + (type == ExprType::Bool ? " expects a condition" : " expects a number"));
+            return false;
+        }
+        return true;
+    }
+
+    std::unique_ptr<ExprNode> parseOr()
+    {
+        auto lhs = parseAnd();
+        while (lhs && (isWord("or") || isOp("||"))) {
+            next();
+            auto rhs = parseAnd();
+            if (!expect(lhs, ExprType::Bool, "'or'") || !expect(rhs, ExprType::Bool, "'or'")) return nullptr;
+            lhs = makeNode(ExprOp::Or, ExprType::Bool, std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<ExprNode> parseAnd()
+    {
+        auto lhs = parseNot();
+        while (lhs && (isWord("and") || isOp("&&"))) {
+            next();
+            auto rhs = parseNot();
+            if (!expect(lhs, ExprType::Bool, "'and'") || !expect(rhs, ExprType::Bool, "'and'")) return nullptr;
+            lhs = makeNode(ExprOp::And, ExprType::Bool, std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<ExprNode> parseNot()
+    {
+        if (isWord("not") || isOp("!")) {
+            next();
+            auto operand = parseNot();
+            if (!expect(operand, ExprType::Bool, "'not'")) return nullptr;
+            return makeNode(ExprOp::Not, ExprType::Bool, std::move(operand));
+        }
+        return parseComparison();
+    }
+
+    std::unique_ptr<ExprNode> parseComparison()
+    {
+        auto lhs = parseAdditive();
+        if (!lhs) return nullptr;
+
+        ExprOp op;
+        if (isOp(">")) op = ExprOp::Greater;
+        else if (isOp(">=")) op = ExprOp::GreaterEq;
+        else if (isOp("<")) op = ExprOp::Less;
+        else if (isOp("<=")) op = ExprOp::LessEq;
+        else if (isOp("==") || isOp("=")) op = ExprOp::Equal;
+        else if (isOp("!=")) op = ExprOp::NotEqual;
+        else return lhs;
+
+        next();
+        auto rhs = parseAdditive();
+        if (!expect(lhs, ExprType::Number, "comparison") || !expect(rhs, ExprType::Number, "comparison")) return nullptr;
+        return makeNode(op, ExprType::Bool, std::move(lhs), std::move(rhs));
+    }
+
+    std::unique_ptr<ExprNode> parseAdditive()
+    {
+        auto lhs = parseMultiplicative();
+        while (lhs && (isOp("+") || isOp("-"))) {
+            ExprOp op = isOp("+") ? ExprOp::Add : ExprOp::Sub;
+            next();
+            auto rhs = parseMultiplicative();
+            if (!expect(lhs, ExprType::Number, "arithmetic") || !expect(rhs, ExprType::Number, "arithmetic")) return nullptr;
+            lhs = makeNode(op, ExprType::Number, std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<ExprNode> parseMultiplicative()
+    {
+        auto lhs = parseUnary();
+        while (lhs && (isOp("*") || isOp("/"))) {
+            ExprOp op = isOp("*") ? ExprOp::Mul : ExprOp::Div;
+            next();
+            auto rhs = parseUnary();
+            if (!expect(lhs, ExprType::Number, "arithmetic") || !expect(rhs, ExprType::Number, "arithmetic")) return nullptr;
+            lhs = makeNode(op, ExprType::Number, std::move(lhs), std::move(rhs));
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<ExprNode> parseUnary()
+    {
+        if (isOp("-")) {
+            next();
+            auto operand = parseUnary();
+            if (!expect(operand, ExprType::Number, "'-'")) return nullptr;
+            return makeNode(ExprOp::Neg, ExprType::Number, std::move(operand));
+        }
+        return parsePrimary();
+    }
+
+    static bool dependsOnColumns(const ExprNode* node)
+    {
+        if (!node) return false;
+        if (node->op == ExprOp::Column) return true;
+        return dependsOnColumns(node->lhs.get()) || dependsOnColumns(node->rhs.get());
+    }
+
+    std::unique_ptr<ExprNode> parsePrimary()
+    {
+        if (m_tok.kind == Token::Number) {
+            auto node = makeNode(ExprOp::Constant, ExprType::Number);
+            node->value = m_tok.number;
+            next();
+            return node;
+        }
+        if (m_tok.kind == Token::LParen) {
+            next();
+            auto inner = parseOr();
+            if (!inner) return nullptr;
+            if (m_tok.kind != Token::RParen) { fail("expected ')'"); return nullptr; }
+            next();
+            return inner;
+        }
+        if (m_tok.kind != Token::Ident) {
+            fail(m_tok.kind == Token::End ? "unexpected end of expression" : "unexpected '" + m_tok.text + "'");
+            return nullptr;
+        }
+
+        std::string name = m_tok.text;
+        static const struct { const char* name; int id; } columns[] = {
+            { "open", COL_OPEN }, { "high", COL_HIGH }, { "low", COL_LOW },
+            { "close", COL_CLOSE }, { "volume", COL_VOLUME }
+        };
+        for (const auto& col : columns) {
+            if (name == col.name) {
+                next();
+                auto node = makeNode(ExprOp::Column, ExprType::Number);
+                node->column = col.id;
+                return node;
+            }
+        }
+
+        static const struct { const char* name; ExprOp op; } functions[] = {
+            { "sma", ExprOp::Sma }, { "ema", ExprOp::Ema }, { "rsi", ExprOp::Rsi },
+            { "highest", ExprOp::Highest }, { "lowest", ExprOp::Lowest }, { "abs", ExprOp::Abs }
+        };
+        for (const auto& fn : functions) {
+            if (name != fn.name) continue;
+            next();
+            if (m_tok.kind != Token::LParen) { fail("expected '(' after " + name); return nullptr; }
+            next();
+
+            std::vector<std::unique_ptr<ExprNode>> args;
+            while (m_tok.kind != Token::RParen) {
+                auto arg = parseOr();
+                if (!arg) return nullptr;
+                args.push_back(std::move(arg));
+                if (m_tok.kind == Token::Comma) next();
+                else if (m_tok.kind != Token::RParen) { fail("expected ',' or ')'"); return nullptr; }
+            }
+            next();
+
+            if (fn.op == ExprOp::Abs) {
+                if (args.size() != 1) { fail("abs takes one argument"); return nullptr; }
+                if (!expect(args[0], ExprType::Number, "abs")) return nullptr;
+                return makeNode(ExprOp::Abs, ExprType::Number, std::move(args[0]));
+            }
+
+            // rsi(14) is shorthand for rsi(close, 14)
+            if (fn.op == ExprOp::Rsi && args.size() == 1) {
+                auto closeNode = makeNode(ExprOp::Column, ExprType::Number);
+                closeNode->column = COL_CLOSE;
+                args.insert(args.begin(), std::move(closeNode));
+            }
+            if (args.size() != 2) { fail(name + " takes (series, length)"); return nullptr; }
+            if (!expect(args[0], ExprType::Number, name.c_str())) return nullptr;
+            if (!dependsOnColumns(args[0].get())) { fail(name + " expects a series argument"); return nullptr; }
+            if (args[1]->op != ExprOp::Constant || args[1]->value < 1.0 || args[1]->value != std::floor(args[1]->value)) {
+                fail(name + " length must be a positive integer");
+                return nullptr;
+            }
+
+            auto node = makeNode(fn.op, ExprType::Number, std::move(args[0]));
+            node->value = args[1]->value;
+            return node;
+        }
+
+        fail("unknown identifier '" + name + "'");
+        return nullptr;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Element-wise kernels. Bool columns hold 0.0 / 1.0 so one set of double
+// kernels covers arithmetic, comparisons and logic. A comparison or logic op
+// with a NaN operand (an indicator still in its lookback) is NaN rather than
+// false, so `not` and `!=` don't turn a missing value into a signal.
+// ---------------------------------------------------------------------------
+
+double truth(bool value, double a, double b)
+{
+    return (std::isnan(a) || std::isnan(b)) ? kNaN : (value ? 1.0 : 0.0);
+}
+
+#ifdef EXPR_SIMD_SSE2
+__m128d truth(__m128d mask, __m128d a, __m128d b)
+{
+    const __m128d unordered = _mm_cmpunord_pd(a, b);
+    return _mm_or_pd(_mm_andnot_pd(unordered, _mm_and_pd(mask, _mm_set1_pd(1.0))),
+        _mm_and_pd(unordered, _mm_set1_pd(kNaN)));
+}
+#endif
+
+#define EXPR_BINARY_OP(Name, scalarExpr, simdExpr)                         \
+    struct Name {                                                          \
+        static double scalar(double a, double b) { return scalarExpr; }    \
+        EXPR_SIMD_BODY(simdExpr)                                           \
+    };
+
+#ifdef EXPR_SIMD_SSE2
+#define EXPR_SIMD_BODY(simdExpr) \
+    static __m128d simd(__m128d a, __m128d b) { return simdExpr; }
+#else
+#define EXPR_SIMD_BODY(simdExpr)
+#endif
+
+EXPR_BINARY_OP(OpAdd, a + b, _mm_add_pd(a, b))
+EXPR_BINARY_OP(OpSub, a - b, _mm_sub_pd(a, b))
+EXPR_BINARY_OP(OpMul, a * b, _mm_mul_pd(a, b))
+EXPR_BINARY_OP(OpDiv, a / b, _mm_div_pd(a, b))
+EXPR_BINARY_OP(OpGt, truth(a > b, a, b), truth(_mm_cmpgt_pd(a, b), a, b))
+EXPR_BINARY_OP(OpGe, truth(a >= b, a, b), truth(_mm_cmpge_pd(a, b), a, b))
+EXPR_BINARY_OP(OpLt, truth(a < b, a, b), truth(_mm_cmplt_pd(a, b), a, b))
+EXPR_BINARY_OP(OpLe, truth(a <= b, a, b), truth(_mm_cmple_pd(a, b), a, b))
+EXPR_BINARY_OP(OpEq, truth(a == b, a, b), truth(_mm_cmpeq_pd(a, b), a, b))
+EXPR_BINARY_OP(OpNe, truth(a != b, a, b), truth(_mm_cmpneq_pd(a, b), a, b))
+EXPR_BINARY_OP(OpAnd, truth(a != 0.0 && b != 0.0, a, b),
+    truth(_mm_and_pd(_mm_cmpneq_pd(a, _mm_setzero_pd()), _mm_cmpneq_pd(b, _mm_setzero_pd())), a, b))
+EXPR_BINARY_OP(OpOr, truth(a != 0.0 || b != 0.0, a, b),
+    truth(_mm_or_pd(_mm_cmpneq_pd(a, _mm_setzero_pd()), _mm_cmpneq_pd(b, _mm_setzero_pd())), a, b))
+
+// A or B may be a broadcast scalar (stride 0)
+template <class Op, bool AScalar, bool BScalar>
+void binaryKernel(const double* a, const double* b, double* out, size_t n)
+{
+    size_t i = 0;
+#ifdef EXPR_SIMD_SSE2
+    const __m128d va = AScalar ? _mm_set1_pd(*a) : _mm_setzero_pd();
+    const __m128d vb = BScalar ? _mm_set1_pd(*b) : _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+        __m128d x = AScalar ? va : _mm_loadu_pd(a + i);
+        __m128d y = BScalar ? vb : _mm_loadu_pd(b + i);
+        _mm_storeu_pd(out + i, Op::simd(x, y));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = Op::scalar(AScalar ? *a : a[i], BScalar ? *b : b[i]);
+    }
+}
+
+template <class Op>
+void runBinary(const double* a, bool aScalar, const double* b, bool bScalar, double* out, size_t n)
+{
+    if (aScalar && bScalar) binaryKernel<Op, true, true>(a, b, out, n);
+    else if (aScalar) binaryKernel<Op, true, false>(a, b, out, n);
+    else if (bScalar) binaryKernel<Op, false, true>(a, b, out, n);
+    else binaryKernel<Op, false, false>(a, b, out, n);
+}
+
+void negKernel(const double* a, double* out, size_t n)
+{
+    size_t i = 0;
+#ifdef EXPR_SIMD_SSE2
+    const __m128d sign = _mm_set1_pd(-0.0);
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_xor_pd(_mm_loadu_pd(a + i), sign));
+#endif
+    for (; i < n; i++) out[i] = -a[i];
+}
+
+void absKernel(const double* a, double* out, size_t n)
+{
+    size_t i = 0;
+#ifdef EXPR_SIMD_SSE2
+    const __m128d sign = _mm_set1_pd(-0.0);
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_andnot_pd(sign, _mm_loadu_pd(a + i)));
+#endif
+    for (; i < n; i++) out[i] = std::fabs(a[i]);
+}
+
+void notKernel(const double* a, double* out, size_t n)
+{
+    size_t i = 0;
+#ifdef EXPR_SIMD_SSE2
+    const __m128d one = _mm_set1_pd(1.0);
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_sub_pd(one, _mm_loadu_pd(a + i)));
+#endif
+    for (; i < n; i++) out[i] = 1.0 - a[i];
+}
+
+// ---------------------------------------------------------------------------
+// Window indicators. These carry state from bar to bar, so they run as one
+// tight sequential pass per column. Leading NaNs (e.g. sma of an sma) are
+// skipped before the window starts filling.
+// ---------------------------------------------------------------------------
+
+size_t firstValid(const double* a, size_t n)
+{
+    size_t i = 0;
+    while (i < n && std::isnan(a[i])) i++;
+    return i;
+}
+
+void smaKernel(const double* a, double* out, size_t n, int window)
+{
+    size_t start = firstValid(a, n);
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        if (i < start) { out[i] = kNaN; continue; }
+        sum += a[i];
+        if (i >= start + window) sum -= a[i - window];
+        out[i] = (i + 1 >= start + window) ? sum / window : kNaN;
+    }
+}
+
+void emaKernel(const double* a, double* out, size_t n, int window)
+{
+    size_t start = firstValid(a, n);
+    const double alpha = 2.0 / (window + 1.0);
+    double sum = 0.0;
+    double ema = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        if (i < start) { out[i] = kNaN; continue; }
+        size_t filled = i - start + 1;
+        if (filled < (size_t)window) {
+            sum += a[i];
+            out[i] = kNaN;
+        }
+        else if (filled == (size_t)window) {
+            // Seed with the simple average of the first window
+            ema = (sum + a[i]) / window;
+            out[i] = ema;
+        }
+        else {
+            ema += alpha * (a[i] - ema);
+            out[i] = ema;
+        }
+    }
+}
+
+// Wilder's RSI
+void rsiKernel(const double* a, double* out, size_t n, int window)
+{
+    size_t start = firstValid(a, n);
+    double avgGain = 0.0;
+    double avgLoss = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        if (i <= start) { out[i] = kNaN; continue; }
+        double change = a[i] - a[i - 1];
+        double gain = change > 0.0 ? change : 0.0;
+        double loss = change < 0.0 ? -change : 0.0;
+        size_t changes = i - start;
+
+        if (changes < (size_t)window) {
+            avgGain += gain;
+            avgLoss += loss;
+            out[i] = kNaN;
+            continue;
+        }
+        if (changes == (size_t)window) {
+            avgGain = (avgGain + gain) / window;
+            avgLoss = (avgLoss + loss) / window;
+        }
+        else {
+            avgGain = (avgGain * (window - 1) + gain) / window;
+            avgLoss = (avgLoss * (window - 1) + loss) / window;
+        }
+        out[i] = (avgLoss == 0.0) ? 100.0 : 100.0 - 100.0 / (1.0 + avgGain / avgLoss);
+    }
+}
+
+// Rolling max/min with a monotonic index deque, O(n) regardless of window
+template <bool Max>
+void extremumKernel(const double* a, double* out, size_t n, int window, std::vector<size_t>& deque)
+{
+    size_t start = firstValid(a, n);
+    deque.resize(n);
+    size_t head = 0, tail = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i < start) { out[i] = kNaN; continue; }
+        while (tail > head && (Max ? a[deque[tail - 1]] <= a[i] : a[deque[tail - 1]] >= a[i])) tail--;
+        deque[tail++] = i;
+        if (deque[head] + window <= i) head++;
+        out[i] = (i + 1 >= start + window) ? a[deque[head]] : kNaN;
+    }
+}
+
+double foldScalar(ExprOp op, double a, double b)
+{
+    switch (op) {
+    case ExprOp::Add:       return OpAdd::scalar(a, b);
+    case ExprOp::Sub:       return OpSub::scalar(a, b);
+    case ExprOp::Mul:       return OpMul::scalar(a, b);
+    case ExprOp::Div:       return OpDiv::scalar(a, b);
+    case ExprOp::Greater:   return OpGt::scalar(a, b);
+    case ExprOp::GreaterEq: return OpGe::scalar(a, b);
+    case ExprOp::Less:      return OpLt::scalar(a, b);
+    case ExprOp::LessEq:    return OpLe::scalar(a, b);
+    case ExprOp::Equal:     return OpEq::scalar(a, b);
+    case ExprOp::NotEqual:  return OpNe::scalar(a, b);
+    case ExprOp::And:       return OpAnd::scalar(a, b);
+    case ExprOp::Or:        return OpOr::scalar(a, b);
+    case ExprOp::Neg:       return -a;
+    case ExprOp::Abs:       return std::fabs(a);
+    case ExprOp::Not:       return 1.0 - a;
+    default:                return a;
+    }
+}
+
+} // namespace
+
+// Lower the AST into a flat post-order instruction list. Constant subtrees
+// are folded here so kernels only ever see column/scalar operands.
+CompiledExpression::Operand CompiledExpression::lower(const ExprNode& node, int& lookback)
+{
+    Operand result;
+    lookback = 0;
+    if (node.op == ExprOp::Constant) {
+        result.kind = Operand::Scalar;
+        result.scalar = node.value;
+        return result;
+    }
+    if (node.op == ExprOp::Column) {
+        result.kind = Operand::Column;
+        result.index = node.column;
+        return result;
+    }
+
+    Instr instr;
+    instr.op = node.op;
+    int lhsLookback = 0;
+    int rhsLookback = 0;
+    instr.a = lower(*node.lhs, lhsLookback);
+    if (node.rhs) instr.b = lower(*node.rhs, rhsLookback);
+    lookback = (std::max)(lhsLookback, rhsLookback);
+
+    bool isIndicator = node.op == ExprOp::Sma || node.op == ExprOp::Ema || node.op == ExprOp::Rsi ||
+                       node.op == ExprOp::Highest || node.op == ExprOp::Lowest;
+    if (isIndicator) {
+        // The window starts on the input's first valid bar; RSI also needs the bar before
+        instr.window = (int)node.value;
+        lookback = (std::max)(lookback, 1) + instr.window - 1 + (node.op == ExprOp::Rsi ? 1 : 0);
+    }
+    else if (instr.a.kind == Operand::Scalar && (!node.rhs || instr.b.kind == Operand::Scalar)) {
+        result.kind = Operand::Scalar;
+        result.scalar = foldScalar(node.op, instr.a.scalar, instr.b.scalar);
+        return result;
+    }
+
+    instr.dst = m_numRegs++;
+    m_program.push_back(instr);
+
+    result.kind = Operand::Reg;
+    result.index = instr.dst;
+    return result;
+}
+
+bool CompiledExpression::compile(const std::string& source, std::string& error)
+{
+    m_source = source;
+    m_program.clear();
+    m_numRegs = 0;
+    m_lookback = 0;
+    error.clear();
+
+    Parser parser(source);
+    std::unique_ptr<ExprNode> root = parser.parse(error);
+    if (!root) {
+        if (error.empty()) error = "empty expression";
+        return false;
+    }
+
+    m_resultType = root->type;
+    m_result = lower(*root, m_lookback);
+
+    // A fully constant expression still needs one instruction so that
+    // isValid() holds; broadcast it through an Add with zero.
+    if (m_program.empty()) {
+        Instr instr;
+        instr.op = ExprOp::Add;
+        instr.dst = m_numRegs++;
+        instr.a = m_result;
+        instr.b.kind = Operand::Scalar;
+        instr.b.scalar = 0.0;
+        m_program.push_back(instr);
+        m_result.kind = Operand::Reg;
+        m_result.index = instr.dst;
+    }
+    return true;
+}
+
+void CompiledExpression::evaluate(const SeriesColumns& columns, std::vector<double>& out, ExprScratch& scratch) const
+{
+    const size_t n = columns.size();
+    out.resize(n);
+    if (!isValid() || n == 0) return;
+
+    if (scratch.regs.size() < (size_t)m_numRegs) scratch.regs.resize(m_numRegs);
+    // The result register is written straight into `out`
+    for (int r = 0; r < m_numRegs; r++) {
+        if (!(m_result.kind == Operand::Reg && m_result.index == r)) scratch.regs[r].resize(n);
+    }
+
+    auto regPtr = [&](int r) -> double* {
+        return (m_result.kind == Operand::Reg && m_result.index == r) ? out.data() : scratch.regs[r].data();
+    };
+    auto operandPtr = [&](const Operand& op) -> const double* {
+        switch (op.kind) {
+        case Operand::Reg:    return regPtr(op.index);
+        case Operand::Column: return columnRef(columns, op.index).data();
+        default:              return &op.scalar;
+        }
+    };
+
+    for (const Instr& instr : m_program) {
+        const double* a = operandPtr(instr.a);
+        const double* b = operandPtr(instr.b);
+        bool aScalar = instr.a.kind == Operand::Scalar;
+        bool bScalar = instr.b.kind == Operand::Scalar;
+        double* dst = regPtr(instr.dst);
+
+        switch (instr.op) {
+        case ExprOp::Add:       runBinary<OpAdd>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::Sub:       runBinary<OpSub>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::Mul:       runBinary<OpMul>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::Div:       runBinary<OpDiv>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::Greater:   runBinary<OpGt>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::GreaterEq: runBinary<OpGe>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::Less:      runBinary<OpLt>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::LessEq:    runBinary<OpLe>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::Equal:     runBinary<OpEq>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::NotEqual:  runBinary<OpNe>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::And:       runBinary<OpAnd>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::Or:        runBinary<OpOr>(a, aScalar, b, bScalar, dst, n); break;
+        case ExprOp::Neg:       negKernel(a, dst, n); break;
+        case ExprOp::Abs:       absKernel(a, dst, n); break;
+        case ExprOp::Not:       notKernel(a, dst, n); break;
+        case ExprOp::Sma:       smaKernel(a, dst, n, instr.window); break;
+        case ExprOp::Ema:       emaKernel(a, dst, n, instr.window); break;
+        case ExprOp::Rsi:       rsiKernel(a, dst, n, instr.window); break;
+        case ExprOp::Highest:   extremumKernel<true>(a, dst, n, instr.window, scratch.window); break;
+        case ExprOp::Lowest:    extremumKernel<false>(a, dst, n, instr.window, scratch.window); break;
+        default: break;
+        }
+    }
+}
+
+void CompiledExpression::evaluate(const SeriesColumns& columns, std::vector<double>& out) const
+{
+    ExprScratch scratch;
+    evaluate(columns, out, scratch);
+}
+
+double CompiledExpression::evaluateLast(const SeriesColumns& columns, ExprScratch& scratch) const
+{
+    if (!isValid() || columns.size() == 0) return kNaN;
+    evaluate(columns, scratch.last, scratch);
+    return scratch.last.back();
+}
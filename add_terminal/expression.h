@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct CandleData;
+class CompressedSeries;
+
+// Column-oriented copy of a candle series. Expressions are evaluated over
+// whole columns at once instead of walking CandleData bar by bar.
+struct SeriesColumns {
+    std::vector<double> open;
+    std::vector<double> high;
+    std::vector<double> low;
+    std::vector<double> close;
+    std::vector<double> volume;
+
+    size_t size() const { return close.size(); }
+    static SeriesColumns fromCandles(const std::vector<CandleData>& candles);
+    // Decodes block by block straight into the columns, no CandleData copy
+    static SeriesColumns fromSeries(const CompressedSeries& series);
+};
+
+enum class ExprType { Number, Bool };
+
+enum class ExprOp : uint8_t {
+    Constant, Column,
+    Add, Sub, Mul, Div, Neg, Abs,
+    Greater, GreaterEq, Less, LessEq, Equal, NotEqual,
+    And, Or, Not,
+    Sma, Ema, Rsi, Highest, Lowest
+};
+
+// Typed AST produced by the parser. Only lives until compile() has lowered
+// it into the flat instruction list below.
+struct ExprNode {
+    ExprOp op;
+    ExprType type;
+    double value = 0.0;   // Constant value, or window length for indicators
+    int column = 0;       // Column index for ExprOp::Column
+    std::unique_ptr<ExprNode> lhs;
+    std::unique_ptr<ExprNode> rhs;
+};
+
+// Per-thread scratch registers. Keep one around per worker when screening
+// many symbols so evaluation does not allocate.
+struct ExprScratch {
+    std::vector<std::vector<double>> regs;
+    std::vector<size_t> window;
+    std::vector<double> last;
+};
+
+// An expression like `close > sma(close,50) and rsi(14) < 30`, parsed once
+// and lowered to column kernels. Bool results are stored as 0.0 / 1.0, or
+// NaN where an input has no value yet. The same compiled object serves
+// backtests (evaluate) and screens (evaluateLast).
+class CompiledExpression {
+public:
+    bool compile(const std::string& source, std::string& error);
+
+    bool isValid() const { return !m_program.empty(); }
+    ExprType resultType() const { return m_resultType; }
+    const std::string& source() const { return m_source; }
+
+    // Bars needed before the first valid value, nested windows included
+    // (sma(sma(close,5),5) needs 9); bars before this are NaN, bool or not
+    int lookback() const { return m_lookback; }
+
+    void evaluate(const SeriesColumns& columns, std::vector<double>& out, ExprScratch& scratch) const;
+    void evaluate(const SeriesColumns& columns, std::vector<double>& out) const;
+    double evaluateLast(const SeriesColumns& columns, ExprScratch& scratch) const;
+
+private:
+    // Operand of an instruction: a register, an input column or a scalar
+    struct Operand {
+        enum Kind : uint8_t { Reg, Column, Scalar } kind = Scalar;
+        int index = 0;
+        double scalar = 0.0;
+    };
+
+    struct Instr {
+        ExprOp op;
+        int dst;
+        Operand a;
+        Operand b;
+        int window = 0;
+    };
+
+    std::string m_source;
+    std::vector<Instr> m_program;
+    Operand m_result;
+    ExprType m_resultType = ExprType::Number;
+    int m_numRegs = 0;
+    int m_lookback = 0;
+
+    // lookback: bars the node needs for its first valid value (0 for columns)
+    Operand lower(const ExprNode& node, int& lookback);
+};
@@ -0,0 +1,304 @@
+#include "ib_requests.h"
+#include "connection_pool.h"
+#include "contracts.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// reqId of a reply to a one-shot request, or -1 for any other event
+int replyReqId(const EventData& data)
+{
+	return std::visit([](auto&& arg) -> int {
+		using T = std::decay_t<decltype(arg)>;
+		if constexpr (std::is_same_v<T, HistoricalDataEvent> ||
+		              std::is_same_v<T, HistoricalTicksEvent> ||
+		              std::is_same_v<T, ContractDetailsEvent> ||
+		              std::is_same_v<T, SnapshotEvent> ||
+		              std::is_same_v<T, ScannerResult> ||
+		              std::is_same_v<T, RequestErrorEvent>) {
+			return arg.reqId;
+		}
+		else {
+			return -1;
+		}
+	}, data);
+}
+
+} // namespace
+
+const char* requestStatusName(RequestStatus status)
+{
+	switch (status) {
+	case RequestStatus::Done:      return "done";
+	case RequestStatus::Failed:    return "failed";
+	case RequestStatus::TimedOut:  return "timed out";
+	case RequestStatus::Cancelled: return "cancelled";
+	}
+	return "";
+}
+
+template <typename T, typename Extract>
+Request<T> RequestRegistry::issue(Kind kind, int reqId, Command command, uint64_t timeoutNs, Extract extract)
+{
+	auto state = std::make_shared<detail::RequestState<T>>();
+	state->reqId = reqId;
+	if (m_closed) {
+		state->complete(RequestResult<T>{ RequestStatus::Cancelled, T{}, "Shutting down" });
+		return Request<T>(state);
+	}
+	state->cancel = [this, reqId]() { cancel(reqId); };
+
+	Entry entry{ kind, std::move(command), timeoutNs };
+	entry.finish = [state, extract](const EventData* reply, RequestStatus status, const std::string& error) {
+		RequestResult<T> result;
+		result.status = status;
+		result.error = error;
+		if (reply && status == RequestStatus::Done) {
+			if (const RequestErrorEvent* rejected = std::get_if<RequestErrorEvent>(reply)) {
+				result.status = RequestStatus::Failed;
+				result.error = std::to_string(rejected->code) + ": " + rejected->message;
+			}
+			else if (!extract(*reply, result)) {
+				result.status = RequestStatus::Failed;
+				if (result.error.empty()) result.error = "Unexpected reply";
+			}
+		}
+		RequestStatus completed = result.status;
+		state->complete(std::move(result));
+		return completed;
+	};
+
+	Entry& stored = m_pending.emplace(reqId, std::move(entry)).first->second;
+	if (m_inFlight[(size_t)kind] < kMaxInFlight[(size_t)kind]) send(stored);
+	else m_queued[(size_t)kind].push_back(reqId);
+	return Request<T>(state);
+}
+
+Request<std::vector<CandleData>> RequestRegistry::historical(RequestHistoricalDataCommand command, uint64_t timeoutNs)
+{
+	command.reqId = nextReqId();
+	int reqId = command.reqId;
+	return issue<std::vector<CandleData>>(Kind::Historical, reqId, std::move(command), timeoutNs,
+		[](const EventData& reply, RequestResult<std::vector<CandleData>>& result) {
+			const HistoricalDataEvent* bars = std::get_if<HistoricalDataEvent>(&reply);
+			if (!bars) return false;
+			if (bars->candles.empty()) {
+				result.error = "No bars";   // IbkrClient::error ends a failed request this way
+				return false;
+			}
+			result.value.assign(bars->candles.begin(), bars->candles.end());
+			return true;
+		});
+}
+
+Request<std::vector<TradePrint>> RequestRegistry::historicalTicks(RequestHistoricalTicksCommand command,
+	uint64_t timeoutNs)
+{
+	command.reqId = nextReqId();
+	int reqId = command.reqId;
+	return issue<std::vector<TradePrint>>(Kind::Historical, reqId, std::move(command), timeoutNs,
+		[](const EventData& reply, RequestResult<std::vector<TradePrint>>& result) {
+			const HistoricalTicksEvent* ticks = std::get_if<HistoricalTicksEvent>(&reply);
+			if (!ticks) return false;
+			result.value.assign(ticks->prints.begin(), ticks->prints.end());
+			return true;
+		});
+}
+
+Request<ContractDetailsEvent> RequestRegistry::contractDetails(SymbolId symbol, uint64_t timeoutNs)
+{
+	int reqId = nextReqId();
+	return issue<ContractDetailsEvent>(Kind::ContractDetails, reqId, RequestContractDetailsCommand{ reqId, symbol },
+		timeoutNs, [](const EventData& reply, RequestResult<ContractDetailsEvent>& result) {
+			const ContractDetailsEvent* details = std::get_if<ContractDetailsEvent>(&reply);
+			if (!details) return false;
+			result.value = *details;
+			return true;
+		});
+}
+
+Request<ContractInfo> RequestRegistry::resolve(SymbolId symbol, uint64_t timeoutNs)
+{
+	auto state = std::make_shared<detail::RequestState<ContractInfo>>();
+	ContractInfo cached;
+	if (ContractCache::find(symbol, cached)) {
+		state->complete(RequestResult<ContractInfo>{ RequestStatus::Done, std::move(cached) });
+		return Request<ContractInfo>(state);
+	}
+	auto resolving = m_resolving.find(symbol);
+	if (resolving != m_resolving.end()) return resolving->second;
+
+	// IbkrClient has put the answer in the cache by the time this completes
+	Request<ContractDetailsEvent> details = contractDetails(symbol, timeoutNs);
+	state->reqId = details.reqId();
+	state->cancel = [details]() { details.cancel(); };
+	m_resolving.emplace(symbol, Request<ContractInfo>(state));
+	details.onComplete([this, state, symbol](const RequestResult<ContractDetailsEvent>& result) {
+		m_resolving.erase(symbol);
+		state->complete(RequestResult<ContractInfo>{ result.status, result.value.contract, result.error });
+	});
+	return Request<ContractInfo>(state);
+}
+
+Request<SnapshotEvent> RequestRegistry::snapshot(SymbolId symbol, uint64_t timeoutNs)
+{
+	int reqId = nextReqId();
+	return issue<SnapshotEvent>(Kind::Snapshot, reqId, RequestSnapshotCommand{ reqId, symbol },
+		timeoutNs, [](const EventData& reply, RequestResult<SnapshotEvent>& result) {
+			const SnapshotEvent* quote = std::get_if<SnapshotEvent>(&reply);
+			if (!quote) return false;
+			result.value = *quote;
+			return true;
+		});
+}
+
+Request<std::vector<ScannerResultItem>> RequestRegistry::scanner(StartScannerCommand command, uint64_t timeoutNs)
+{
+	command.reqId = nextReqId();
+	int reqId = command.reqId;
+	return issue<std::vector<ScannerResultItem>>(Kind::Scanner, reqId, std::move(command), timeoutNs,
+		[](const EventData& reply, RequestResult<std::vector<ScannerResultItem>>& result) {
+			const ScannerResult* scan = std::get_if<ScannerResult>(&reply);
+			if (!scan) return false;
+			result.value.assign(scan->items.begin(), scan->items.end());
+			return true;
+		});
+}
+
+void RequestRegistry::send(Entry& entry)
+{
+	entry.sentNs = Profiler::now();
+	m_inFlight[(size_t)entry.kind]++;
+	m_ib.pushCommand(entry.command);
+}
+
+void RequestRegistry::sendQueued(Kind kind)
+{
+	std::deque<int>& queue = m_queued[(size_t)kind];
+	while (!queue.empty() && m_inFlight[(size_t)kind] < kMaxInFlight[(size_t)kind]) {
+		int reqId = queue.front();
+		queue.pop_front();
+		auto it = m_pending.find(reqId);
+		if (it != m_pending.end()) send(it->second);
+	}
+}
+
+bool RequestRegistry::handle(const Event& event)
+{
+	int reqId = replyReqId(event.data);
+	if (reqId < 0) return false;
+	auto it = m_pending.find(reqId);
+	if (it == m_pending.end()) {
+		// A scanner keeps publishing until its cancel lands, so replies to
+		// an abandoned request are dropped for a while rather than once
+		return m_abandoned.count(reqId) > 0;
+	}
+
+	// Off the map before finishing: callbacks may issue or cancel requests
+	Entry entry = std::move(it->second);
+	m_pending.erase(it);
+	m_inFlight[(size_t)entry.kind]--;
+
+	if (entry.kind == Kind::Scanner && std::holds_alternative<ScannerResult>(event.data)) {
+		// Later pages arrive until the cancel lands; drop them like an abandoned scan's
+		m_ib.pushCommand(CancelScannerCommand{ reqId });
+		m_abandoned[reqId] = Profiler::now();
+	}
+
+	uint64_t now = Profiler::now();
+	if (entry.finish(&event.data, RequestStatus::Done, std::string()) != RequestStatus::Done) {
+		m_stats.failed++;
+	}
+	else {
+		m_stats.completed++;
+		m_stats.lastLatencyMs = (now - entry.sentNs) / 1.0e6;
+		m_stats.maxLatencyMs = (std::max)(m_stats.maxLatencyMs, m_stats.lastLatencyMs);
+	}
+	sendQueued(entry.kind);
+	return true;
+}
+
+void RequestRegistry::cancel(int reqId)
+{
+	abandon(reqId, RequestStatus::Cancelled, "Cancelled");
+}
+
+void RequestRegistry::abandon(int reqId, RequestStatus status, const char* error)
+{
+	auto it = m_pending.find(reqId);
+	if (it == m_pending.end()) return;
+	Entry entry = std::move(it->second);
+	m_pending.erase(it);
+
+	const size_t kind = (size_t)entry.kind;
+	if (entry.sentNs != 0) {
+		m_inFlight[kind]--;
+		m_abandoned[reqId] = Profiler::now();
+		// Contract details and historical ticks can't be cancelled; the late
+		// reply is just dropped
+		switch (entry.kind) {
+		case Kind::Historical:
+			if (std::holds_alternative<RequestHistoricalDataCommand>(entry.command)) {
+				m_ib.pushCommand(CancelHistoricalDataCommand{ reqId });
+			}
+			break;
+		case Kind::Snapshot:   m_ib.pushCommand(CancelSnapshotCommand{ reqId }); break;
+		case Kind::Scanner:    m_ib.pushCommand(CancelScannerCommand{ reqId }); break;
+		default: break;
+		}
+	}
+	else {
+		std::deque<int>& queue = m_queued[kind];
+		queue.erase(std::find(queue.begin(), queue.end(), reqId));
+	}
+
+	if (status == RequestStatus::TimedOut) m_stats.timedOut++;
+	else m_stats.cancelled++;
+	entry.finish(nullptr, status, error);
+	sendQueued(entry.kind);
+}
+
+void RequestRegistry::cancelAll()
+{
+	m_closed = true;
+	// Callbacks can't add anything once closed, so this terminates
+	while (!m_pending.empty()) {
+		auto it = m_pending.begin();
+		Entry entry = std::move(it->second);
+		m_pending.erase(it);
+		m_stats.cancelled++;
+		entry.finish(nullptr, RequestStatus::Cancelled, "Shutting down");
+	}
+	for (auto& queue : m_queued) queue.clear();
+	for (size_t& inFlight : m_inFlight) inFlight = 0;
+}
+
+void RequestRegistry::expire(uint64_t nowNs)
+{
+	m_expiredScratch.clear();
+	for (const auto& [reqId, entry] : m_pending) {
+		if (entry.sentNs != 0 && nowNs - entry.sentNs > entry.timeoutNs) m_expiredScratch.push_back(reqId);
+	}
+	for (int reqId : m_expiredScratch) {
+		printf("Request %d timed out\n", reqId);
+		abandon(reqId, RequestStatus::TimedOut, "Timed out");
+	}
+
+	for (auto it = m_abandoned.begin(); it != m_abandoned.end();) {
+		if (nowNs - it->second > kAbandonedHoldNs) it = m_abandoned.erase(it);
+		else ++it;
+	}
+}
+
+RequestStats RequestRegistry::stats() const
+{
+	RequestStats stats = m_stats;
+	for (size_t kind = 0; kind < kKindCount; kind++) {
+		stats.inFlight += m_inFlight[kind];
+		stats.queued += m_queued[kind].size();
+	}
+	return stats;
+}
@@ -0,0 +1,246 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "command.h"
+#include "event.h"
+
+class ConnectionPool;
+
+enum class RequestStatus : uint8_t { Done, Failed, TimedOut, Cancelled };
+const char* requestStatusName(RequestStatus status);
+
+template <typename T>
+struct RequestResult {
+	RequestStatus status = RequestStatus::Failed;
+	T value{};
+	std::string error;                  // Empty when Done
+
+	bool ok() const { return status == RequestStatus::Done; }
+};
+
+namespace detail {
+
+// Shared by a Request handle and the registry entry that completes it.
+// Everything but the future is UI thread only.
+template <typename T>
+struct RequestState {
+	int reqId = 0;
+	bool done = false;
+	std::promise<RequestResult<T>> promise;
+	std::shared_future<RequestResult<T>> future = promise.get_future().share();
+	std::vector<std::function<void(const RequestResult<T>&)>> callbacks;
+	std::function<void()> cancel;       // Cancels whichever stage is outstanding
+
+	void complete(RequestResult<T>&& result)
+	{
+		if (done) return;
+		done = true;
+		cancel = nullptr;               // Also breaks the cycle a chained request holds
+		promise.set_value(std::move(result));
+		std::vector<std::function<void(const RequestResult<T>&)>> ready;
+		ready.swap(callbacks);
+		for (auto& callback : ready) callback(future.get());
+	}
+};
+
+} // namespace detail
+
+// Handle to one request in flight. Cheap to copy; every copy refers to the
+// same request. Handles and callbacks belong to the UI thread; future() may
+// be waited on from a pool worker, never from the UI thread, which is where
+// requests complete.
+template <typename T>
+class Request {
+public:
+	using value_type = T;
+
+	Request() = default;
+	explicit Request(std::shared_ptr<detail::RequestState<T>> state) : m_state(std::move(state)) {}
+
+	bool valid() const { return m_state != nullptr; }
+	int reqId() const { return m_state ? m_state->reqId : 0; }     // Current stage of a chain
+	bool ready() const { return m_state && m_state->done; }
+	std::shared_future<RequestResult<T>> future() const { return m_state->future; }
+
+	void cancel() const
+	{
+		if (m_state && !m_state->done && m_state->cancel) m_state->cancel();
+	}
+
+	// Runs on the UI thread once the request completes, straight away if it
+	// already has
+	const Request& onComplete(std::function<void(const RequestResult<T>&)> callback) const
+	{
+		if (m_state->done) callback(m_state->future.get());
+		else m_state->callbacks.push_back(std::move(callback));
+		return *this;
+	}
+
+	// Composition: next(value) issues the follow-up request once this one is
+	// Done and returns its Request<U>. The chain completes with the follow-up's
+	// result, or with this stage's status if it did not succeed. Cancelling the
+	// chain cancels whichever stage is outstanding.
+	template <typename F>
+	auto then(F&& next) const -> std::invoke_result_t<std::decay_t<F>, const T&>
+	{
+		using Next = std::invoke_result_t<std::decay_t<F>, const T&>;
+		using U = typename Next::value_type;
+		auto chained = std::make_shared<detail::RequestState<U>>();
+		chained->reqId = reqId();
+		chained->cancel = [first = std::weak_ptr<detail::RequestState<T>>(m_state)]() {
+			if (auto state = first.lock(); state && state->cancel) state->cancel();
+		};
+		onComplete([chained, next = std::forward<F>(next)](const RequestResult<T>& result) mutable {
+			if (chained->done) return;
+			if (!result.ok()) {
+				chained->complete(RequestResult<U>{ result.status, U{}, result.error });
+				return;
+			}
+			Next second = next(result.value);
+			chained->reqId = second.reqId();
+			chained->cancel = [second]() { second.cancel(); };
+			second.onComplete([chained](const RequestResult<U>& last) {
+				chained->complete(RequestResult<U>(last));
+			});
+		});
+		return Next(chained);
+	}
+
+private:
+	std::shared_ptr<detail::RequestState<T>> m_state;
+};
+
+// Fan-in: completes (always Done) once every request has, with their
+// results in the same order. Cancelling it cancels the ones still pending.
+template <typename T>
+Request<std::vector<RequestResult<T>>> whenAll(const std::vector<Request<T>>& requests)
+{
+	using Results = std::vector<RequestResult<T>>;
+	auto all = std::make_shared<detail::RequestState<Results>>();
+	auto results = std::make_shared<Results>(requests.size());
+	auto remaining = std::make_shared<size_t>(requests.size());
+	all->cancel = [requests]() {
+		for (const Request<T>& request : requests) request.cancel();
+	};
+	if (requests.empty()) all->complete(RequestResult<Results>{ RequestStatus::Done });
+	for (size_t i = 0; i < requests.size(); i++) {
+		requests[i].onComplete([all, results, remaining, i](const RequestResult<T>& result) {
+			(*results)[i] = result;
+			if (--*remaining == 0) all->complete(RequestResult<Results>{ RequestStatus::Done, std::move(*results) });
+		});
+	}
+	return Request<Results>(all);
+}
+
+struct RequestStats {
+	size_t inFlight = 0;                // Sent, waiting for TWS
+	size_t queued = 0;                  // Held back by the in-flight limits
+	uint64_t completed = 0;
+	uint64_t failed = 0;
+	uint64_t timedOut = 0;
+	uint64_t cancelled = 0;
+	double lastLatencyMs = 0.0;         // Sent to answered, last successful request
+	double maxLatencyMs = 0.0;
+};
+
+// Request/response on top of the command and event queues. Each call sends
+// the command with a fresh reqId and returns a Request that completes when
+// the matching *End callback (or an error) comes back through
+// App::handleEvent, so callers never keep reqId -> symbol maps of their own.
+//
+// IB caps how many requests of each kind may be open at once (50
+// historical requests, 10 scanner subscriptions, the market data lines
+// snapshots use), so beyond those limits requests wait here and go out as
+// earlier ones finish; hundreds can be issued at once. The timeout runs
+// from when a request is sent. A timed out or cancelled request is
+// cancelled with TWS where IB allows it, and late replies to it are
+// dropped.
+//
+// UI thread only.
+class RequestRegistry {
+public:
+	static constexpr uint64_t kHistoricalTimeoutNs = 60000000000ull;
+	static constexpr uint64_t kContractTimeoutNs = 10000000000ull;
+	static constexpr uint64_t kSnapshotTimeoutNs = 15000000000ull;    // TWS gives up on a snapshot after 11 s
+	static constexpr uint64_t kScannerTimeoutNs = 30000000000ull;
+
+	explicit RequestRegistry(ConnectionPool& ib) : m_ib(ib) {}
+	~RequestRegistry() { cancelAll(); }
+	RequestRegistry(const RequestRegistry&) = delete;
+	RequestRegistry& operator=(const RequestRegistry&) = delete;
+
+	// Ids for streaming subscriptions too, so they never collide with requests
+	int nextReqId() { return m_nextReqId++; }
+
+	// command.reqId is assigned here
+	Request<std::vector<CandleData>> historical(RequestHistoricalDataCommand command,
+		uint64_t timeoutNs = kHistoricalTimeoutNs);
+	// One page of trades; shares the historical request limit
+	Request<std::vector<TradePrint>> historicalTicks(RequestHistoricalTicksCommand command,
+		uint64_t timeoutNs = kHistoricalTimeoutNs);
+	Request<ContractDetailsEvent> contractDetails(SymbolId symbol, uint64_t timeoutNs = kContractTimeoutNs);
+	// Complete at once from the ContractCache; otherwise one contract details
+	// request, shared by everyone resolving the symbol meanwhile (so
+	// cancelling it cancels it for all of them)
+	Request<ContractInfo> resolve(SymbolId symbol, uint64_t timeoutNs = kContractTimeoutNs);
+	Request<SnapshotEvent> snapshot(SymbolId symbol, uint64_t timeoutNs = kSnapshotTimeoutNs);
+	// The first page of results; the subscription is cancelled once it arrives
+	Request<std::vector<ScannerResultItem>> scanner(StartScannerCommand command,
+		uint64_t timeoutNs = kScannerTimeoutNs);
+
+	void cancel(int reqId);
+	// Completes everything as Cancelled without telling TWS (shutdown), and
+	// fails anything issued afterwards
+	void cancelAll();
+
+	// True if the event answered a request (or a cancelled one) and has been
+	// consumed
+	bool handle(const Event& event);
+	// Times out overdue requests; call once per frame
+	void expire(uint64_t nowNs);
+
+	RequestStats stats() const;
+
+private:
+	enum class Kind : uint8_t { Historical, ContractDetails, Snapshot, Scanner, Count };
+	static constexpr size_t kKindCount = (size_t)Kind::Count;
+	static constexpr size_t kMaxInFlight[kKindCount] = { 50, 50, 90, 10 };
+	static constexpr uint64_t kAbandonedHoldNs = 60000000000ull;      // Late replies swallowed this long
+
+	// Completes the request; returns the status it completed with
+	using Finish = std::function<RequestStatus(const EventData*, RequestStatus, const std::string&)>;
+
+	struct Entry {
+		Kind kind;
+		Command command;
+		uint64_t timeoutNs;
+		uint64_t sentNs = 0;            // 0 while queued
+		Finish finish;
+	};
+
+	ConnectionPool& m_ib;
+	int m_nextReqId = 1;
+	bool m_closed = false;
+	std::unordered_map<int, Entry> m_pending;
+	std::deque<int> m_queued[kKindCount];
+	size_t m_inFlight[kKindCount] = {};
+	std::unordered_map<int, uint64_t> m_abandoned;     // reqId -> when
+	std::unordered_map<SymbolId, Request<ContractInfo>> m_resolving;
+	std::vector<int> m_expiredScratch;
+	RequestStats m_stats;
+
+	template <typename T, typename Extract>
+	Request<T> issue(Kind kind, int reqId, Command command, uint64_t timeoutNs, Extract extract);
+	void send(Entry& entry);
+	void sendQueued(Kind kind);
+	void abandon(int reqId, RequestStatus status, const char* error);
+};
@@ -4,11 +4,16 @@
 #include "StdAfx.h"
 
 #include "ibkr.h"
+#include "profiler.h"
 
 #include "EClientSocket.h"
 #include "EPosixClientSocketPlatform.h"
 
 #include "Contract.h"
+#include "Execution.h"
+#include "Order.h"
+#include "OrderCancel.h"
+#include "OrderState.h"
 #include "ScannerSubscription.h"
 #include "ScannerSubscriptionSamples.h"
 #include "CommonDefs.h"
@@ -23,6 +28,76 @@
 #include <queue>
 #include <variant>
 
+namespace {
+
+// By conId once the contract cache knows the symbol, so TWS does no lookup
+// and nothing is ambiguous; otherwise assume a US stock routed SMART
+Contract contractFor(SymbolId symbol)
+{
+	Contract contract;
+	ContractInfo info;
+	if (ContractCache::find(symbol, info)) {
+		contract.conId = info.conId;
+		contract.secType = info.secType;
+		contract.currency = info.currency;
+		contract.exchange = info.exchange;
+		return contract;
+	}
+	contract.symbol = SymbolTable::name(symbol);
+	contract.secType = "STK";
+	contract.currency = "USD";
+	contract.exchange = "SMART";
+	return contract;
+}
+
+// The parts of a callback's contract worth caching. Stocks and options are
+// routed SMART; anything else keeps the exchange it trades on, even if none.
+ContractInfo contractInfo(const Contract& contract)
+{
+	ContractInfo info;
+	info.conId = contract.conId;
+	info.secType = contract.secType;
+	info.currency = contract.currency;
+	bool smart = contract.secType == "STK" || contract.secType == "OPT";
+	info.exchange = smart ? "SMART" : contract.exchange;
+	info.primaryExchange = contract.primaryExchange;
+	return info;
+}
+
+// Caches a contract from a scanner row or position under its symbol, but
+// only a stock's: an option's or future's symbol is its underlying and a
+// currency pair's is its base currency, so their conIds would capture
+// every request for that symbol.
+void learnContract(SymbolId symbol, const Contract& contract)
+{
+	if (contract.secType == "STK") ContractCache::learn(symbol, contractInfo(contract));
+}
+
+// Error callbacks that report something without failing the request they
+// carry the id of: connectivity (1100-1102, 1300), farm and other TWS
+// notices (2100-2199), order warnings (399), a depth book being reset
+// (317), partly unsubscribed data (10090) and delayed data being sent
+// instead of live (10167). Everything else, including the 10000+ market
+// data rejections, ends the request or stream.
+bool isInformational(int errorCode)
+{
+	switch (errorCode) {
+	case 317:
+	case 399:
+	case 1100:
+	case 1101:
+	case 1102:
+	case 1300:
+	case 10090:
+	case 10167:
+		return true;
+	default:
+		return errorCode >= 2100 && errorCode < 2200;
+	}
+}
+
+} // namespace
+
 ///////////////////////////////////////////////////////////
 // member funcs
 //! [socket_init]
@@ -67,13 +142,41 @@ void IbkrClient::getHistoricalTest() {
 	m_pClient->cancelHistoricalData(4001);
 }
 
-std::queue<Event> IbkrClient::consumeEvents() {
-	std::queue<Event> localQueue;
+std::vector<std::unique_ptr<EventBatch>> IbkrClient::consumeEvents() {
+	std::vector<std::unique_ptr<EventBatch>> batches;
 	{
 		std::lock_guard<std::mutex> lock(m_eventMutex);
-		std::swap(localQueue, m_eventQueue);
+		std::swap(batches, m_readyBatches);
+	}
+	return batches;
+}
+
+void IbkrClient::recycleEvents(std::vector<std::unique_ptr<EventBatch>>& batches) {
+	// Rewind outside the lock; the IB thread only needs the free list
+	for (auto& batch : batches) {
+		batch->reset();
+	}
+	std::lock_guard<std::mutex> lock(m_eventMutex);
+	for (auto& batch : batches) {
+		m_freeBatches.push_back(std::move(batch));
+	}
+	batches.clear();
+}
+
+// End of a message cycle: hand the filled batch to the UI and start a
+// fresh one, reusing a recycled batch when there is one.
+void IbkrClient::publishEvents() {
+	if (m_writeBatch->events.empty()) return;
+
+	std::lock_guard<std::mutex> lock(m_eventMutex);
+	m_readyBatches.push_back(std::move(m_writeBatch));
+	if (!m_freeBatches.empty()) {
+		m_writeBatch = std::move(m_freeBatches.back());
+		m_freeBatches.pop_back();
+	}
+	else {
+		m_writeBatch = std::make_unique<EventBatch>();
 	}
-	return localQueue;
 }
 
 void IbkrClient::scanTest() {
@@ -125,105 +228,403 @@ void IbkrClient::scanTest1() {
 
 void IbkrClient::pushCommand(Command command)
 {
-	std::lock_guard<std::mutex> lock(m_commandMutex);
-	m_commandQueue.push(std::move(command));
+	{
+		std::lock_guard<std::mutex> lock(m_commandMutex);
+		if (std::holds_alternative<DisconnectCommand>(command)) {
+			m_stopRequested = true;
+			m_stopCv.notify_all();
+		}
+		m_commandQueue.push_back(std::move(command));
+	}
+	// Wake the IB loop rather than waiting out waitForSignal's timeout
+	m_osSignal.issueSignal();
+}
+
+void IbkrClient::submitOrder(PlaceOrderCommand command)
+{
+	Command cmd{ std::move(command) };
+	std::lock_guard<std::mutex> lock(m_sendMutex);
+	executeCommand(cmd);
 }
 
+void IbkrClient::sendCancelOrder(CancelOrderCommand command)
+{
+	Command cmd{ command };
+	std::lock_guard<std::mutex> lock(m_sendMutex);
+	executeCommand(cmd);
+}
+
+int IbkrClient::nextOrderId()
+{
+	int id = m_nextOrderId.load();
+	while (id >= 0 && !m_nextOrderId.compare_exchange_weak(id, id + 1)) {}
+	return id;
+}
+
+// IB thread only. Visible to the UI once publishEvents() runs.
 void IbkrClient::pushEvent(Event event) {
-	m_eventQueue.push(std::move(event));
+	m_writeBatch->events.push_back(std::move(event));
+}
+
+void IbkrClient::replayDeferredErrors() {
+	std::vector<DeferredError> errors;
+	{
+		std::lock_guard<std::mutex> lock(m_deferredMutex);
+		if (m_deferredErrors.empty()) return;
+		std::swap(errors, m_deferredErrors);
+	}
+	for (const DeferredError& e : errors) {
+		error(e.id, e.errorTime, e.errorCode, e.errorString, e.advancedOrderRejectJson);
+	}
+}
+
+// Depth and tick-by-tick callbacks arrive in bursts; hand them to the UI
+// once per cycle instead of one event per row update or print.
+void IbkrClient::flushBatchedEvents() {
+	// Copy into the batch arena; the pending vectors keep their capacity
+	for (auto& [reqId, updates] : m_pendingDepth) {
+		if (updates.empty()) continue;
+		MarketDepthEvent evt{ reqId, m_depthReqIdToSymbol[reqId],
+			std::pmr::vector<DepthUpdate>(updates.begin(), updates.end(), eventResource()) };
+		updates.clear();
+		pushEvent(Event{ std::move(evt) });
+	}
+	for (auto& [reqId, prints] : m_pendingPrints) {
+		if (prints.empty()) continue;
+		TradePrintEvent evt{ reqId, m_tickReqIdToSymbol[reqId],
+			std::pmr::vector<TradePrint>(prints.begin(), prints.end(), eventResource()) };
+		prints.clear();
+		pushEvent(Event{ std::move(evt) });
+	}
+	// One event for the whole watchlist; ticks carry their reqId
+	if (!m_pendingQuotes.empty()) {
+		QuoteEvent evt{ std::pmr::vector<QuoteTick>(m_pendingQuotes.begin(), m_pendingQuotes.end(), eventResource()) };
+		m_pendingQuotes.clear();
+		pushEvent(Event{ std::move(evt) });
+	}
 }
 
 void IbkrClient::processCommands() {
-	std::queue<Command> localQueue;
 	{
 		std::lock_guard<std::mutex> lock(m_commandMutex);
-		std::swap(localQueue, m_commandQueue);
+		std::swap(m_commandScratch, m_commandQueue);
 	}
 
-	while (!localQueue.empty()) {
-		Command cmd = std::move(localQueue.front());
-		localQueue.pop();
+	for (Command& cmd : m_commandScratch) {
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+		executeCommand(cmd);
+	}
+	m_commandScratch.clear();
+}
 
-		std::visit([this](auto&& arg) {
-			using T = std::decay_t<decltype(arg)>;
+void IbkrClient::executeCommand(Command& cmd) {
+	std::visit([this](auto&& arg) {
+		using T = std::decay_t<decltype(arg)>;
 
-			if constexpr (std::is_same_v<T, StartScannerCommand>) {
-				printf("Processing StartScannerCommand: reqId=%d, scanCode=%s, priceAbove=%.2f\n",
-					arg.reqId, arg.scanCode.c_str(), arg.priceAbove);
+		if constexpr (std::is_same_v<T, StartScannerCommand>) {
+			printf("Processing StartScannerCommand: reqId=%d, scanCode=%s, priceAbove=%.2f\n",
+				arg.reqId, arg.scanCode.c_str(), arg.priceAbove);
 
-				ScannerSubscription scanSub;
-				scanSub.instrument = "STK";
-				scanSub.locationCode = "STK.US";
-				scanSub.scanCode = "TOP_AFTER_HOURS_PERC_GAIN";
+			ScannerSubscription scanSub;
+			scanSub.instrument = "STK";
+			scanSub.locationCode = "STK.US";
+			scanSub.scanCode = "TOP_AFTER_HOURS_PERC_GAIN";
 
-				TagValueListSPtr filters(new TagValueList());
-				filters->push_back(TagValueSPtr(new TagValue("priceAbove", "5")));
+			TagValueListSPtr filters(new TagValueList());
+			filters->push_back(TagValueSPtr(new TagValue("priceAbove", "5")));
 
-				m_pClient->reqScannerSubscription(7002, scanSub, TagValueListSPtr(), filters);
-			}
-			else if constexpr (std::is_same_v<T, CancelScannerCommand>) {
-				printf("Processing CancelScannerCommand: reqId=%d\n", arg.reqId);
-				m_pClient->cancelScannerSubscription(arg.reqId);
-			}
-			else if constexpr (std::is_same_v<T, RequestHistoricalDataCommand>) {
-				printf("Processing RequestHistoricalDataCommand: reqId=%d, symbol=%s, duration=%s, barSize=%s\n",
-					arg.reqId, arg.symbol.c_str(), arg.durationStr.c_str(), arg.barSizeSetting.c_str());
+			// The caller's reqId goes on the wire so the results and the cancel
+			// can be matched to the request
+			m_subscriptions[arg.reqId] = arg;
+			m_pClient->reqScannerSubscription(arg.reqId, scanSub, TagValueListSPtr(), filters);
+		}
+		else if constexpr (std::is_same_v<T, CancelScannerCommand>) {
+			printf("Processing CancelScannerCommand: reqId=%d\n", arg.reqId);
+			m_subscriptions.erase(arg.reqId);
+			m_pClient->cancelScannerSubscription(arg.reqId);
+		}
+		else if constexpr (std::is_same_v<T, RequestHistoricalDataCommand>) {
+			printf("Processing RequestHistoricalDataCommand: reqId=%d, symbol=%s, duration=%s, barSize=%s\n",
+				arg.reqId, symbolName(arg.symbol), arg.durationStr.c_str(), arg.barSizeSetting.c_str());
 
-				m_reqIdToSymbol[arg.reqId] = arg.symbol;
+			m_reqIdToSymbol[arg.reqId] = arg.symbol;
+			m_subscriptions[arg.reqId] = arg;   // Until historicalDataEnd
 
-				Contract contract;
-				contract.symbol = arg.symbol;
-				contract.secType = "STK";
-				contract.currency = "USD";
-				contract.exchange = "SMART";
+			Contract contract = contractFor(arg.symbol);
 
-				m_pClient->reqHistoricalData(arg.reqId, contract, arg.endDateTime,
-					arg.durationStr, arg.barSizeSetting, arg.whatToShow,
-					arg.useRTH, 1, false, TagValueListSPtr());
-			}
-			else if constexpr (std::is_same_v<T, DisconnectCommand>) {
-				printf("Processing DisconnectCommand\n");
-				m_pClient->eDisconnect();
+			m_pClient->reqHistoricalData(arg.reqId, contract, arg.endDateTime,
+				arg.durationStr, arg.barSizeSetting, arg.whatToShow,
+				arg.useRTH, 1, false, TagValueListSPtr());
+		}
+		else if constexpr (std::is_same_v<T, RequestHistoricalTicksCommand>) {
+			printf("Processing RequestHistoricalTicksCommand: reqId=%d, symbol=%s, start=%s\n",
+				arg.reqId, symbolName(arg.symbol), arg.startDateTime.c_str());
+
+			m_reqIdToSymbol[arg.reqId] = arg.symbol;
+			m_subscriptions[arg.reqId] = arg;   // Until the last historicalTicksLast
+
+			Contract contract = contractFor(arg.symbol);
+
+			m_pClient->reqHistoricalTicks(arg.reqId, contract, arg.startDateTime, "",
+				arg.numberOfTicks, "TRADES", arg.useRTH, true, TagValueListSPtr());
+		}
+		else if constexpr (std::is_same_v<T, CancelHistoricalDataCommand>) {
+			printf("Processing CancelHistoricalDataCommand: reqId=%d\n", arg.reqId);
+			if (m_subscriptions.erase(arg.reqId) == 0) return;   // Already ended
+			m_pClient->cancelHistoricalData(arg.reqId);
+			m_pendingHistoricalData.erase(arg.reqId);
+			m_reqIdToSymbol.erase(arg.reqId);
+		}
+		else if constexpr (std::is_same_v<T, RequestContractDetailsCommand>) {
+			m_pendingContracts[arg.reqId] = ContractDetailsEvent{ arg.reqId, arg.symbol };
+			m_subscriptions[arg.reqId] = arg;   // Until contractDetailsEnd
+
+			Contract contract = contractFor(arg.symbol);
+
+			m_pClient->reqContractDetails(arg.reqId, contract);
+		}
+		else if constexpr (std::is_same_v<T, RequestSnapshotCommand>) {
+			m_pendingSnapshots[arg.reqId] = SnapshotEvent{ arg.reqId, arg.symbol };
+			m_subscriptions[arg.reqId] = arg;   // Until tickSnapshotEnd
+
+			Contract contract = contractFor(arg.symbol);
+
+			m_pClient->reqMktData(arg.reqId, contract, "", true, false, TagValueListSPtr());
+		}
+		else if constexpr (std::is_same_v<T, CancelSnapshotCommand>) {
+			if (m_subscriptions.erase(arg.reqId) == 0) return;
+			m_pClient->cancelMktData(arg.reqId);
+			m_pendingSnapshots.erase(arg.reqId);
+		}
+		else if constexpr (std::is_same_v<T, DisconnectCommand>) {
+			printf("Processing DisconnectCommand\n");
+			m_pClient->eDisconnect();
+		}
+		else if constexpr (std::is_same_v<T, RequestAccountDataCommand>) {
+			printf("Processing RequestAccountDataCommand: accountCode=%s\n",
+				arg.accountCode.c_str());
+
+			m_subscriptions[kAccountSubscription] = arg;
+			if (!arg.accountCode.empty()) {
+				m_pClient->reqAccountUpdates(true, arg.accountCode);
+			} else {
+				m_pClient->reqPositions();
 			}
-			else if constexpr (std::is_same_v<T, RequestAccountDataCommand>) {
-				printf("Processing RequestAccountDataCommand: accountCode=%s\n",
-					arg.accountCode.c_str());
-
-				if (!arg.accountCode.empty()) {
-					m_pClient->reqAccountUpdates(true, arg.accountCode);
-				} else {
-					m_pClient->reqPositions();
-				}
+		}
+		else if constexpr (std::is_same_v<T, SubscribeMarketDepthCommand>) {
+			printf("Processing SubscribeMarketDepthCommand: reqId=%d, symbol=%s, rows=%d\n",
+				arg.reqId, symbolName(arg.symbol), arg.numRows);
+
+			m_depthReqIdToSymbol[arg.reqId] = arg.symbol;
+			m_subscriptions[arg.reqId] = arg;
+
+			Contract contract = contractFor(arg.symbol);
+
+			m_pClient->reqMktDepth(arg.reqId, contract, arg.numRows, arg.isSmartDepth, TagValueListSPtr());
+		}
+		else if constexpr (std::is_same_v<T, CancelMarketDepthCommand>) {
+			printf("Processing CancelMarketDepthCommand: reqId=%d\n", arg.reqId);
+			m_pClient->cancelMktDepth(arg.reqId, arg.isSmartDepth);
+			m_depthReqIdToSymbol.erase(arg.reqId);
+			m_pendingDepth.erase(arg.reqId);
+			m_subscriptions.erase(arg.reqId);
+		}
+		else if constexpr (std::is_same_v<T, SubscribeTickByTickCommand>) {
+			printf("Processing SubscribeTickByTickCommand: reqId=%d, symbol=%s\n",
+				arg.reqId, symbolName(arg.symbol));
+
+			m_tickReqIdToSymbol[arg.reqId] = arg.symbol;
+			m_subscriptions[arg.reqId] = arg;
+
+			Contract contract = contractFor(arg.symbol);
+
+			m_pClient->reqTickByTickData(arg.reqId, contract, "AllLast", 0, false);
+		}
+		else if constexpr (std::is_same_v<T, CancelTickByTickCommand>) {
+			printf("Processing CancelTickByTickCommand: reqId=%d\n", arg.reqId);
+			m_pClient->cancelTickByTickData(arg.reqId);
+			m_tickReqIdToSymbol.erase(arg.reqId);
+			m_pendingPrints.erase(arg.reqId);
+			m_subscriptions.erase(arg.reqId);
+		}
+		else if constexpr (std::is_same_v<T, SubscribeQuotesCommand>) {
+			// No per-request log; a watchlist sends hundreds of these
+			m_quoteReqIdToSymbol[arg.reqId] = arg.symbol;
+			m_subscriptions[arg.reqId] = arg;
+
+			Contract contract = contractFor(arg.symbol);
+
+			m_pClient->reqMktData(arg.reqId, contract, "", false, false, TagValueListSPtr());
+		}
+		else if constexpr (std::is_same_v<T, CancelQuotesCommand>) {
+			m_pClient->cancelMktData(arg.reqId);
+			m_quoteReqIdToSymbol.erase(arg.reqId);
+			m_subscriptions.erase(arg.reqId);
+		}
+		else if constexpr (std::is_same_v<T, PlaceOrderCommand>) {
+			Contract contract = contractFor(arg.symbol);
+
+			Order order;
+			order.action = arg.action;
+			order.orderType = arg.orderType;
+			order.totalQuantity = DecimalFunctions::doubleToDecimal(arg.quantity);
+			if (arg.orderType == "LMT") order.lmtPrice = arg.limitPrice;
+			order.tif = arg.tif;
+			order.outsideRth = arg.outsideRth;
+
+			{
+				std::lock_guard<std::mutex> lock(m_orderMutex);
+				m_orderIds.insert(arg.orderId);
 			}
-			}, cmd);
+			m_pClient->placeOrder(arg.orderId, contract, order);
+			printf("Placed order %d: %s %.0f %s %s @ %.2f\n", arg.orderId, arg.action.c_str(),
+				arg.quantity, symbolName(arg.symbol), arg.orderType.c_str(), arg.limitPrice);
+		}
+		else if constexpr (std::is_same_v<T, CancelOrderCommand>) {
+			m_pClient->cancelOrder(arg.orderId, OrderCancel());
+			printf("Cancel requested for order %d\n", arg.orderId);
+		}
+		}, cmd);
+}
+
+bool IbkrClient::connectSocket() {
+	if (!m_pClient->eConnect(m_host.c_str(), m_port, m_clientId, m_extraAuth)) {
+		return false;
 	}
+	printf("Connected to %s:%d clientId:%d serverVersion: %d\n",
+		m_pClient->host().c_str(), m_pClient->port(), m_clientId, m_pClient->EClient::serverVersion());
+	m_pReader = std::unique_ptr<EReader>(new EReader(m_pClient, &m_osSignal));
+	m_pReader->start();
+	return true;
 }
 
-void IbkrClient::processLoop() {
-	printf("Connecting to %s:%d clientId:%d\n", m_host.c_str(), m_port, m_clientId);
+// Sleeps out a reconnect delay, returning early if stop was requested
+void IbkrClient::waitBackoff(std::chrono::milliseconds delay) {
+	std::unique_lock<std::mutex> lock(m_commandMutex);
+	m_stopCv.wait_for(lock, delay, [this]() { return m_stopRequested.load(); });
+}
 
-	bool bRes = m_pClient->eConnect(m_host.c_str(), m_port, m_clientId, m_extraAuth);
-	if (bRes) {
-		printf("Connected to %s:%d clientId:%d serverVersion: %d\n",
-			m_pClient->host().c_str(), m_pClient->port(), m_clientId, m_pClient->EClient::serverVersion());
-		m_pReader = std::unique_ptr<EReader>(new EReader(m_pClient, &m_osSignal));
-		m_pReader->start();
+// Re-sends registered subscriptions. After a reconnect that is all of them;
+// after a 1101 (TWS kept our socket but lost its data) only the streams:
+// depth, tick-by-tick, quotes and the account updates, which TWS wants
+// resubmitted too. Partial state is dropped first: TWS starts each
+// stream over (depth from an empty book, historical from the first bar).
+std::pmr::vector<int> IbkrClient::replaySubscriptions(bool streamsOnly) {
+	PROFILE_ZONE("IB::replaySubscriptions");
+	if (!streamsOnly) {
+		m_pendingHistoricalData.clear();
+		m_pendingHistoricalTicks.clear();
+		m_pendingScannerResults.clear();
+		m_pendingContracts.clear();
+		m_pendingSnapshots.clear();
 	}
-	else {
-		printf("Cannot connect to %s:%d clientId:%d\n",
-			m_pClient->host().c_str(), m_pClient->port(), m_clientId);
-		return;
+	for (auto& [reqId, updates] : m_pendingDepth) updates.clear();
+	for (auto& [reqId, prints] : m_pendingPrints) prints.clear();
+	m_pendingQuotes.clear();
+
+	std::pmr::vector<int> replayed(eventResource());
+	std::vector<Command> commands;
+	commands.reserve(m_subscriptions.size());
+	for (auto& [reqId, command] : m_subscriptions) {
+		bool isStream = std::holds_alternative<SubscribeMarketDepthCommand>(command) ||
+			std::holds_alternative<SubscribeTickByTickCommand>(command) ||
+			std::holds_alternative<SubscribeQuotesCommand>(command) ||
+			std::holds_alternative<RequestAccountDataCommand>(command);
+		if (streamsOnly && !isStream) continue;
+		replayed.push_back(reqId);
+		commands.push_back(command);
 	}
 
-	int counter = 0;
-	while (m_pClient->isConnected()) {
-		processCommands();
-		counter++;
-		m_osSignal.waitForSignal();
-		errno = 0;
-		m_pReader->processMsgs();
-		std::this_thread::sleep_for(std::chrono::milliseconds(100));
-		std::printf("Processed message cycle %d\n", counter);
+	std::lock_guard<std::mutex> lock(m_sendMutex);
+	for (Command& command : commands) {
+		executeCommand(command);
+	}
+	if (streamsOnly) return replayed;
+
+	// Catch up on fills and status changes we missed while down
+	bool hasOrders;
+	{
+		std::lock_guard<std::mutex> orderLock(m_orderMutex);
+		hasOrders = !m_orderIds.empty();
+	}
+	if (hasOrders) {
+		m_pClient->reqOpenOrders();
+		m_pClient->reqExecutions(kResyncExecutionsReqId, ExecutionFilter());
+	}
+	printf("clientId:%d replayed %zu subscriptions\n", m_clientId, commands.size());
+	return replayed;
+}
+
+// Runs until a DisconnectCommand. If TWS goes away (nightly restart, network
+// drop) the loop reconnects with exponential backoff and replays the
+// subscription registry, so the UI never has to relaunch.
+void IbkrClient::processLoop() {
+	m_ibThread = std::this_thread::get_id();
+	const std::chrono::milliseconds kFirstDelay(250);
+	const std::chrono::milliseconds kMaxDelay(30000);
+
+	std::chrono::milliseconds delay = kFirstDelay;
+	uint64_t lostNs = 0;        // When the current outage began, 0 if never connected
+	int attempts = 0;
+
+	while (!m_stopRequested) {
+		attempts++;
+		printf("Connecting to %s:%d clientId:%d (attempt %d)\n", m_host.c_str(), m_port, m_clientId, attempts);
+		if (!connectSocket()) {
+			replayDeferredErrors();     // Orders sent while down still get their rejection
+			publishEvents();
+			printf("Cannot connect to %s:%d clientId:%d, retrying in %lld ms\n",
+				m_host.c_str(), m_port, m_clientId, (long long)delay.count());
+			waitBackoff(delay);
+			delay = (std::min)(delay * 2, kMaxDelay);
+			continue;
+		}
+
+		delay = kFirstDelay;
+		bool announced = false;
+
+		// waitForSignal returns as soon as a message arrives or pushCommand
+		// signals, so the loop needs no sleep of its own. Commands stay
+		// queued until nextValidId says TWS is ready for requests.
+		while (m_pClient->isConnected()) {
+			if (!announced && m_apiReady) {
+				ConnectionEvent up{ m_clientId, true, attempts };
+				if (lostNs != 0) {
+					up.outageNs = Profiler::now() - lostNs;
+					up.replayed = replaySubscriptions(false);
+				}
+				pushEvent(Event{ std::move(up) });
+				publishEvents();
+				announced = true;
+				attempts = 0;
+			}
+			if (m_apiReady) {
+				PROFILE_ZONE("IB::processCommands");
+				processCommands();
+			}
+			else if (m_stopRequested) {
+				m_pClient->eDisconnect();   // Stopped before TWS was ready
+				continue;
+			}
+			m_osSignal.waitForSignal();
+			errno = 0;
+			{
+				PROFILE_ZONE("IB::processMsgs");
+				m_pReader->processMsgs();
+				replayDeferredErrors();
+				flushBatchedEvents();
+				publishEvents();
+			}
+		}
+		m_pReader.reset();
+		m_apiReady = false;
+		if (m_stopRequested) break;
+
+		printf("Connection lost on clientId:%d, reconnecting\n", m_clientId);
+		lostNs = Profiler::now();
+		replayDeferredErrors();
+		pushEvent(Event{ ConnectionEvent{ m_clientId, false } });
+		publishEvents();
 	}
 }
 
@@ -273,10 +674,14 @@ void IbkrClient::setOptionalCapabilities(const std::string& optionalCapabilities
 void IbkrClient::processMessages()
 {
 	if (!m_pReader) return;
+	m_ibThread = std::this_thread::get_id();
 	processCommands();
 	m_osSignal.waitForSignal();
 	errno = 0;
 	m_pReader->processMsgs();
+	replayDeferredErrors();
+	flushBatchedEvents();
+	publishEvents();
 }
 
 //! [connectack]
@@ -289,6 +694,35 @@ void IbkrClient::connectAck() {
 // New [tickprice]
 void IbkrClient::tickPrice(TickerId tickerId, TickType field, double price, const TickAttrib& attribs)
 {
+	if (m_quoteReqIdToSymbol.count((int)tickerId)) {
+		QuoteTickType type;
+		switch (field)
+		{
+		case LAST: case DELAYED_LAST:   type = QuoteTickType::Last; break;
+		case CLOSE: case DELAYED_CLOSE: type = QuoteTickType::Close; break;
+		case BID: case DELAYED_BID:     type = QuoteTickType::Bid; break;
+		case ASK: case DELAYED_ASK:     type = QuoteTickType::Ask; break;
+		default: return;
+		}
+		// IB sends -1 for "no quote"
+		if (price > 0.0) m_pendingQuotes.push_back(QuoteTick{ (int)tickerId, type, price });
+		return;
+	}
+
+	auto snapshot = m_pendingSnapshots.find((int)tickerId);
+	if (snapshot != m_pendingSnapshots.end()) {
+		if (price <= 0.0) return;
+		switch (field)
+		{
+		case LAST: case DELAYED_LAST:   snapshot->second.last = price; break;
+		case CLOSE: case DELAYED_CLOSE: snapshot->second.close = price; break;
+		case BID: case DELAYED_BID:     snapshot->second.bid = price; break;
+		case ASK: case DELAYED_ASK:     snapshot->second.ask = price; break;
+		default: break;
+		}
+		return;
+	}
+
 	switch (field)
 	{
 	case LAST:
@@ -330,6 +764,22 @@ void IbkrClient::tickPrice(TickerId tickerId, TickType field, double price, cons
 // New [ticksize]
 void IbkrClient::tickSize(TickerId tickerId, TickType field, Decimal size)
 {
+	if (m_quoteReqIdToSymbol.count((int)tickerId)) {
+		if (field == VOLUME || field == DELAYED_VOLUME) {
+			m_pendingQuotes.push_back(QuoteTick{ (int)tickerId, QuoteTickType::Volume,
+				DecimalFunctions::decimalToDouble(size) });
+		}
+		return;
+	}
+
+	auto snapshot = m_pendingSnapshots.find((int)tickerId);
+	if (snapshot != m_pendingSnapshots.end()) {
+		if (field == VOLUME || field == DELAYED_VOLUME) {
+			snapshot->second.volume = DecimalFunctions::decimalToDouble(size);
+		}
+		return;
+	}
+
 	switch (field)
 	{
 	case VOLUME:
@@ -356,8 +806,7 @@ void IbkrClient::historicalData(TickerId reqId, const Bar& bar) {
 		bar.open, bar.high, bar.low, bar.close,
 		DecimalFunctions::decimalStringToDisplay(bar.volume).c_str());
 
-	CandleData candle;
-	candle.date = bar.time;
+	CandleData candle{ std::pmr::string(bar.time, &m_historicalPool) };
 	candle.open = bar.open;
 	candle.high = bar.high;
 	candle.low = bar.low;
@@ -370,41 +819,71 @@ void IbkrClient::historicalData(TickerId reqId, const Bar& bar) {
 		candle.volume = 0;
 	}
 
-	m_pendingHistoricalData[reqId].push_back(candle);
+	m_pendingHistoricalData.try_emplace((int)reqId, &m_historicalPool).first->second.push_back(std::move(candle));
 }
 //! [historicaldata]
 
 //! [historicaldataend]
 void IbkrClient::historicalDataEnd(int reqId, const std::string& startDateStr, const std::string& endDateStr) {
+	PROFILE_ZONE("IB::historicalDataEnd");
 	printf("HistoricalDataEnd. ReqId: %d - Start Date: %s, End Date: %s\n",
 		reqId, startDateStr.c_str(), endDateStr.c_str());
 
-	std::vector<CandleData> candles;
+	// Copied into the batch arena bar by bar: a plain copy would put each
+	// date back on the heap
+	HistoricalDataEvent evt{ reqId, kNoSymbol, std::pmr::vector<CandleData>(eventResource()) };
 	auto dataIt = m_pendingHistoricalData.find(reqId);
 	if (dataIt != m_pendingHistoricalData.end()) {
-		candles = std::move(dataIt->second);
+		evt.candles.reserve(dataIt->second.size());
+		for (const CandleData& bar : dataIt->second) {
+			evt.candles.push_back(CandleData{ std::pmr::string(bar.date, eventResource()),
+				bar.open, bar.high, bar.low, bar.close, bar.volume });
+		}
 		m_pendingHistoricalData.erase(dataIt);
 	}
 
-	std::string symbol;
+	m_subscriptions.erase(reqId);
+
 	auto symbolIt = m_reqIdToSymbol.find(reqId);
 	if (symbolIt != m_reqIdToSymbol.end()) {
-		symbol = symbolIt->second;
+		evt.symbol = symbolIt->second;
 		m_reqIdToSymbol.erase(symbolIt);
 	}
 
-	if (!candles.empty() && !symbol.empty()) {
-		printf("Pushing HistoricalDataEvent: symbol=%s, bars=%zu\n", symbol.c_str(), candles.size());
+	if (!evt.candles.empty() && evt.symbol != kNoSymbol) {
+		printf("Pushing HistoricalDataEvent: symbol=%s, bars=%zu\n", symbolName(evt.symbol), evt.candles.size());
+		pushEvent(Event{ std::move(evt) });
+	}
+}
+//! [historicaldataend]
 
-		HistoricalDataEvent evt;
-		evt.reqId = reqId;
-		evt.symbol = symbol;
-		evt.candles = std::move(candles);
+//! [historicalticksLast]
+void IbkrClient::historicalTicksLast(int reqId, const std::vector<HistoricalTickLast>& ticks, bool done)
+{
+	std::vector<TradePrint>& prints = m_pendingHistoricalTicks[reqId];
+	for (const HistoricalTickLast& tick : ticks) {
+		TradePrint print{};
+		print.time = (int64_t)tick.time;
+		print.price = tick.price;
+		print.size = DecimalFunctions::decimalToDouble(tick.size);
+		snprintf(print.exchange, sizeof(print.exchange), "%s", tick.exchange.c_str());
+		prints.push_back(print);
+	}
+	if (!done) return;
 
-		pushEvent(Event{ evt });
+	m_subscriptions.erase(reqId);
+	SymbolId symbol = kNoSymbol;
+	auto symbolIt = m_reqIdToSymbol.find(reqId);
+	if (symbolIt != m_reqIdToSymbol.end()) {
+		symbol = symbolIt->second;
+		m_reqIdToSymbol.erase(symbolIt);
 	}
+	HistoricalTicksEvent evt{ reqId, symbol,
+		std::pmr::vector<TradePrint>(prints.begin(), prints.end(), eventResource()) };
+	m_pendingHistoricalTicks.erase(reqId);
+	pushEvent(Event{ std::move(evt) });
 }
-//! [historicaldataend]
+//! [historicalticksLast]
 
 void IbkrClient::saveScannerXML(const std::string& xml)
 {
@@ -432,7 +911,8 @@ void IbkrClient::scannerData(int reqId, int rank, const ContractDetails& contrac
 	const std::string& legsStr) {
 	ScannerResultItem item;
 	item.rank = rank;
-	item.symbol = contractDetails.contract.symbol;
+	item.symbol = SymbolTable::intern(contractDetails.contract.symbol);
+	learnContract(item.symbol, contractDetails.contract);
 	item.secType = contractDetails.contract.secType;
 	item.currency = contractDetails.contract.currency;
 	item.conId = contractDetails.contract.conId;
@@ -453,30 +933,65 @@ void IbkrClient::scannerDataEnd(int reqId) {
 		}
 	}
 
-	if (!results.empty()) {
-		ScannerResult evt;
-		evt.reqId = reqId;
-		evt.items = std::move(results);
-		pushEvent(Event{ evt });
-	}
+	// Sent even when empty: an empty scan is still an answer
+	ScannerResult evt{ reqId,
+		std::pmr::vector<ScannerResultItem>(results.begin(), results.end(), eventResource()) };
+	pushEvent(Event{ std::move(evt) });
 }
 //! [scannerdataend]
 
+//! [contractdetails]
+void IbkrClient::contractDetails(int reqId, const ContractDetails& contractDetails) {
+	auto it = m_pendingContracts.find(reqId);
+	if (it == m_pendingContracts.end() || it->second.contract.conId != 0) return;   // First match only
+
+	ContractDetailsEvent& evt = it->second;
+	evt.contract = contractInfo(contractDetails.contract);
+	evt.contract.minTick = contractDetails.minTick;
+	evt.contract.longName = contractDetails.longName;
+	ContractCache::store(evt.symbol, evt.contract);
+}
+//! [contractdetails]
+
+//! [contractdetailsend]
+void IbkrClient::contractDetailsEnd(int reqId) {
+	m_subscriptions.erase(reqId);
+	auto it = m_pendingContracts.find(reqId);
+	if (it == m_pendingContracts.end()) return;
+	ContractDetailsEvent evt = std::move(it->second);
+	m_pendingContracts.erase(it);
+
+	if (evt.contract.conId == 0) {
+		pushEvent(Event{ RequestErrorEvent{ reqId, 200, "No contract for " + SymbolTable::name(evt.symbol) } });
+		return;
+	}
+	pushEvent(Event{ std::move(evt) });
+}
+//! [contractdetailsend]
+
+//! [ticksnapshotend]
+void IbkrClient::tickSnapshotEnd(int reqId) {
+	m_subscriptions.erase(reqId);
+	auto it = m_pendingSnapshots.find(reqId);
+	if (it == m_pendingSnapshots.end()) return;
+	pushEvent(Event{ std::move(it->second) });
+	m_pendingSnapshots.erase(it);
+}
+//! [ticksnapshotend]
+
 //! [updateaccountvalue]
 void IbkrClient::updateAccountValue(const std::string& key, const std::string& val,
 	const std::string& currency, const std::string& accountName) {
+	PROFILE_ZONE("IB::updateAccountValue");
 	printf("UpdateAccountValue. Key: %s, Value: %s, Currency: %s, Account Name: %s\n",
 		key.c_str(), val.c_str(), currency.c_str(), accountName.c_str());
 
-	AccountValueUpdate update;
-	update.key = key;
-	update.value = val;
-	update.currency = currency;
-	update.accountName = accountName;
-
-	AccountSummaryEvent event;
-	event.accountValues[key] = update;
-	pushEvent(Event{ event });
+	AccountSummaryEvent event{ std::pmr::vector<AccountValueUpdate>(eventResource()),
+		std::pmr::vector<PositionUpdate>(eventResource()) };
+	std::pmr::memory_resource* resource = eventResource();
+	event.accountValues.push_back(AccountValueUpdate{ std::pmr::string(key, resource),
+		std::pmr::string(val, resource), std::pmr::string(currency, resource), std::pmr::string(accountName, resource) });
+	pushEvent(Event{ std::move(event) });
 }
 //! [updateaccountvalue]
 
@@ -484,6 +999,7 @@ void IbkrClient::updateAccountValue(const std::string& key, const std::string& v
 void IbkrClient::updatePortfolio(const Contract& contract, Decimal position,
 	double marketPrice, double marketValue, double averageCost,
 	double unrealizedPNL, double realizedPNL, const std::string& accountName) {
+	PROFILE_ZONE("IB::updatePortfolio");
 	printf("UpdatePortfolio. %s, %s @ %s: Position: %s, MarketPrice: %g, MarketValue: %g, AverageCost: %g, UnrealizedPNL: %g, RealizedPNL: %g, AccountName: %s\n",
 		contract.symbol.c_str(), contract.secType.c_str(), contract.primaryExchange.c_str(),
 		DecimalFunctions::decimalStringToDisplay(position).c_str(),
@@ -491,7 +1007,8 @@ void IbkrClient::updatePortfolio(const Contract& contract, Decimal position,
 
 	PositionUpdate posUpdate;
 	posUpdate.account = accountName;
-	posUpdate.symbol = contract.symbol;
+	posUpdate.symbol = SymbolTable::intern(contract.symbol);
+	learnContract(posUpdate.symbol, contract);
 	posUpdate.secType = contract.secType;
 	posUpdate.position = DecimalFunctions::decimalToDouble(position);
 	posUpdate.marketPrice = marketPrice;
@@ -500,9 +1017,10 @@ void IbkrClient::updatePortfolio(const Contract& contract, Decimal position,
 	posUpdate.unrealizedPNL = unrealizedPNL;
 	posUpdate.realizedPNL = realizedPNL;
 
-	AccountSummaryEvent event;
+	AccountSummaryEvent event{ std::pmr::vector<AccountValueUpdate>(eventResource()),
+		std::pmr::vector<PositionUpdate>(eventResource()) };
 	event.positions.push_back(posUpdate);
-	pushEvent(Event{ event });
+	pushEvent(Event{ std::move(event) });
 }
 //! [updateportfolio]
 
@@ -515,7 +1033,8 @@ void IbkrClient::position(const std::string& account, const Contract& contract,
 
 	PositionUpdate posUpdate;
 	posUpdate.account = account;
-	posUpdate.symbol = contract.symbol;
+	posUpdate.symbol = SymbolTable::intern(contract.symbol);
+	learnContract(posUpdate.symbol, contract);
 	posUpdate.secType = contract.secType;
 	posUpdate.position = DecimalFunctions::decimalToDouble(position);
 	posUpdate.averageCost = avgCost;
@@ -524,8 +1043,192 @@ void IbkrClient::position(const std::string& account, const Contract& contract,
 	posUpdate.unrealizedPNL = 0.0;
 	posUpdate.realizedPNL = 0.0;
 
-	AccountSummaryEvent event;
+	AccountSummaryEvent event{ std::pmr::vector<AccountValueUpdate>(eventResource()),
+		std::pmr::vector<PositionUpdate>(eventResource()) };
 	event.positions.push_back(posUpdate);
-	pushEvent(Event{ event });
+	pushEvent(Event{ std::move(event) });
 }
 //! [position]
+
+//! [updatemktdepth]
+void IbkrClient::updateMktDepth(TickerId id, int position, int operation, int side,
+	double price, Decimal size) {
+	m_pendingDepth[(int)id].push_back(DepthUpdate{ position, operation, side, price,
+		DecimalFunctions::decimalToDouble(size) });
+}
+//! [updatemktdepth]
+
+//! [updatemktdepthl2]
+void IbkrClient::updateMktDepthL2(TickerId id, int position, const std::string& marketMaker, int operation,
+	int side, double price, Decimal size, bool isSmartDepth) {
+	m_pendingDepth[(int)id].push_back(DepthUpdate{ position, operation, side, price,
+		DecimalFunctions::decimalToDouble(size) });
+}
+//! [updatemktdepthl2]
+
+//! [tickbytickalllast]
+void IbkrClient::tickByTickAllLast(int reqId, int tickType, time_t time, double price, Decimal size,
+	const TickAttribLast& tickAttribLast, const std::string& exchange,
+	const std::string& specialConditions)
+{
+	TradePrint print{};
+	print.time = (int64_t)time;
+	print.price = price;
+	print.size = DecimalFunctions::decimalToDouble(size);
+	snprintf(print.exchange, sizeof(print.exchange), "%s", exchange.c_str());
+	m_pendingPrints[reqId].push_back(print);
+}
+//! [tickbytickalllast]
+
+//! [nextvalidid]
+void IbkrClient::nextValidId(OrderId orderId)
+{
+	// Never hand out an id twice, even if TWS repeats an older value
+	int id = m_nextOrderId.load();
+	while (id < (int)orderId && !m_nextOrderId.compare_exchange_weak(id, (int)orderId)) {}
+	m_apiReady = true;
+	printf("Next valid order id: %ld\n", (long)orderId);
+}
+//! [nextvalidid]
+
+//! [orderstatus]
+void IbkrClient::orderStatus(OrderId orderId, const std::string& status, Decimal filled,
+	Decimal remaining, double avgFillPrice, long long permId, int parentId,
+	double lastFillPrice, int clientId, const std::string& whyHeld, double mktCapPrice)
+{
+	OrderStatus evt(eventResource());
+	evt.recvNs = Profiler::now();
+	evt.orderId = (int)orderId;
+	evt.status = status;
+	evt.filled = DecimalFunctions::decimalToDouble(filled);
+	evt.remaining = DecimalFunctions::decimalToDouble(remaining);
+	evt.avgFillPrice = avgFillPrice;
+	evt.message = whyHeld;
+	pushEvent(Event{ std::move(evt) });
+}
+//! [orderstatus]
+
+//! [openorder]
+void IbkrClient::openOrder(OrderId orderId, const Contract& contract, const Order& order, const OrderState& orderState)
+{
+	OrderStatus evt(eventResource());
+	evt.recvNs = Profiler::now();
+	evt.orderId = (int)orderId;
+	evt.status = orderState.status;
+	evt.symbol = SymbolTable::intern(contract.symbol);
+	pushEvent(Event{ std::move(evt) });
+}
+//! [openorder]
+
+//! [execdetails]
+void IbkrClient::execDetails(int reqId, const Contract& contract, const Execution& execution)
+{
+	ExecutionEvent evt(eventResource());
+	evt.recvNs = Profiler::now();
+	evt.orderId = (int)execution.orderId;
+	evt.execId = execution.execId;
+	evt.symbol = SymbolTable::intern(contract.symbol);
+	evt.side = execution.side;
+	evt.shares = DecimalFunctions::decimalToDouble(execution.shares);
+	evt.price = execution.price;
+	evt.cumQty = DecimalFunctions::decimalToDouble(execution.cumQty);
+	evt.avgPrice = execution.avgPrice;
+	pushEvent(Event{ std::move(evt) });
+}
+//! [execdetails]
+
+//! [error]
+void IbkrClient::error(int id, time_t errorTime, int errorCode, const std::string& errorString,
+	const std::string& advancedOrderRejectJson)
+{
+	// A send from the UI thread (submitOrder) failed: handle it on the IB thread
+	if (std::this_thread::get_id() != m_ibThread.load()) {
+		{
+			std::lock_guard<std::mutex> lock(m_deferredMutex);
+			m_deferredErrors.push_back(DeferredError{ id, errorTime, errorCode, errorString, advancedOrderRejectJson });
+		}
+		m_osSignal.issueSignal();
+		return;
+	}
+	TestCppClient::error(id, errorTime, errorCode, errorString, advancedOrderRejectJson);
+
+	// 1101: TWS lost its own link to IB and dropped our market data and
+	// account subscriptions
+	if (errorCode == 1101) {
+		ConnectionEvent restored{ m_clientId, true };
+		restored.replayed = replaySubscriptions(true);
+		pushEvent(Event{ std::move(restored) });
+		return;
+	}
+
+	// A failed historical request never gets historicalDataEnd; end it with
+	// no bars so the UI is not left waiting
+	auto subscription = m_subscriptions.find(id);
+	if (!isInformational(errorCode) && subscription != m_subscriptions.end() &&
+		std::holds_alternative<RequestHistoricalDataCommand>(subscription->second)) {
+		m_subscriptions.erase(subscription);
+		m_pendingHistoricalData.erase(id);
+		SymbolId symbol = kNoSymbol;
+		auto symbolIt = m_reqIdToSymbol.find(id);
+		if (symbolIt != m_reqIdToSymbol.end()) {
+			symbol = symbolIt->second;
+			m_reqIdToSymbol.erase(symbolIt);
+		}
+		pushEvent(Event{ HistoricalDataEvent{ id, symbol, std::pmr::vector<CandleData>(eventResource()) } });
+		return;
+	}
+
+	// The other one-shot requests fail with a RequestErrorEvent
+	if (!isInformational(errorCode) && subscription != m_subscriptions.end() &&
+		(std::holds_alternative<RequestContractDetailsCommand>(subscription->second) ||
+		 std::holds_alternative<RequestHistoricalTicksCommand>(subscription->second) ||
+		 std::holds_alternative<RequestSnapshotCommand>(subscription->second) ||
+		 std::holds_alternative<StartScannerCommand>(subscription->second))) {
+		m_subscriptions.erase(subscription);
+		m_pendingContracts.erase(id);
+		m_pendingHistoricalTicks.erase(id);
+		m_reqIdToSymbol.erase(id);
+		m_pendingSnapshots.erase(id);
+		m_pendingScannerResults.erase(id);
+		pushEvent(Event{ RequestErrorEvent{ id, errorCode, errorString } });
+		return;
+	}
+
+	// So does a rejected stream: off the registry so it isn't replayed on
+	// every 1101 and reconnect, and the pool stops counting it as load
+	if (!isInformational(errorCode) && subscription != m_subscriptions.end() &&
+		(std::holds_alternative<SubscribeMarketDepthCommand>(subscription->second) ||
+		 std::holds_alternative<SubscribeTickByTickCommand>(subscription->second) ||
+		 std::holds_alternative<SubscribeQuotesCommand>(subscription->second))) {
+		m_subscriptions.erase(subscription);
+		m_depthReqIdToSymbol.erase(id);
+		m_pendingDepth.erase(id);
+		m_tickReqIdToSymbol.erase(id);
+		m_pendingPrints.erase(id);
+		m_quoteReqIdToSymbol.erase(id);
+		pushEvent(Event{ RequestErrorEvent{ id, errorCode, errorString } });
+		return;
+	}
+
+	bool isOrder;
+	{
+		std::lock_guard<std::mutex> lock(m_orderMutex);
+		isOrder = m_orderIds.count(id) > 0;
+	}
+	if (!isOrder) return;
+
+	// 202: cancelled; 201/203 and the 1xx validation errors: rejected.
+	// Anything else (warnings, holds) just carries its message.
+	OrderStatus evt(eventResource());
+	evt.recvNs = Profiler::now();
+	evt.orderId = id;
+	if (errorCode == 202) {
+		evt.status = "Cancelled";
+	}
+	else if (errorCode == 201 || errorCode == 203 || (errorCode >= 100 && errorCode < 200 && errorCode != 161)) {
+		evt.status = "Rejected";
+	}
+	evt.message = errorString;
+	pushEvent(Event{ std::move(evt) });
+}
+//! [error]
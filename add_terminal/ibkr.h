@@ -5,12 +5,20 @@
 
 #include "TestCppClient.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <queue>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include "command.h"
 #include "event.h"
+#include "event_batch.h"
 
 class IbkrClient : public TestCppClient
 {
@@ -30,7 +38,20 @@ public:
 	void pushCommand(Command command);
 	void pushEvent(Event event);
 	void processCommands();
-	std::queue<Event> consumeEvents();
+
+	// Events travel in whole batches (one per message cycle). The UI takes
+	// every published batch, handles the events, then hands the batches back
+	// so their arenas are rewound and reused.
+	std::vector<std::unique_ptr<EventBatch>> consumeEvents();
+	void recycleEvents(std::vector<std::unique_ptr<EventBatch>>& batches);
+
+	// Order fast path: sends on the calling thread instead of queueing for
+	// the IB loop. Safe to call from the UI thread; errors raised by the
+	// send are handled on the IB thread.
+	void submitOrder(PlaceOrderCommand command);
+	void sendCancelOrder(CancelOrderCommand command);
+	// Next order id from nextValidId, or -1 before TWS has sent one
+	int nextOrderId();
 
 	void getHistoricalTest();
 	void scanTest();
@@ -46,6 +67,10 @@ public:
 	void tickSize(TickerId tickerId, TickType field, Decimal size) override;
 	void historicalData(TickerId reqId, const Bar& bar) override;
 	void historicalDataEnd(int reqId, const std::string& startDateStr, const std::string& endDateStr) override;
+	void historicalTicksLast(int reqId, const std::vector<HistoricalTickLast>& ticks, bool done) override;
+	void contractDetails(int reqId, const ContractDetails& contractDetails) override;
+	void contractDetailsEnd(int reqId) override;
+	void tickSnapshotEnd(int reqId) override;
 	void scannerParameters(const std::string& xml) override;
 	void scannerData(int reqId, int rank, const ContractDetails& contractDetails,
 		const std::string& distance, const std::string& benchmark,
@@ -58,18 +83,91 @@ public:
 		double unrealizedPNL, double realizedPNL, const std::string& accountName) override;
 	void position(const std::string& account, const Contract& contract,
 		Decimal position, double avgCost) override;
+	void updateMktDepth(TickerId id, int position, int operation, int side,
+		double price, Decimal size) override;
+	void updateMktDepthL2(TickerId id, int position, const std::string& marketMaker, int operation,
+		int side, double price, Decimal size, bool isSmartDepth) override;
+	void tickByTickAllLast(int reqId, int tickType, time_t time, double price, Decimal size,
+		const TickAttribLast& tickAttribLast, const std::string& exchange,
+		const std::string& specialConditions) override;
+	void nextValidId(OrderId orderId) override;
+	void orderStatus(OrderId orderId, const std::string& status, Decimal filled,
+		Decimal remaining, double avgFillPrice, long long permId, int parentId,
+		double lastFillPrice, int clientId, const std::string& whyHeld, double mktCapPrice) override;
+	void openOrder(OrderId orderId, const Contract& contract, const Order& order, const OrderState& orderState) override;
+	void execDetails(int reqId, const Contract& contract, const Execution& execution) override;
+	void error(int id, time_t errorTime, int errorCode, const std::string& errorString,
+		const std::string& advancedOrderRejectJson) override;
 
 private:
 	std::string m_host;
 	int m_port;
 	int m_clientId;
 	std::mutex m_commandMutex;
+	std::condition_variable m_stopCv;       // Wakes a reconnect backoff on stop
+	std::atomic<bool> m_stopRequested{ false };
+	std::atomic<bool> m_apiReady{ false };  // nextValidId seen on this connection
 	std::mutex m_eventMutex;
-	std::queue<Command> m_commandQueue;
-	std::queue<Event> m_eventQueue;
+	std::mutex m_sendMutex;     // Serialises EClient writes between the IB and UI threads
+	std::mutex m_orderMutex;    // Guards m_orderIds
+
+	// EClient reports send failures through error() on the sending thread,
+	// which for submitOrder() is the UI. Those calls are queued here and
+	// replayed on the IB thread, which owns everything error() touches.
+	struct DeferredError {
+		int id;
+		time_t errorTime;
+		int errorCode;
+		std::string errorString;
+		std::string advancedOrderRejectJson;
+	};
+	std::atomic<std::thread::id> m_ibThread{};
+	std::mutex m_deferredMutex;
+	std::vector<DeferredError> m_deferredErrors;
+	void replayDeferredErrors();
+	std::unordered_set<int> m_orderIds;
+	std::atomic<int> m_nextOrderId{ -1 };
+	std::vector<Command> m_commandQueue;
+	std::vector<Command> m_commandScratch;  // IB thread; swapped with the queue so neither reallocates
+
+	// IB thread only: the batch being filled this cycle
+	std::unique_ptr<EventBatch> m_writeBatch = std::make_unique<EventBatch>();
+	// Guarded by m_eventMutex
+	std::vector<std::unique_ptr<EventBatch>> m_readyBatches;
+	std::vector<std::unique_ptr<EventBatch>> m_freeBatches;
+
+	// Payload allocator for events built on the IB thread
+	std::pmr::memory_resource* eventResource() { return m_writeBatch->resource(); }
+	void publishEvents();
 	std::unordered_map<int, std::vector<ScannerResultItem>> m_pendingScannerResults;
-	std::unordered_map<int, std::vector<CandleData>> m_pendingHistoricalData;
-	std::unordered_map<int, std::string> m_reqIdToSymbol;
+	// Bars of a download until historicalDataEnd, dates included, from a pool
+	// that keeps its memory across downloads
+	std::pmr::unsynchronized_pool_resource m_historicalPool;
+	std::unordered_map<int, std::pmr::vector<CandleData>> m_pendingHistoricalData;
+	std::unordered_map<int, std::vector<TradePrint>> m_pendingHistoricalTicks;
+	std::unordered_map<int, SymbolId> m_reqIdToSymbol;
+	std::unordered_map<int, SymbolId> m_depthReqIdToSymbol;
+	std::unordered_map<int, std::vector<DepthUpdate>> m_pendingDepth;
+	std::unordered_map<int, SymbolId> m_tickReqIdToSymbol;
+	std::unordered_map<int, std::vector<TradePrint>> m_pendingPrints;
+	std::unordered_map<int, SymbolId> m_quoteReqIdToSymbol;
+	std::vector<QuoteTick> m_pendingQuotes;
+	// One-shot requests, filled in until their *End callback
+	std::unordered_map<int, ContractDetailsEvent> m_pendingContracts;
+	std::unordered_map<int, SnapshotEvent> m_pendingSnapshots;
+
+	// IB thread only. Subscriptions this connection has live (plus historical
+	// requests still in flight), replayed after a reconnect. Keyed by wire
+	// reqId; the account subscription uses kAccountSubscription.
+	static constexpr int kAccountSubscription = -1;
+	static constexpr int kResyncExecutionsReqId = 9001;
+	std::map<int, Command> m_subscriptions;
+
+	void flushBatchedEvents();
+	void executeCommand(Command& command);
+	bool connectSocket();
+	void waitBackoff(std::chrono::milliseconds delay);
+	std::pmr::vector<int> replaySubscriptions(bool streamsOnly);
 
 	void saveScannerXML(const std::string& xml);
 
@@ -12,7 +12,11 @@
 const unsigned int SCR_WIDTH = 2560;
 const unsigned int SCR_HEIGHT = 1280;
 int main() {
-	
+	// Config, snapshot decode and TWS connections start before the window
+	// so they overlap GL and ImGui init
+	App app;
+	app.start();
+
 
 
     // Setup Platform/Renderer backends
@@ -48,7 +52,6 @@ int main() {
 		return -1;
 	}
 
-	App app;
 	app.init(window);
 
 
@@ -59,7 +62,8 @@ int main() {
 		glfwSwapBuffers(window);
 	}
 	std::printf("Shutting down application...\n");
-	
+	// While the GL context is current: chart builds still write into mapped buffers
+	app.stop();
 
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
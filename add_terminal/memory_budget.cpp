@@ -0,0 +1,294 @@
+#include "memory_budget.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int kMaxCpuEvictionsPerPass = 4;
+
+std::mutex g_spillMutex;
+std::unordered_set<SymbolId> g_spilled;     // Files this process wrote, removed on exit
+
+long long processId()
+{
+#ifdef _WIN32
+	return _getpid();
+#else
+	return getpid();
+#endif
+}
+
+// Private to this process, so two instances never touch each other's files
+const std::filesystem::path& spillDir()
+{
+	static const std::filesystem::path dir = [] {
+		std::error_code ec;
+		std::filesystem::path temp = std::filesystem::temp_directory_path(ec);
+		if (ec) temp = ".";
+		return temp / ("add_terminal-spill-" + std::to_string(processId()));
+	}();
+	return dir;
+}
+
+std::filesystem::path spillPath(SymbolId symbol)
+{
+	return spillDir() / (std::to_string(symbol) + ".bars");
+}
+
+bool readSpill(SymbolId symbol, CompressedSeries& series)
+{
+	std::ifstream file(spillPath(symbol), std::ios::binary);
+	if (!file) return false;
+	std::string image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return series.load(image.data(), image.size());
+}
+
+bool writeSpill(SymbolId symbol, const CompressedSeries& series, size_t& bytes)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(spillDir(), ec);
+	std::string image;
+	series.save(image);
+	{
+		std::lock_guard<std::mutex> lock(g_spillMutex);
+		g_spilled.insert(symbol);
+	}
+	std::ofstream file(spillPath(symbol), std::ios::binary | std::ios::trunc);
+	file.write(image.data(), (std::streamsize)image.size());
+	bytes = image.size();
+	return (bool)file;
+}
+
+void removeSpill(SymbolId symbol)
+{
+	std::error_code ec;
+	std::filesystem::remove(spillPath(symbol), ec);
+	std::lock_guard<std::mutex> lock(g_spillMutex);
+	g_spilled.erase(symbol);
+}
+
+} // namespace
+
+std::vector<CandleData>& residentCandles(DataManager& dataManager, SymbolId symbol)
+{
+	ChartData& chart = dataManager.charts[symbol];
+	chart.lastUsedNs = Profiler::now();
+	if (chart.tier == CandleTier::Resident) return chart.candles;
+
+	PROFILE_ZONE("residentCandles restore");
+	if (chart.tier == CandleTier::Spilled && !readSpill(symbol, chart.compressed)) {
+		printf("Memory: spill file for %s is gone, chart is empty until re-requested\n", symbolName(symbol));
+	}
+	chart.compressed.toCandles(chart.candles);
+	chart.compressed = CompressedSeries();
+	if (chart.tier == CandleTier::Spilled) removeSpill(symbol);
+	chart.tier = CandleTier::Resident;
+	chart.spilledBars = chart.spilledBytes = 0;
+	dataManager.memory.restores++;
+	return chart.candles;
+}
+
+void resetCandles(ChartData& chart)
+{
+	for (ResampledSeries& series : chart.timeframes) series.clear();
+	chart.dailyHistory.clearMerged();
+	chart.chartTypes.clear();
+	for (VolumeProfile& profile : chart.volumeProfiles) profile.clear();
+	if (chart.tier == CandleTier::Spilled) removeSpill(chart.symbol);
+	chart.compressed = CompressedSeries();
+	chart.tier = CandleTier::Resident;
+	chart.spilledBars = chart.spilledBytes = 0;
+	chart.lastUsedNs = Profiler::now();
+}
+
+bool readCandles(const ChartData& chart, std::vector<CandleData>& out)
+{
+	switch (chart.tier) {
+	case CandleTier::Resident:
+		out = chart.candles;
+		return true;
+	case CandleTier::Compressed:
+		chart.compressed.toCandles(out);
+		return true;
+	case CandleTier::Spilled: {
+		CompressedSeries series;
+		if (!readSpill(chart.symbol, series)) return false;
+		series.toCandles(out);
+		return true;
+	}
+	}
+	return false;
+}
+
+bool lastCandle(const ChartData& chart, CandleData& out)
+{
+	switch (chart.tier) {
+	case CandleTier::Resident:
+		if (chart.candles.empty()) return false;
+		out = chart.candles.back();
+		return true;
+	case CandleTier::Compressed:
+		if (chart.compressed.empty()) return false;
+		out = chart.compressed.back();
+		return true;
+	case CandleTier::Spilled: {
+		CompressedSeries series;
+		if (!readSpill(chart.symbol, series) || series.empty()) return false;
+		out = series.back();
+		return true;
+	}
+	}
+	return false;
+}
+
+size_t barCount(const ChartData& chart)
+{
+	switch (chart.tier) {
+	case CandleTier::Resident: return chart.candles.size();
+	case CandleTier::Compressed: return chart.compressed.size();
+	case CandleTier::Spilled: return chart.spilledBars;
+	}
+	return 0;
+}
+
+void enforceMemoryBudget(DataManager& dataManager, std::vector<GpuResidency>& gpu,
+	const std::function<void(uint32_t)>& releaseGpu, uint64_t nowNs)
+{
+	PROFILE_ZONE("enforceMemoryBudget");
+	MemoryUsage& usage = dataManager.memory;
+	usage.gpu.bytes = usage.gpu.charts = 0;
+	usage.candles.bytes = usage.candles.charts = 0;
+	usage.compressed.bytes = usage.compressed.charts = 0;
+	usage.spilled.bytes = usage.spilled.charts = 0;
+
+	for (const GpuResidency& entry : gpu) {
+		usage.gpu.bytes += entry.bytes;
+		usage.gpu.charts++;
+	}
+	for (auto& [symbol, chart] : dataManager.charts) {
+		usage.candles.bytes += chart.dailyHistory.bytes();   // A few hundred bars, never evicted
+		switch (chart.tier) {
+		case CandleTier::Resident:
+			if (chart.residentBytesRevision != chart.revision) {
+				chart.residentBytes = CompressedSeries::candleBytes(chart.candles);
+				chart.residentBytesRevision = chart.revision;
+			}
+			usage.candles.bytes += chart.residentBytes;
+			for (const ResampledSeries& series : chart.timeframes) usage.candles.bytes += series.bytes();
+			usage.candles.bytes += chart.chartTypes.bytes();
+			for (const VolumeProfile& profile : chart.volumeProfiles) usage.candles.bytes += profile.bytes();
+			usage.candles.charts += !chart.candles.empty();
+			break;
+		case CandleTier::Compressed:
+			usage.compressed.bytes += chart.compressed.memoryBytes();
+			usage.compressed.charts++;
+			break;
+		case CandleTier::Spilled:
+			usage.spilled.bytes += chart.spilledBytes;
+			usage.spilled.charts++;
+			break;
+		}
+	}
+
+	size_t total = usage.totalBytes();
+	if (usage.budgetBytes == 0 || total <= usage.budgetBytes) return;
+	auto idle = [nowNs](uint64_t lastUsedNs) { return lastUsedNs + kMinIdleNs <= nowNs; };
+
+	// GPU first: a view is cheap to rebuild from resident bars
+	std::sort(gpu.begin(), gpu.end(), [](const GpuResidency& a, const GpuResidency& b) { return a.lastUsedNs < b.lastUsedNs; });
+	for (const GpuResidency& entry : gpu) {
+		if (total <= usage.budgetBytes || !idle(entry.lastUsedNs)) break;
+		releaseGpu(entry.view);
+		total -= entry.bytes;
+		usage.gpu.bytes -= entry.bytes;
+		usage.gpu.charts--;
+		usage.gpu.evictions++;
+	}
+	if (total <= usage.budgetBytes) return;
+
+	std::vector<ChartData*> lru;
+	for (auto& [symbol, chart] : dataManager.charts) {
+		if (chart.tier != CandleTier::Spilled && idle(chart.lastUsedNs)) lru.push_back(&chart);
+	}
+	std::sort(lru.begin(), lru.end(), [](const ChartData* a, const ChartData* b) { return a->lastUsedNs < b->lastUsedNs; });
+
+	// Then compress resident bars, oldest first
+	int evicted = 0;
+	for (ChartData* chart : lru) {
+		if (total <= usage.budgetBytes || evicted == kMaxCpuEvictionsPerPass) break;
+		if (chart->tier != CandleTier::Resident || chart->candles.empty()) continue;
+		if (!chart->compressed.assign(chart->candles)) {
+			chart->compressed = CompressedSeries();
+			continue;   // Dates we can't parse or sub-1/10000 prices; leave it resident
+		}
+		// Resampled timeframes, chart types and the volume profile are rebuilt from the base when next shown
+		size_t residentBytes = chart->residentBytes;
+		for (ResampledSeries& series : chart->timeframes) {
+			residentBytes += series.bytes();
+			series.clear();
+		}
+		chart->dailyHistory.clearMerged();
+		residentBytes += chart->chartTypes.bytes();
+		chart->chartTypes.clear();
+		for (VolumeProfile& profile : chart->volumeProfiles) {
+			residentBytes += profile.bytes();
+			profile.clear();
+		}
+		size_t compressedBytes = chart->compressed.memoryBytes();
+		std::vector<CandleData>().swap(chart->candles);
+		chart->tier = CandleTier::Compressed;
+		total -= residentBytes - (std::min)(compressedBytes, residentBytes);
+		usage.candles.bytes -= residentBytes;
+		usage.candles.charts--;
+		usage.candles.evictions++;
+		usage.compressed.bytes += compressedBytes;
+		usage.compressed.charts++;
+		chart->residentBytesRevision = UINT64_MAX;
+		evicted++;
+	}
+
+	// Finally spill compressed series to disk
+	for (ChartData* chart : lru) {
+		if (total <= usage.budgetBytes || evicted == kMaxCpuEvictionsPerPass) break;
+		if (chart->tier != CandleTier::Compressed) continue;
+		size_t bytes = 0;
+		if (!writeSpill(chart->symbol, chart->compressed, bytes)) {
+			printf("Memory: cannot spill %s to %s\n", symbolName(chart->symbol), spillDir().string().c_str());
+			return;
+		}
+		size_t compressedBytes = chart->compressed.memoryBytes();
+		chart->spilledBars = chart->compressed.size();
+		chart->spilledBytes = bytes;
+		chart->compressed = CompressedSeries();
+		chart->tier = CandleTier::Spilled;
+		total -= compressedBytes;
+		usage.compressed.bytes -= compressedBytes;
+		usage.compressed.charts--;
+		usage.compressed.evictions++;
+		usage.spilled.bytes += bytes;
+		usage.spilled.charts++;
+		evicted++;
+	}
+}
+
+void clearSpillFiles()
+{
+	std::lock_guard<std::mutex> lock(g_spillMutex);
+	std::error_code ec;
+	for (SymbolId symbol : g_spilled) std::filesystem::remove(spillPath(symbol), ec);
+	g_spilled.clear();
+	std::filesystem::remove(spillDir(), ec);   // Only if that left it empty
+}
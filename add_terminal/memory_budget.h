@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "DataManager.h"
+
+// Keeps chart memory under DataManager::memory.budgetBytes.
+//
+// Each chart has GPU resources (owned by the Renderer) and bars in one of
+// the CandleTier tiers. When the total is over budget the least recently
+// used charts are evicted one tier at a time: GPU resources first, then
+// resident candles are compressed, then compressed series are spilled to
+// disk. Anything used within kMinIdleNs is left alone, so the charts on
+// screen never thrash. Evicted charts come back transparently: the
+// Renderer rebuilds views on demand and residentCandles() restores bars.
+
+// One chart view's GPU footprint, as the renderer reports it
+struct GpuResidency {
+	uint32_t view;                      // Renderer's ChartViewId
+	size_t bytes;
+	uint64_t lastUsedNs;
+};
+
+constexpr uint64_t kMinIdleNs = 2000000000ull;
+
+// The chart's bars as a vector, decompressing or reading the spill file
+// back first if they were evicted. Marks the chart used.
+std::vector<CandleData>& residentCandles(DataManager& dataManager, SymbolId symbol);
+
+// Forget any evicted copy; call before storing fresh bars in chart.candles
+void resetCandles(ChartData& chart);
+
+// Read access that leaves the chart in its tier, for passes over every
+// chart (snapshot, screening) that shouldn't undo the eviction
+bool readCandles(const ChartData& chart, std::vector<CandleData>& out);
+bool lastCandle(const ChartData& chart, CandleData& out);
+size_t barCount(const ChartData& chart);
+
+// Recounts dataManager.memory, then evicts until under budget. releaseGpu
+// frees one chart view's GPU resources. Compressing and spilling are bounded
+// per call, so a big overshoot is worked off over several frames.
+void enforceMemoryBudget(DataManager& dataManager, std::vector<GpuResidency>& gpu,
+	const std::function<void(uint32_t)>& releaseGpu, uint64_t nowNs);
+
+// Spill files only live as long as the process: removes the ones it wrote
+// (in its own directory under the system temp path), then that directory
+void clearSpillFiles();
@@ -0,0 +1,169 @@
+#include "order.h"
+
+#include <algorithm>
+
+bool OrderTemplate::validate(std::string& error) const
+{
+	if (action != "BUY" && action != "SELL") {
+		error = "action must be BUY or SELL";
+		return false;
+	}
+	if (orderType != "MKT" && orderType != "LMT") {
+		error = "order type must be MKT or LMT";
+		return false;
+	}
+	if (!(quantity > 0.0)) {
+		error = "quantity must be positive";
+		return false;
+	}
+	if (limitOffsetTicks < -100 || limitOffsetTicks > 100) {
+		error = "limit offset must be within 100 ticks";
+		return false;
+	}
+	if (tif != "DAY" && tif != "GTC" && tif != "IOC") {
+		error = "time in force must be DAY, GTC or IOC";
+		return false;
+	}
+	error.clear();
+	return true;
+}
+
+const char* orderPhaseName(OrderPhase phase)
+{
+	switch (phase) {
+	case OrderPhase::PendingSubmit:   return "PendingSubmit";
+	case OrderPhase::PreSubmitted:    return "PreSubmitted";
+	case OrderPhase::Submitted:       return "Submitted";
+	case OrderPhase::PartiallyFilled: return "PartiallyFilled";
+	case OrderPhase::Filled:          return "Filled";
+	case OrderPhase::PendingCancel:   return "PendingCancel";
+	case OrderPhase::Cancelled:       return "Cancelled";
+	case OrderPhase::Rejected:        return "Rejected";
+	}
+	return "Unknown";
+}
+
+namespace {
+
+// Forward order of the non-terminal states
+int phaseRank(OrderPhase phase)
+{
+	switch (phase) {
+	case OrderPhase::PendingSubmit:   return 0;
+	case OrderPhase::PreSubmitted:    return 1;
+	case OrderPhase::Submitted:       return 2;
+	case OrderPhase::PartiallyFilled: return 3;
+	case OrderPhase::PendingCancel:   return 4;
+	default:                          return 5;
+	}
+}
+
+// Map an IB status string (orderStatus / openOrder) to a state
+OrderPhase parseStatus(std::string_view status, double filled)
+{
+	if (status == "Filled") return OrderPhase::Filled;
+	if (status == "Cancelled" || status == "ApiCancelled") return OrderPhase::Cancelled;
+	if (status == "Inactive" || status == "Rejected") return OrderPhase::Rejected;
+	if (status == "PendingCancel") return OrderPhase::PendingCancel;
+	if (filled > 0.0) return OrderPhase::PartiallyFilled;
+	if (status == "Submitted") return OrderPhase::Submitted;
+	if (status == "PreSubmitted") return OrderPhase::PreSubmitted;
+	return OrderPhase::PendingSubmit;   // PendingSubmit, ApiPending
+}
+
+} // namespace
+
+OrderRecord& OrderTracker::create(int orderId, SymbolId symbol, const OrderTemplate& tmpl,
+	double limitPrice, uint64_t clickNs)
+{
+	OrderRecord& order = m_orders[orderId];
+	order.orderId = orderId;
+	order.symbol = symbol;
+	order.action = tmpl.action;
+	order.orderType = tmpl.orderType;
+	order.quantity = tmpl.quantity;
+	order.remaining = tmpl.quantity;
+	order.limitPrice = limitPrice;
+	order.clickNs = clickNs;
+	return order;
+}
+
+void OrderTracker::markSent(int orderId, uint64_t wireNs)
+{
+	auto it = m_orders.find(orderId);
+	if (it == m_orders.end()) return;
+	it->second.wireNs = wireNs;
+	if (it->second.clickNs != 0) {
+		m_clickToWire.push((wireNs - it->second.clickNs) / 1000.0f);
+	}
+}
+
+void OrderTracker::markCancelRequested(int orderId)
+{
+	auto it = m_orders.find(orderId);
+	if (it != m_orders.end()) transition(it->second, OrderPhase::PendingCancel);
+}
+
+const OrderRecord* OrderTracker::find(int orderId) const
+{
+	auto it = m_orders.find(orderId);
+	return it != m_orders.end() ? &it->second : nullptr;
+}
+
+void OrderTracker::transition(OrderRecord& order, OrderPhase next)
+{
+	if (order.isTerminal()) return;
+	// A stale Submitted can arrive after a cancel request or a fill; ignore it
+	if (phaseRank(next) < phaseRank(order.phase)) return;
+	order.phase = next;
+}
+
+void OrderTracker::acknowledge(OrderRecord& order, uint64_t recvNs)
+{
+	if (order.ackNs != 0 || order.wireNs == 0 || recvNs < order.wireNs) return;
+	order.ackNs = recvNs;
+	m_wireToAck.push((recvNs - order.wireNs) / 1000.0f);
+}
+
+void OrderTracker::apply(const OrderStatus& status)
+{
+	// Orders placed elsewhere (TWS, a previous session) are tracked too
+	OrderRecord& order = m_orders[status.orderId];
+	order.orderId = status.orderId;
+	if (order.symbol == kNoSymbol) order.symbol = status.symbol;
+	acknowledge(order, status.recvNs);
+
+	if (status.filled > order.filled) {
+		order.filled = status.filled;
+		order.remaining = status.remaining;
+		order.avgFillPrice = status.avgFillPrice;
+	}
+	if (!status.message.empty()) order.message = status.message;
+	transition(order, parseStatus(status.status, order.filled));
+}
+
+void OrderTracker::apply(const ExecutionEvent& execution)
+{
+	OrderRecord& order = m_orders[execution.orderId];
+	order.orderId = execution.orderId;
+	if (order.symbol == kNoSymbol) order.symbol = execution.symbol;
+	acknowledge(order, execution.recvNs);
+
+	// execDetails can beat the matching orderStatus; cumQty is authoritative
+	if (execution.cumQty > order.filled) {
+		order.filled = execution.cumQty;
+		order.avgFillPrice = execution.avgPrice;
+		order.remaining = (std::max)(0.0, order.quantity - order.filled);
+	}
+	transition(order, order.quantity > 0.0 && order.filled >= order.quantity
+		? OrderPhase::Filled : OrderPhase::PartiallyFilled);
+}
+
+void OrderTracker::history(const LatencyRing& ring, std::vector<float>& micros)
+{
+	size_t count = (std::min)(ring.count, kLatencyHistory);
+	micros.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		micros[i] = ring.micros[(ring.count - count + i) % kLatencyHistory];
+	}
+}
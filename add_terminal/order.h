@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "event.h"
+
+// Order entry template. Validated once when created or edited so the send
+// path only has to fill in symbol, id and price.
+struct OrderTemplate {
+	std::string name;
+	std::string action = "BUY";         // BUY / SELL
+	std::string orderType = "LMT";      // MKT / LMT
+	double quantity = 100;
+	int limitOffsetTicks = 0;           // LMT: ticks through the reference price (marketable if > 0)
+	std::string tif = "DAY";
+	bool outsideRth = false;
+
+	bool validate(std::string& error) const;
+};
+
+enum class OrderPhase {
+	PendingSubmit,      // Sent, nothing heard back yet
+	PreSubmitted,
+	Submitted,
+	PartiallyFilled,
+	Filled,
+	PendingCancel,
+	Cancelled,
+	Rejected
+};
+
+const char* orderPhaseName(OrderPhase phase);
+
+struct OrderRecord {
+	int orderId = 0;
+	SymbolId symbol = kNoSymbol;
+	std::string action;
+	std::string orderType;
+	double quantity = 0.0;
+	double limitPrice = 0.0;
+
+	OrderPhase phase = OrderPhase::PendingSubmit;
+	double filled = 0.0;
+	double remaining = 0.0;
+	double avgFillPrice = 0.0;
+	std::string message;                // whyHeld / reject reason
+
+	// Profiler::now() timestamps; 0 = not reached yet
+	uint64_t clickNs = 0;
+	uint64_t wireNs = 0;
+	uint64_t ackNs = 0;
+
+	bool isTerminal() const {
+		return phase == OrderPhase::Filled || phase == OrderPhase::Cancelled || phase == OrderPhase::Rejected;
+	}
+};
+
+// Order state machine fed by orderStatus / openOrder / execDetails / order
+// errors. IB can deliver these out of order and repeat them, so transitions
+// only move forward: a terminal state is never left, and fill quantities
+// never go backwards.
+class OrderTracker {
+public:
+	static constexpr size_t kLatencyHistory = 256;
+
+	OrderRecord& create(int orderId, SymbolId symbol, const OrderTemplate& tmpl,
+		double limitPrice, uint64_t clickNs);
+	void markSent(int orderId, uint64_t wireNs);
+	void markCancelRequested(int orderId);
+
+	void apply(const OrderStatus& status);
+	void apply(const ExecutionEvent& execution);
+
+	const std::map<int, OrderRecord>& orders() const { return m_orders; }
+	const OrderRecord* find(int orderId) const;
+
+	// Latency samples in microseconds, oldest first
+	void clickToWire(std::vector<float>& micros) const { history(m_clickToWire, micros); }
+	void wireToAck(std::vector<float>& micros) const { history(m_wireToAck, micros); }
+
+private:
+	std::map<int, OrderRecord> m_orders;    // Ordered by id, i.e. submission order
+
+	struct LatencyRing {
+		float micros[kLatencyHistory] = {};
+		size_t count = 0;
+		void push(float value) { micros[count++ % kLatencyHistory] = value; }
+	};
+	LatencyRing m_clickToWire;
+	LatencyRing m_wireToAck;
+
+	void transition(OrderRecord& order, OrderPhase next);
+	void acknowledge(OrderRecord& order, uint64_t recvNs);
+	static void history(const LatencyRing& ring, std::vector<float>& micros);
+};
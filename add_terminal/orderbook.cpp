@@ -0,0 +1,160 @@
+#include "orderbook.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+OrderBook::OrderBook(double tickSize, int capacity)
+	: m_levels(capacity)
+	, m_tickSize(tickSize > 0.0 ? tickSize : 0.01)
+{
+}
+
+int64_t OrderBook::toTick(double price) const
+{
+	return (int64_t)std::llround(price / m_tickSize);
+}
+
+double OrderBook::bidSizeAt(int64_t tick) const
+{
+	int64_t index = tick - m_baseTick;
+	return (index >= 0 && index < (int64_t)m_levels.size()) ? m_levels[index].bid : 0.0;
+}
+
+double OrderBook::askSizeAt(int64_t tick) const
+{
+	int64_t index = tick - m_baseTick;
+	return (index >= 0 && index < (int64_t)m_levels.size()) ? m_levels[index].ask : 0.0;
+}
+
+void OrderBook::clear()
+{
+	std::fill(m_levels.begin(), m_levels.end(), Level{});
+	m_rowCount[DEPTH_BID] = m_rowCount[DEPTH_ASK] = 0;
+	m_hasBase = false;
+}
+
+// Rebuild the level window from the row lists, centred on the touch (or on
+// `tick` for a one-sided book). Only runs when a price lands outside the
+// window, which is rare once centred.
+void OrderBook::recentre(int64_t tick)
+{
+	int64_t centre = tick;
+	if (hasBid() && hasAsk()) {
+		centre = (bestBidTick() + bestAskTick()) / 2;
+	}
+	std::fill(m_levels.begin(), m_levels.end(), Level{});
+	m_baseTick = centre - (int64_t)m_levels.size() / 2;
+	m_hasBase = true;
+
+	for (int side = 0; side < 2; side++) {
+		for (int i = 0; i < m_rowCount[side]; i++) {
+			int64_t index = m_rows[side][i].tick - m_baseTick;
+			if (index < 0 || index >= (int64_t)m_levels.size()) continue;
+			(side == DEPTH_BID ? m_levels[index].bid : m_levels[index].ask) += m_rows[side][i].size;
+		}
+	}
+}
+
+void OrderBook::addSize(int side, int64_t tick, double delta)
+{
+	int64_t index = tick - m_baseTick;
+	if (!m_hasBase || index < 0 || index >= (int64_t)m_levels.size()) {
+		// Removals outside the window have nothing to undo. Additions
+		// re-centre; callers update the rows first so the rebuild sees them.
+		if (delta > 0.0) recentre(tick);
+		return;
+	}
+	double& size = (side == DEPTH_BID) ? m_levels[index].bid : m_levels[index].ask;
+	size += delta;
+	if (size < 1e-9) size = 0.0;   // Keep float drift from leaving ghost levels
+}
+
+void OrderBook::apply(const DepthUpdate& u)
+{
+	if (u.side != DEPTH_BID && u.side != DEPTH_ASK) return;
+	if (u.position < 0 || u.position >= kMaxRows) return;
+
+	Row* rows = m_rows[u.side];
+	int& count = m_rowCount[u.side];
+	int64_t tick = toTick(u.price);
+	m_updateCount++;
+
+	switch (u.operation) {
+	case DEPTH_INSERT: {
+		if (u.position > count) return;
+		if (count == kMaxRows) {
+			// Drop the deepest row to make room
+			addSize(u.side, rows[count - 1].tick, -rows[count - 1].size);
+			count--;
+		}
+		std::move_backward(rows + u.position, rows + count, rows + count + 1);
+		count++;
+		rows[u.position] = Row{ tick, u.size };
+		addSize(u.side, tick, u.size);
+		break;
+	}
+	case DEPTH_UPDATE: {
+		if (u.position >= count) return;
+		Row& row = rows[u.position];
+		addSize(u.side, row.tick, -row.size);
+		row = Row{ tick, u.size };
+		addSize(u.side, tick, u.size);
+		break;
+	}
+	case DEPTH_DELETE: {
+		if (u.position >= count) return;
+		Row removed = rows[u.position];
+		std::move(rows + u.position + 1, rows + count, rows + u.position);
+		count--;
+		addSize(u.side, removed.tick, -removed.size);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+double OrderBook::benchmarkReplay(size_t count)
+{
+	// Synthetic stream shaped like a busy 10-row book: mostly size updates,
+	// with inserts/deletes as the touch moves around a random-walk mid.
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> position(0, 9);
+	std::uniform_int_distribution<int> op(0, 9);
+	std::uniform_int_distribution<int> walk(-1, 1);
+	std::uniform_real_distribution<double> size(100.0, 5000.0);
+
+	std::vector<DepthUpdate> updates;
+	updates.reserve(count + 20);
+	double mid = 100.0;
+	for (int side = 0; side < 2; side++) {
+		for (int row = 0; row < 10; row++) {
+			double price = side == DEPTH_BID ? mid - 0.01 * (row + 1) : mid + 0.01 * (row + 1);
+			updates.push_back(DepthUpdate{ row, DEPTH_INSERT, side, price, size(rng) });
+		}
+	}
+	while (updates.size() < count + 20) {
+		mid += walk(rng) * 0.01;
+		int side = (int)(updates.size() & 1);
+		int row = position(rng);
+		double price = side == DEPTH_BID ? mid - 0.01 * (row + 1) : mid + 0.01 * (row + 1);
+		int kind = op(rng);
+		if (kind == 0) {
+			updates.push_back(DepthUpdate{ row, DEPTH_DELETE, side, price, 0.0 });
+			updates.push_back(DepthUpdate{ row, DEPTH_INSERT, side, price, size(rng) });
+		}
+		else {
+			updates.push_back(DepthUpdate{ row, DEPTH_UPDATE, side, price, size(rng) });
+		}
+	}
+
+	OrderBook book;
+	auto start = std::chrono::steady_clock::now();
+	for (const DepthUpdate& u : updates) {
+		book.apply(u);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return seconds > 0.0 ? updates.size() / seconds : 0.0;
+}
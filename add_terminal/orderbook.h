@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// IB depth callback values (updateMktDepth / updateMktDepthL2)
+enum DepthOperation { DEPTH_INSERT = 0, DEPTH_UPDATE = 1, DEPTH_DELETE = 2 };
+enum DepthSide { DEPTH_ASK = 0, DEPTH_BID = 1 };
+
+struct DepthUpdate {
+	int position;
+	int operation;      // DepthOperation
+	int side;           // DepthSide
+	double price;
+	double size;
+};
+
+// Level 2 book for one symbol.
+//
+// IB describes depth as numbered rows per side, so the book keeps those rows
+// (at most kMaxRows, shifted on insert/delete) and mirrors their sizes into
+// a contiguous array of price levels indexed by tick offset from a base
+// tick. Any price lookup is a subtraction and an array index; the window
+// re-centres around the touch when prices walk off either end. Several rows
+// at one price (market makers in L2) are summed into that level.
+class OrderBook {
+public:
+	static constexpr int kMaxRows = 64;
+
+	explicit OrderBook(double tickSize = 0.01, int capacity = 4096);
+
+	void apply(const DepthUpdate& update);
+	void clear();
+
+	double tickSize() const { return m_tickSize; }
+	int64_t toTick(double price) const;
+	double toPrice(int64_t tick) const { return tick * m_tickSize; }
+
+	double bidSizeAt(int64_t tick) const;
+	double askSizeAt(int64_t tick) const;
+
+	int rowCount(int side) const { return m_rowCount[side]; }
+	bool hasBid() const { return m_rowCount[DEPTH_BID] > 0; }
+	bool hasAsk() const { return m_rowCount[DEPTH_ASK] > 0; }
+	int64_t bestBidTick() const { return m_rows[DEPTH_BID][0].tick; }
+	int64_t bestAskTick() const { return m_rows[DEPTH_ASK][0].tick; }
+
+	uint64_t updateCount() const { return m_updateCount; }
+
+	// Replay `count` synthetic depth updates and return updates per second
+	static double benchmarkReplay(size_t count);
+
+private:
+	struct Level {
+		double bid = 0.0;
+		double ask = 0.0;
+	};
+	struct Row {
+		int64_t tick = 0;
+		double size = 0.0;
+	};
+
+	std::vector<Level> m_levels;
+	int64_t m_baseTick = 0;
+	double m_tickSize;
+	bool m_hasBase = false;
+
+	Row m_rows[2][kMaxRows];
+	int m_rowCount[2] = { 0, 0 };
+	uint64_t m_updateCount = 0;
+
+	void addSize(int side, int64_t tick, double delta);
+	void recentre(int64_t tick);
+};
@@ -0,0 +1,219 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// One ring per thread. Only the owning thread writes; readers copy out
+// whatever is in the ring. An entry being overwritten while it is read can
+// come out torn, which only ever affects the oldest zone in a full ring.
+struct ThreadBuffer {
+	uint32_t id = 0;
+	std::string name;
+	std::unique_ptr<ProfileZone[]> ring{ new ProfileZone[Profiler::kRingCapacity] };
+	std::atomic<uint64_t> head{ 0 };
+	uint32_t depth = 0;
+};
+
+struct ProfilerState {
+	std::mutex mutex;                                   // Guards `threads` only
+	std::vector<std::unique_ptr<ThreadBuffer>> threads;
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+	// Frame history, UI thread only
+	float frameMs[Profiler::kFrameHistory] = {};
+	size_t frameCount = 0;
+	uint64_t frameStart = 0;
+
+	std::atomic<bool> capturing{ false };
+	uint64_t captureStart = 0;
+};
+
+ProfilerState& state()
+{
+	static ProfilerState s;
+	return s;
+}
+
+ThreadBuffer& threadBuffer()
+{
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (!buffer) {
+		auto owned = std::make_unique<ThreadBuffer>();
+		ProfilerState& s = state();
+		std::lock_guard<std::mutex> lock(s.mutex);
+		owned->id = (uint32_t)s.threads.size() + 1;
+		owned->name = "Thread " + std::to_string(owned->id);
+		buffer = owned.get();
+		s.threads.push_back(std::move(owned));    // Kept after the thread exits
+	}
+	return *buffer;
+}
+
+// Visit every recorded zone that ended at or after `sinceNs`
+template <typename Fn>
+void forEachZone(uint64_t sinceNs, Fn&& fn)
+{
+	ProfilerState& s = state();
+	std::lock_guard<std::mutex> lock(s.mutex);
+	for (const auto& buffer : s.threads) {
+		uint64_t head = buffer->head.load(std::memory_order_acquire);
+		uint64_t first = head > Profiler::kRingCapacity ? head - Profiler::kRingCapacity : 0;
+		for (uint64_t i = first; i < head; i++) {
+			const ProfileZone& zone = buffer->ring[i % Profiler::kRingCapacity];
+			if (zone.endNs >= sinceNs) fn(*buffer, zone);
+		}
+	}
+}
+
+void writeJsonString(std::ofstream& out, const char* text)
+{
+	out << '"';
+	for (const char* c = text; *c; c++) {
+		if (*c == '"' || *c == '\\') out << '\\';
+		out << *c;
+	}
+	out << '"';
+}
+
+} // namespace
+
+uint64_t Profiler::now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - state().epoch).count();
+}
+
+void Profiler::setThreadName(const char* name)
+{
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(state().mutex);
+	buffer.name = name;
+}
+
+void Profiler::record(const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth)
+{
+	ThreadBuffer& buffer = threadBuffer();
+	uint64_t head = buffer.head.load(std::memory_order_relaxed);
+	buffer.ring[head % kRingCapacity] = ProfileZone{ name, startNs, endNs, buffer.id, depth };
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::frameMark()
+{
+	ProfilerState& s = state();
+	uint64_t t = now();
+	if (s.frameStart != 0) {
+		s.frameMs[s.frameCount % kFrameHistory] = (t - s.frameStart) / 1.0e6f;
+		s.frameCount++;
+	}
+	s.frameStart = t;
+}
+
+void Profiler::frameTimes(std::vector<float>& millis)
+{
+	ProfilerState& s = state();
+	size_t count = (std::min)(s.frameCount, kFrameHistory);
+	millis.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		millis[i] = s.frameMs[(s.frameCount - count + i) % kFrameHistory];
+	}
+}
+
+uint64_t Profiler::lastFrameStart()
+{
+	return state().frameStart;
+}
+
+void Profiler::slowestZones(uint64_t sinceNs, size_t maxCount, std::vector<ZoneStats>& out)
+{
+	std::unordered_map<const char*, ZoneStats> byName;
+	forEachZone(sinceNs, [&](const ThreadBuffer&, const ProfileZone& zone) {
+		ZoneStats& stats = byName.try_emplace(zone.name, ZoneStats{ zone.name, 0, 0, 0 }).first->second;
+		uint64_t duration = zone.endNs - zone.startNs;
+		stats.count++;
+		stats.totalNs += duration;
+		stats.maxNs = (std::max)(stats.maxNs, duration);
+	});
+
+	out.clear();
+	for (const auto& [name, stats] : byName) out.push_back(stats);
+	std::sort(out.begin(), out.end(), [](const ZoneStats& a, const ZoneStats& b) { return a.maxNs > b.maxNs; });
+	if (out.size() > maxCount) out.resize(maxCount);
+}
+
+void Profiler::beginCapture()
+{
+	state().captureStart = now();
+	state().capturing = true;
+}
+
+bool Profiler::isCapturing()
+{
+	return state().capturing;
+}
+
+bool Profiler::endCapture(const std::string& filename)
+{
+	ProfilerState& s = state();
+	if (!s.capturing) return false;
+	s.capturing = false;
+	const uint64_t captureStart = s.captureStart;
+
+	std::ofstream out(filename);
+	if (!out.is_open()) {
+		printf("Profiler: cannot write %s\n", filename.c_str());
+		return false;
+	}
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+	size_t written = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(s.mutex);
+		for (const auto& buffer : s.threads) {
+			out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+				<< ",\"args\":{\"name\":";
+			writeJsonString(out, buffer->name.c_str());
+			out << "}}";
+			first = false;
+		}
+	}
+
+	forEachZone(captureStart, [&](const ThreadBuffer& buffer, const ProfileZone& zone) {
+		if (zone.startNs < captureStart) return;
+		out << ",\n{\"name\":";
+		writeJsonString(out, zone.name);
+		out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.id
+			<< ",\"ts\":" << zone.startNs / 1000.0
+			<< ",\"dur\":" << (zone.endNs - zone.startNs) / 1000.0 << "}";
+		written++;
+	});
+	out << "\n]}\n";
+
+	printf("Profiler: wrote %zu zones to %s\n", written, filename.c_str());
+	return out.good();
+}
+
+ScopedZone::ScopedZone(const char* name)
+	: m_name(name)
+	, m_start(Profiler::now())
+	, m_depth(threadBuffer().depth++)
+{
+}
+
+ScopedZone::~ScopedZone()
+{
+	Profiler::record(m_name, m_start, Profiler::now(), m_depth);
+	threadBuffer().depth--;
+}
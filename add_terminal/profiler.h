@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Lightweight scoped-zone profiler.
+//
+//   void App::update() {
+//       PROFILE_ZONE("App::update");
+//       ...
+//   }
+//
+// Each thread writes begin/end timestamps into its own fixed-size ring, so
+// recording never locks or allocates after the thread's first zone. Zone
+// names must be string literals (only the pointer is stored).
+// Define PROFILER_DISABLED to compile every zone away.
+
+struct ProfileZone {
+	const char* name;
+	uint64_t startNs;
+	uint64_t endNs;
+	uint32_t threadId;
+	uint32_t depth;
+};
+
+struct ZoneStats {
+	const char* name;
+	uint32_t count;
+	uint64_t totalNs;
+	uint64_t maxNs;
+};
+
+class Profiler {
+public:
+	static constexpr size_t kRingCapacity = 1 << 15;   // Zones kept per thread
+	static constexpr size_t kFrameHistory = 240;
+
+	// Nanoseconds since the profiler epoch
+	static uint64_t now();
+
+	static void setThreadName(const char* name);
+	static void record(const char* name, uint64_t startNs, uint64_t endNs, uint32_t depth);
+
+	// Called once per frame by the UI thread
+	static void frameMark();
+	static void frameTimes(std::vector<float>& millis);   // Oldest first
+	static uint64_t lastFrameStart();
+
+	// Aggregate all zones that ended after `sinceNs`, slowest (max) first
+	static void slowestZones(uint64_t sinceNs, size_t maxCount, std::vector<ZoneStats>& out);
+
+	// Chrome trace_event capture of everything recorded between begin and end.
+	// Load the file in chrome://tracing or ui.perfetto.dev.
+	static void beginCapture();
+	static bool endCapture(const std::string& filename);
+	static bool isCapturing();
+};
+
+class ScopedZone {
+public:
+	explicit ScopedZone(const char* name);
+	~ScopedZone();
+
+	ScopedZone(const ScopedZone&) = delete;
+	ScopedZone& operator=(const ScopedZone&) = delete;
+
+private:
+	const char* m_name;
+	uint64_t m_start;
+	uint32_t m_depth;
+};
+
+#ifdef PROFILER_DISABLED
+#define PROFILE_ZONE(name) ((void)0)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ScopedZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#endif
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
@@ -0,0 +1,256 @@
+#include "raster.h"
+#include "event.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+
+void RasterImage::resize(int w, int h)
+{
+    width = w;
+    height = h;
+    pixels.resize((size_t)w * h);
+}
+
+namespace {
+
+void fillRect(RasterImage& img, int x0, int y0, int x1, int y1, uint32_t color)
+{
+    x0 = (std::max)(x0, 0);
+    y0 = (std::max)(y0, 0);
+    x1 = (std::min)(x1, img.width);
+    y1 = (std::min)(y1, img.height);
+    for (int y = y0; y < y1; y++) {
+        std::fill_n(img.pixels.data() + (size_t)y * img.width + x0, (std::max)(x1 - x0, 0), color);
+    }
+}
+
+} // namespace
+
+void rasterizeChart(const std::vector<CandleData>& candles, int visibleBars,
+                    RasterImage& image, const RasterStyle& style)
+{
+    std::fill(image.pixels.begin(), image.pixels.end(), style.background);
+    if (candles.empty() || image.width <= 0 || image.height <= 0) return;
+
+    size_t count = (visibleBars > 0) ? (std::min)((size_t)visibleBars, candles.size()) : candles.size();
+    size_t first = candles.size() - count;
+
+    double minPrice = candles[first].low;
+    double maxPrice = candles[first].high;
+    double maxVolume = 0.0;
+    for (size_t i = first; i < candles.size(); i++) {
+        minPrice = (std::min)(minPrice, candles[i].low);
+        maxPrice = (std::max)(maxPrice, candles[i].high);
+        maxVolume = (std::max)(maxVolume, (double)candles[i].volume);
+    }
+    double pad = (maxPrice - minPrice) * 0.05;
+    if (pad <= 0.0) pad = 1.0;
+    minPrice -= pad;
+    maxPrice += pad;
+
+    const int volumeHeight = (int)(image.height * style.volumeFraction);
+    const int priceHeight = image.height - volumeHeight;
+    const double slot = (double)image.width / count;
+    const int halfBody = (std::max)(0, (int)(slot * style.bodyWidth * 0.5));
+    const double yScale = priceHeight / (maxPrice - minPrice);
+
+    auto priceToY = [&](double price) {
+        return (int)std::lround((maxPrice - price) * yScale);
+    };
+
+    for (size_t i = 0; i < count; i++) {
+        const CandleData& c = candles[first + i];
+        const bool up = c.close >= c.open;
+        const int cx = (int)((i + 0.5) * slot);
+
+        if (volumeHeight > 0 && maxVolume > 0.0) {
+            int h = (int)(volumeHeight * (c.volume / maxVolume));
+            fillRect(image, cx - halfBody, image.height - h, cx + halfBody + 1, image.height,
+                     up ? style.volumeUp : style.volumeDown);
+        }
+
+        fillRect(image, cx, priceToY(c.high), cx + 1, priceToY(c.low) + 1, style.wick);
+
+        int top = priceToY((std::max)(c.open, c.close));
+        int bottom = priceToY((std::min)(c.open, c.close));
+        fillRect(image, cx - halfBody, top, cx + halfBody + 1, (std::max)(bottom, top + 1),
+                 up ? style.up : style.down);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// PNG encoding. Rows use the Sub filter so flat background runs become
+// zeros, and the deflate stream is fixed-Huffman with distance-1 matches
+// (plain run-length). No zlib dependency, and charts compress well.
+// ---------------------------------------------------------------------------
+
+namespace {
+
+const std::array<uint32_t, 256>& crcTable()
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) crc = crcTable()[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+struct BitWriter {
+    std::vector<uint8_t>& out;
+    uint32_t buffer = 0;
+    int bits = 0;
+
+    void put(uint32_t value, int count)
+    {
+        buffer |= value << bits;
+        bits += count;
+        while (bits >= 8) {
+            out.push_back((uint8_t)buffer);
+            buffer >>= 8;
+            bits -= 8;
+        }
+    }
+
+    // Huffman codes are defined MSB-first
+    void putCode(uint32_t code, int count)
+    {
+        uint32_t reversed = 0;
+        for (int i = 0; i < count; i++) reversed |= ((code >> i) & 1u) << (count - 1 - i);
+        put(reversed, count);
+    }
+
+    void flush()
+    {
+        if (bits > 0) out.push_back((uint8_t)buffer);
+        buffer = 0;
+        bits = 0;
+    }
+};
+
+void putLiteral(BitWriter& bw, int sym)
+{
+    if (sym < 144) bw.putCode(0x30 + sym, 8);
+    else if (sym < 256) bw.putCode(0x190 + (sym - 144), 9);
+    else if (sym < 280) bw.putCode(sym - 256, 7);
+    else bw.putCode(0xC0 + (sym - 280), 8);
+}
+
+void putMatch(BitWriter& bw, int length)
+{
+    static const int base[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const int extra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    int code = 28;
+    while (base[code] > length) code--;
+    putLiteral(bw, 257 + code);
+    if (extra[code]) bw.put(length - base[code], extra[code]);
+    bw.putCode(0, 5);   // Distance code 0 = distance 1
+}
+
+void deflateRle(const std::vector<uint8_t>& in, std::vector<uint8_t>& out)
+{
+    out.push_back(0x78);    // zlib header: deflate, 32K window
+    out.push_back(0x01);
+
+    BitWriter bw{ out };
+    bw.put(1, 1);           // BFINAL
+    bw.put(1, 2);           // BTYPE = fixed Huffman
+
+    size_t i = 0;
+    while (i < in.size()) {
+        putLiteral(bw, in[i]);
+        size_t run = 0;
+        while (i + 1 + run < in.size() && in[i + 1 + run] == in[i] && run < 258) run++;
+        if (run >= 3) {
+            putMatch(bw, (int)run);
+            i += 1 + run;
+        }
+        else {
+            i++;
+        }
+    }
+    putLiteral(bw, 256);
+    bw.flush();
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : in) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    uint32_t adler = (b << 16) | a;
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back((uint8_t)(adler >> shift));
+}
+
+void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+{
+    uint32_t len = (uint32_t)data.size();
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back((uint8_t)(len >> shift));
+    size_t typeStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    uint32_t crc = crc32(out.data() + typeStart, out.size() - typeStart);
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back((uint8_t)(crc >> shift));
+}
+
+} // namespace
+
+bool encodePng(const RasterImage& image, std::vector<uint8_t>& out)
+{
+    if (image.width <= 0 || image.height <= 0) return false;
+
+    const size_t stride = (size_t)image.width * 4;
+    std::vector<uint8_t> filtered;
+    filtered.resize((stride + 1) * image.height);
+    for (int y = 0; y < image.height; y++) {
+        const uint8_t* row = reinterpret_cast<const uint8_t*>(image.pixels.data() + (size_t)y * image.width);
+        uint8_t* dst = filtered.data() + y * (stride + 1);
+        dst[0] = 1;     // Sub filter
+        for (size_t x = 0; x < stride; x++) {
+            dst[1 + x] = (uint8_t)(row[x] - (x >= 4 ? row[x - 4] : 0));
+        }
+    }
+
+    static const uint8_t signature[] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    out.assign(signature, signature + 8);
+
+    std::vector<uint8_t> header(13);
+    for (int i = 0; i < 4; i++) {
+        header[i] = (uint8_t)(image.width >> (24 - 8 * i));
+        header[4 + i] = (uint8_t)(image.height >> (24 - 8 * i));
+    }
+    header[8] = 8;      // Bit depth
+    header[9] = 6;      // RGBA
+    putChunk(out, "IHDR", header);
+
+    std::vector<uint8_t> compressed;
+    deflateRle(filtered, compressed);
+    putChunk(out, "IDAT", compressed);
+    putChunk(out, "IEND", {});
+    return true;
+}
+
+bool writePng(const std::string& filename, const RasterImage& image)
+{
+    std::vector<uint8_t> png;
+    if (!encodePng(image, png)) return false;
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+    file.write(reinterpret_cast<const char*>(png.data()), png.size());
+    return file.good();
+}
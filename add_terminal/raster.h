@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct CandleData;
+
+// CPU counterpart of renderChartToFBO. Draws candles, wicks and a volume
+// strip into an RGBA buffer so charts can be produced with no GPU/display.
+struct RasterImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;   // RGBA8, row 0 is the top of the image
+
+    void resize(int w, int h);
+};
+
+struct RasterStyle {
+    uint32_t background = 0xFF000000;
+    uint32_t up = 0xFF00FF00;       // Same colours as the GPU path
+    uint32_t down = 0xFF0000FF;
+    uint32_t wick = 0xFFFFFFFF;
+    uint32_t volumeUp = 0xFF006000;
+    uint32_t volumeDown = 0xFF000060;
+    float bodyWidth = 0.6f;         // Fraction of one bar slot
+    float volumeFraction = 0.2f;    // Height share of the volume strip, 0 to hide
+};
+
+// Pack r,g,b,a into the in-memory RGBA8 layout used by RasterImage
+inline uint32_t rasterColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+    return (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | ((uint32_t)a << 24);
+}
+
+// Draw the last `visibleBars` candles (0 = all) into `image`
+void rasterizeChart(const std::vector<CandleData>& candles, int visibleBars,
+                    RasterImage& image, const RasterStyle& style = RasterStyle());
+
+// Encode as PNG (Sub filter + run-length deflate). Returns false on I/O error.
+bool encodePng(const RasterImage& image, std::vector<uint8_t>& out);
+bool writePng(const std::string& filename, const RasterImage& image);
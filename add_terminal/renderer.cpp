@@ -1,8 +1,15 @@
 #include "renderer.h"
 #include "DataManager.h"
+#include "contracts.h"
+#include "memory_budget.h"
 #include "event.h"
+#include "profiler.h"
+#include "task_scheduler.h"
 
 #include <thread>
+#include <chrono>
+#include <cmath>
+#include <ctime>
 #include <unordered_map>
 
 
@@ -30,10 +37,12 @@ const char* fragmentShaderSource = "#version 330 core\n"
 Renderer::Renderer() {}
 
 Renderer::~Renderer() {
-    for (auto& [symbol, chart] : m_chartViews) {
+    for (auto& [id, chart] : m_chartViews) {
         chart.cleanup();
     }
     m_chartViews.clear();
+    m_grid.cleanup();
+    if (m_chartProgram) glDeleteProgram(m_chartProgram);
 }
 
 void Renderer::DisableTitleFocusColors() {
@@ -61,6 +70,14 @@ unsigned int Renderer::createShaderProgram() {
     return program;
 }
 
+GLuint Renderer::chartProgram() {
+    if (!m_chartProgram) {
+        m_chartProgram = createShaderProgram();
+        m_projectionLoc = glGetUniformLocation(m_chartProgram, "projection");
+    }
+    return m_chartProgram;
+}
+
 
 std::vector<float> Renderer::prepareCandleDataFromJson(const std::string& filename) {
     std::ifstream f(filename);
@@ -125,56 +142,6 @@ std::pair<GLuint, int>  Renderer::initCandleDataFromJson(std::string jsonFile) {
 }
 
 
-// New function: Prepare candle data from CandleData vector (from DataManager)
-// Returns both vertex data AND price range as a pair
-std::pair<std::vector<float>, std::pair<float, float>> Renderer::prepareCandleDataFromVector(const std::vector<CandleData>& candles) {
-    if (candles.empty()) return {{}, {1e9f, -1e9f}};
-
-    std::vector<float> wickData;
-    std::vector<float> bodyData;
-
-    // Calculate price range (local variables, not global!)
-    float localMinPrice = 1e9f;
-    float localMaxPrice = -1e9f;
-    for (const auto& candle : candles) {
-        localMinPrice = (std::min)(localMinPrice, (float)candle.low);
-        localMaxPrice = (std::max)(localMaxPrice, (float)candle.high);
-    }
-
-    int i = 0;
-    for (const auto& candle : candles) {
-        float o = (float)candle.open;
-        float h = (float)candle.high;
-        float l = (float)candle.low;
-        float c = (float)candle.close;
-        float x = (float)i;
-
-        // Color: green if close >= open, red otherwise
-        float r = (c >= o) ? 0.0f : 1.0f;
-        float g = (c >= o) ? 1.0f : 0.0f;
-
-        // Wick vertices (2 vertices per wick line)
-        //wickData.insert(wickData.end(), { x, h, r, g, 0.0f, x, l, r, g, 0.0f });//wick has the same color with bar
-        wickData.insert(wickData.end(), { x, h, 1.0f, 1.0f, 1.0f, x, l, 1.0f, 1.0f, 1.0f});// white wick
-
-        // Body vertices (6 vertices for 2 triangles = rectangle)
-        float top = (std::max)(o, c);
-        float bot = (std::min)(o, c);
-        float w = 0.3f; // body width
-        bodyData.insert(bodyData.end(), {
-            x - w, bot, r, g, 0.0f,  x + w, bot, r, g, 0.0f,  x + w, top, r, g, 0.0f,
-            x - w, bot, r, g, 0.0f,  x + w, top, r, g, 0.0f,  x - w, top, r, g, 0.0f
-        });
-        i++;
-    }
-
-    std::vector<float> totalData = wickData;
-    totalData.insert(totalData.end(), bodyData.begin(), bodyData.end());
-    return {totalData, {localMinPrice, localMaxPrice}};
-}
-
-
-
 void Renderer::createChartFrameBuffer(ChartView& chart, int w, int h)
 {
     chart.width = w;
@@ -203,33 +170,9 @@ void Renderer::createChartFrameBuffer(ChartView& chart, int w, int h)
 }
 
 
-// New function: Initialize candle data from pre-prepared vertex vector
-std::tuple<GLuint, GLuint, int> Renderer::initCandleDataFromVector(const std::vector<float>& candleVertices) {
-    if (candleVertices.empty()) return { 0, 0,0 };
-
-    // Setup VAO/VBO
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, candleVertices.size() * sizeof(float), candleVertices.data(), GL_STATIC_DRAW);
-
-    // Position attribute (2 floats: x, y)
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Color attribute (3 floats: r, g, b)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    int numCandles = candleVertices.size() / ((2 + 6) * 5); // 8 vertices total per candle (2 wick + 6 body)
-
-    return { VAO, VBO, numCandles };
-}
-
 void Renderer::renderChartToFBO(ChartView& chart, GLuint shaderProgram, GLuint VAO, int numCandles)
 {
+    PROFILE_ZONE("Renderer::renderChartToFBO");
     glBindFramebuffer(GL_FRAMEBUFFER, chart.fbo);
     glViewport(0, 0, chart.width, chart.height);
 
@@ -269,6 +212,76 @@ void Renderer::renderChartToFBO(ChartView& chart, GLuint shaderProgram, GLuint V
 
 
 }
+// The visible columns of the tick line at the view's zoom, right-aligned
+// on the newest print unless scrolled back. Only a rebuild touches the
+// prints, and it copies width columns out of the series' M4 pyramid.
+void Renderer::renderTicksToFBO(ChartView& chart, const TickSeries& series)
+{
+    PROFILE_ZONE("Renderer::renderTicksToFBO");
+    TickView& ticks = chart.ticks;
+    const size_t width = (size_t)(std::max)(chart.width, 1);
+
+    int zoom = ticks.zoom;
+    if (zoom < 0) {
+        zoom = 0;
+        while ((series.size() >> zoom) > width) zoom++;
+    }
+    const size_t span = (size_t)1 << zoom;
+    const size_t totalColumns = (series.size() + span - 1) / span;
+    ticks.scroll = (std::min)(ticks.scroll, totalColumns > width ? totalColumns - width : 0);
+    ticks.shownZoom = zoom;
+
+    if (ticks.builtRevision != series.revision() || ticks.builtZoom != zoom ||
+        ticks.builtScroll != ticks.scroll || ticks.builtWidth != (int)width) {
+        size_t firstColumn = totalColumns > width + ticks.scroll ? totalColumns - width - ticks.scroll : 0;
+        series.columns((unsigned)zoom, firstColumn, width, m_tickColumns);
+        tickLineVertices(m_tickColumns, m_tickVertices, ticks.minPrice, ticks.maxPrice);
+
+        if (ticks.vao == 0) {
+            glGenVertexArrays(1, &ticks.vao);
+            glGenBuffers(1, &ticks.vbo);
+            glBindVertexArray(ticks.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, ticks.vbo);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, kFloatsPerVertex * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, kFloatsPerVertex * sizeof(float), (void*)(2 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+            glBindVertexArray(0);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, ticks.vbo);
+        size_t bytes = m_tickVertices.size() * sizeof(float);
+        if (bytes > ticks.vboBytes) {
+            glBufferData(GL_ARRAY_BUFFER, bytes, m_tickVertices.data(), GL_DYNAMIC_DRAW);
+            ticks.vboBytes = bytes;
+        }
+        else if (bytes > 0) {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_tickVertices.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        ticks.vertices = (int)(m_tickVertices.size() / kFloatsPerVertex);
+        ticks.builtRevision = series.revision();
+        ticks.builtZoom = zoom;
+        ticks.builtScroll = ticks.scroll;
+        ticks.builtWidth = (int)width;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, chart.fbo);
+    glViewport(0, 0, chart.width, chart.height);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (ticks.vertices > 0) {
+        glUseProgram(chart.shaderProgram);
+        glBindVertexArray(ticks.vao);
+        // One unit per pixel column, so every column lands on its own pixel
+        float pad = (std::max)((ticks.maxPrice - ticks.minPrice) * 0.05f, 0.01f);
+        glm::mat4 projection = glm::ortho(0.0f, (float)chart.width, ticks.minPrice - pad, ticks.maxPrice + pad);
+        glUniformMatrix4fv(glGetUniformLocation(chart.shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glLineWidth(1.0f);
+        glDrawArrays(GL_LINE_STRIP, 0, ticks.vertices);
+        glBindVertexArray(0);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
 void Renderer::onScroll(double xoffset, double yoffset)
 {
     zoomLevel -= static_cast<float>(yoffset) * 4.0f;
@@ -338,7 +351,56 @@ void ScannerUI() {
 
 #include "DataManager.h"
 
-void Renderer::ScannerGUI(const ScannerResult& scanResults)
+namespace {
+
+// Pick up a changed sort spec. Returns true if the cache must be rebuilt,
+// either because of that or because the data moved on.
+bool tableCacheStale(TableCache& cache, uint64_t revision)
+{
+    bool stale = cache.revision != revision;
+    ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs();
+    if (specs && specs->SpecsDirty) {
+        cache.sortColumn = specs->SpecsCount > 0 ? specs->Specs[0].ColumnIndex : -1;
+        cache.ascending = specs->SpecsCount == 0 || specs->Specs[0].SortDirection != ImGuiSortDirection_Descending;
+        specs->SpecsDirty = false;
+        stale = true;
+    }
+    cache.revision = revision;
+    return stale;
+}
+
+// Rebuild the permutation with `less(a, b, column)` over source rows, then
+// format each row's cells once with `format(sourceRow, cellsOut)`
+template <typename Less, typename Format>
+void rebuildTableCache(TableCache& cache, int columns, size_t rowCount, Less less, Format format)
+{
+    cache.columns = columns;
+    cache.order.resize(rowCount);
+    for (size_t i = 0; i < rowCount; i++) cache.order[i] = (int)i;
+    if (cache.sortColumn >= 0) {
+        int column = cache.sortColumn;
+        bool ascending = cache.ascending;
+        std::stable_sort(cache.order.begin(), cache.order.end(), [&](int a, int b) {
+            return ascending ? less(a, b, column) : less(b, a, column);
+        });
+    }
+
+    cache.cells.resize(rowCount * columns);
+    for (size_t row = 0; row < rowCount; row++) {
+        format(cache.order[row], &cache.cells[row * columns]);
+    }
+}
+
+std::string formatNumber(const char* format, double value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), format, value);
+    return buffer;
+}
+
+} // namespace
+
+void Renderer::ScannerGUI(const ScannerResult& scanResults, uint64_t revision)
 {
     ImGui::Begin("Market Scanner Results");
 
@@ -347,48 +409,70 @@ void Renderer::ScannerGUI(const ScannerResult& scanResults)
     ImGui::Text("Total Results: %zu", scanResults.items.size());
     ImGui::Separator();
 
-    if (ImGui::BeginTable("ScannerTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+    if (ImGui::BeginTable("ScannerTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Sortable)) {
         // Setup columns
-        ImGui::TableSetupColumn("Rank", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Rank", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_DefaultSort, 50.0f);
         ImGui::TableSetupColumn("Symbol", ImGuiTableColumnFlags_WidthFixed, 80.0f);
         ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, 60.0f);
         ImGui::TableSetupColumn("Currency", ImGuiTableColumnFlags_WidthFixed, 70.0f);
         ImGui::TableSetupColumn("Contract ID", ImGuiTableColumnFlags_WidthStretch);
         ImGui::TableHeadersRow();
 
-        // Display each result
-        for (const auto& item : scanResults.items) {
-            ImGui::TableNextRow();
-
-            // Invisible selectable spanning all columns for row-level hover/click
-            ImGui::TableSetColumnIndex(0);
-            ImGui::PushID(item.rank);  // Unique ID per row
-            bool rowClicked = ImGui::Selectable("##row", false, 
-                ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowOverlap);
-            ImGui::PopID();
-
-            // Render actual content over the selectable
-            ImGui::SameLine();
-            ImGui::Text("%d", item.rank);
-
-            ImGui::TableSetColumnIndex(1);
-            ImGui::Text("%s", item.symbol.c_str());
-
-            ImGui::TableSetColumnIndex(2);
-            ImGui::Text("%s", item.secType.c_str());
-
-            ImGui::TableSetColumnIndex(3);
-            ImGui::Text("%s", item.currency.c_str());
+        const auto& items = scanResults.items;
+        if (tableCacheStale(m_scannerTable, revision)) {
+            rebuildTableCache(m_scannerTable, 5, items.size(),
+                [&](int a, int b, int column) {
+                    const ScannerResultItem& x = items[a];
+                    const ScannerResultItem& y = items[b];
+                    switch (column) {
+                    case 1: return SymbolTable::name(x.symbol) < SymbolTable::name(y.symbol);
+                    case 2: return x.secType < y.secType;
+                    case 3: return x.currency < y.currency;
+                    case 4: return x.conId < y.conId;
+                    default: return x.rank < y.rank;
+                    }
+                },
+                [&](int source, std::string* cells) {
+                    const ScannerResultItem& item = items[source];
+                    cells[0] = std::to_string(item.rank);
+                    cells[1] = SymbolTable::name(item.symbol);
+                    cells[2] = item.secType;
+                    cells[3] = item.currency;
+                    cells[4] = std::to_string(item.conId);
+                });
+        }
 
-            ImGui::TableSetColumnIndex(4);
-            ImGui::Text("%ld", item.conId);
+        // Display only the visible results
+        ImGuiListClipper clipper;
+        clipper.Begin((int)m_scannerTable.order.size());
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                const ScannerResultItem& item = items[m_scannerTable.order[row]];
+                ImGui::TableNextRow();
 
-            // Optional: Handle row click
-            if (rowClicked) {
-                printf("Clicked row: %s\n", item.symbol.c_str());
-                if (onScannerRowClicked) {
-                    onScannerRowClicked(item.symbol);
-				}
+                // Invisible selectable spanning all columns for row-level hover/click
+                ImGui::TableSetColumnIndex(0);
+                ImGui::PushID(row);  // Unique ID per row
+                bool rowClicked = ImGui::Selectable("##row", false,
+                    ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowOverlap);
+                ImGui::PopID();
+
+                // Render actual content over the selectable
+                ImGui::SameLine();
+                ImGui::TextUnformatted(m_scannerTable.cell(row, 0).c_str());
+                for (int column = 1; column < 5; column++) {
+                    ImGui::TableSetColumnIndex(column);
+                    ImGui::TextUnformatted(m_scannerTable.cell(row, column).c_str());
+                }
+
+                // Optional: Handle row click
+                if (rowClicked) {
+                    printf("Clicked row: %s\n", symbolName(item.symbol));
+                    if (onScannerRowClicked) {
+                        onScannerRowClicked(item.symbol);
+                    }
+                }
             }
         }
 
@@ -484,15 +568,11 @@ void Renderer::DrawChartGUI(DataManager& dataManager)
 {
     // Display charts from DataManager
     for (auto& [symbol, chartData] : dataManager.charts) {
-        // Create chart if it doesn't exist
-        if (m_chartViews.find(symbol) == m_chartViews.end()) {
-            m_chartViews[symbol] = createChartFromData(symbol, chartData.candles);
-        }
-
+        ChartView& view = chartViewFor(symbol, dataManager);
 
         // Only display if visible
-        if (m_chartViews[symbol].isVisible) {
-            CreateChartView(m_chartViews[symbol]);
+        if (view.isVisible) {
+            CreateChartView(view, symbol, dataManager);
         }
     }
 }
@@ -521,7 +601,7 @@ void Renderer::TabTest(DataManager& dataManager)
     ImGui::Begin("MainWorkspace", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize);
     if (currentLayout == MARKET_OVERVIEW) {
         //RenderMarketLayout(); // Your charts/scanners
-        ScannerGUI(dataManager.currentScannerResult);
+        ScannerGUI(dataManager.currentScannerResult, dataManager.scannerRevision);
     }
     else if (currentLayout == TRADING_VIEW) {
         DrawChartGUI(dataManager); // Your charts
@@ -554,34 +634,422 @@ void Renderer::RenderTradingWindows(DataManager& dataManager)
 	// the same base name in different tabs without conflicts.
 
 	// Chart Window - display active symbol
-	std::string symbol = dataManager.activeSymbol;
-	if (!symbol.empty() && dataManager.charts.find(symbol) != dataManager.charts.end()) {
-		if (m_chartViews.find(symbol) == m_chartViews.end()) {
-			m_chartViews[symbol] = createChartFromData(symbol, dataManager.charts[symbol].candles);
-		}
-		if (m_chartViews[symbol].isVisible) {
-			CreateChartView(m_chartViews[symbol]);  // This window will dock in Trading tab
+	SymbolId symbol = dataManager.activeSymbol;
+	if (symbol != kNoSymbol && dataManager.charts.find(symbol) != dataManager.charts.end()) {
+		ChartView& view = chartViewFor(symbol, dataManager);
+		if (view.isVisible) {
+			CreateChartView(view, symbol, dataManager);  // This window will dock in Trading tab
 		}
 	}
+	drawExtraChartViews(dataManager);
 
 	// Order Entry Window
 	// This window will ONLY be visible and dockable in the Trading tab
-	static int quantity = 100;
-	static char orderSymbol[64] = "";
+	OrderEntryGUI(dataManager);
+
+	// Market Depth Window
+	// Another window exclusive to the Trading tab
+	MarketDepthGUI(dataManager);
+
+	TimeAndSalesGUI(dataManager);
+
+	WatchlistGUI(dataManager);
+}
+
+void Renderer::WatchlistGUI(DataManager& dataManager)
+{
+	PROFILE_ZONE("Renderer::WatchlistGUI");
+	ImGui::Begin("Watchlist##Trading");
+	Watchlist& watchlist = dataManager.watchlist;
+
+	ImGui::SetNextItemWidth(200.0f);
+	bool submit = ImGui::InputTextWithHint("##WatchlistAdd", "AAPL MSFT ...", m_watchlistInput, sizeof(m_watchlistInput),
+		ImGuiInputTextFlags_CharsUppercase | ImGuiInputTextFlags_EnterReturnsTrue);
+	ImGui::SameLine();
+	if ((ImGui::Button("Add##Watchlist") || submit) && m_watchlistInput[0] != '\0' && onWatchlistAdd) {
+		onWatchlistAdd(m_watchlistInput);
+		m_watchlistInput[0] = '\0';
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Add scanner") && onWatchlistAdd) {
+		for (const ScannerResultItem& item : dataManager.currentScannerResult.items) {
+			onWatchlistAdd(SymbolTable::name(item.symbol));
+		}
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Clear##Watchlist") && onWatchlistClear) {
+		onWatchlistClear();
+	}
+	ImGui::SameLine();
+	ImGui::Checkbox("Flash", &m_watchlistFlash);
+
+	uint64_t now = Profiler::now();
+	if (m_watchlistSimulate) {
+		float ticks = ImGui::GetIO().DeltaTime * m_watchlistTickRate * (float)watchlist.size();
+		watchlist.simulate((size_t)ticks + 1, now);
+	}
+	{
+		PROFILE_ZONE("Watchlist::formatDirty");
+		m_watchlistFormatted = watchlist.formatDirty();
+	}
+	ImGui::Text("%zu symbols, %zu rows updated", watchlist.size(), m_watchlistFormatted);
+
+	if (ImGui::BeginTable("Watchlist", Watchlist::ColumnCount,
+		ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable)) {
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Symbol");
+		ImGui::TableSetupColumn("Last");
+		ImGui::TableSetupColumn("Chg%");
+		ImGui::TableSetupColumn("Bid");
+		ImGui::TableSetupColumn("Ask");
+		ImGui::TableSetupColumn("Volume");
+		ImGui::TableHeadersRow();
+
+		// Cells are pre-formatted; a visible row is just six text copies
+		ImGuiListClipper clipper;
+		clipper.Begin((int)watchlist.size());
+		while (clipper.Step()) {
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+				const Watchlist::Row& row = watchlist.row(i);
+				ImGui::TableNextRow();
+
+				ImGui::TableSetColumnIndex(Watchlist::Symbol);
+				if (ImGui::Selectable(row.cells[Watchlist::Symbol], false, ImGuiSelectableFlags_SpanAllColumns) && onWatchlistRowClicked) {
+					onWatchlistRowClicked(row.symbol);
+				}
+				for (int column = Watchlist::Last; column < Watchlist::ColumnCount; column++) {
+					ImGui::TableSetColumnIndex(column);
+					uint64_t age = now - row.flashNs[column];
+					if (m_watchlistFlash && row.flashDirection[column] != 0 && age < Watchlist::kFlashNs) {
+						int alpha = (int)(160 * (1.0 - (double)age / Watchlist::kFlashNs));
+						ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, row.flashDirection[column] > 0
+							? IM_COL32(0, 140, 0, alpha) : IM_COL32(160, 0, 0, alpha));
+					}
+					if (column == Watchlist::Change) {
+						double change = row.changePercent();
+						ImVec4 color = change > 0.0 ? ImVec4(0.3f, 0.9f, 0.3f, 1.0f)
+							: (change < 0.0 ? ImVec4(0.95f, 0.35f, 0.35f, 1.0f) : ImVec4(0.8f, 0.8f, 0.8f, 1.0f));
+						ImGui::TextColored(color, "%s", row.cells[column]);
+					}
+					else {
+						ImGui::TextUnformatted(row.cells[column]);
+					}
+				}
+			}
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::CollapsingHeader("Diagnostics")) {
+		if (ImGui::Button("Add 1000 simulated rows")) {
+			// Negative reqIds: never subscribed, skipped by snapshot and clear
+			int base = (int)watchlist.size();
+			for (int i = 0; i < 1000; i++) {
+				char name[16];
+				snprintf(name, sizeof(name), "SIM%04d", base + i);
+				watchlist.add(SymbolTable::intern(name), -(base + i + 1));
+			}
+		}
+		ImGui::Checkbox("Simulate the open", &m_watchlistSimulate);
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(120.0f);
+		ImGui::SliderFloat("ticks/row/s", &m_watchlistTickRate, 1.0f, 20.0f, "%.0f");
+	}
+	ImGui::End();
+}
+
+void Renderer::TimeAndSalesGUI(DataManager& dataManager)
+{
+	ImGui::Begin("Time & Sales##Trading");
+
+	if (m_tapeSymbol[0] == '\0' && dataManager.activeSymbol != kNoSymbol) {
+		snprintf(m_tapeSymbol, sizeof(m_tapeSymbol), "%s", symbolName(dataManager.activeSymbol));
+	}
+	ImGui::SetNextItemWidth(100.0f);
+	bool submit = ImGui::InputText("##TapeSymbol", m_tapeSymbol, sizeof(m_tapeSymbol),
+		ImGuiInputTextFlags_CharsUppercase | ImGuiInputTextFlags_EnterReturnsTrue);
+	ImGui::SameLine();
+	if ((ImGui::Button("Subscribe##Tape") || submit) && m_tapeSymbol[0] != '\0' && onTapeRequested) {
+		onTapeRequested(m_tapeSymbol);
+	}
+
+	ImGui::SetNextItemWidth(80.0f);
+	ImGui::InputDouble("Min size", &m_tapeFilter.minSize, 0.0, 0.0, "%.0f");
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(80.0f);
+	ImGui::InputDouble("Min px", &m_tapeFilter.minPrice, 0.0, 0.0, "%.2f");
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(80.0f);
+	ImGui::InputDouble("Max px", &m_tapeFilter.maxPrice, 0.0, 0.0, "%.2f");
+
+	auto tapeIt = dataManager.tapes.find(dataManager.tapeSymbol);
+	if (tapeIt == dataManager.tapes.end()) {
+		ImGui::Text("No tape subscription");
+		ImGui::End();
+		return;
+	}
+	TradeTape& tape = tapeIt->second;
+	tape.setFilter(m_tapeFilter);   // No-op unless the filter changed
+	ImGui::Text("%s  %zu shown / %llu prints", symbolName(dataManager.tapeSymbol),
+		tape.filteredSize(), (unsigned long long)tape.totalPrints());
+
+	if (ImGui::BeginTable("Tape", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Time");
+		ImGui::TableSetupColumn("Price");
+		ImGui::TableSetupColumn("Size");
+		ImGui::TableSetupColumn("Exch");
+		ImGui::TableHeadersRow();
+
+		// Newest on top; only the visible rows are laid out
+		ImGuiListClipper clipper;
+		clipper.Begin((int)tape.filteredSize());
+		while (clipper.Step()) {
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+				const TradePrint& print = tape.newestFiltered(row);
+				ImGui::TableNextRow();
+
+				ImGui::TableSetColumnIndex(0);
+				std::time_t t = (std::time_t)print.time;
+				std::tm tm;
+#if defined(_WIN32)
+				localtime_s(&tm, &t);
+#else
+				localtime_r(&t, &tm);
+#endif
+				ImGui::Text("%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
+
+				ImVec4 color = print.direction > 0 ? ImVec4(0.3f, 0.9f, 0.3f, 1.0f)
+					: (print.direction < 0 ? ImVec4(0.95f, 0.35f, 0.35f, 1.0f) : ImVec4(0.8f, 0.8f, 0.8f, 1.0f));
+				ImGui::TableSetColumnIndex(1);
+				ImGui::TextColored(color, "%.2f", print.price);
+				ImGui::TableSetColumnIndex(2);
+				ImGui::TextColored(color, "%.0f", print.size);
+				ImGui::TableSetColumnIndex(3);
+				ImGui::TextUnformatted(print.exchange);
+			}
+		}
+		ImGui::EndTable();
+	}
+	ImGui::End();
+}
+
+namespace {
+
+// Median and 99th percentile of a latency history, in microseconds
+void latencySummary(std::vector<float>& samples, float& p50, float& p99)
+{
+	p50 = p99 = 0.0f;
+	if (samples.empty()) return;
+	std::vector<float> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+	p50 = sorted[sorted.size() / 2];
+	p99 = sorted[(std::min)(sorted.size() - 1, sorted.size() * 99 / 100)];
+}
+
+} // namespace
+
+void Renderer::OrderEntryGUI(DataManager& dataManager)
+{
 	ImGui::Begin("Order Entry##Trading");  // ##Trading makes ID unique to this tab
 	ImGui::Text("Quick Trade");
-	ImGui::InputText("Symbol", orderSymbol, 64);
-	ImGui::InputInt("Quantity", &quantity);
-	if (ImGui::Button("Buy")) { /* TODO: Implement order */ }
+
+	if (m_orderSymbol[0] == '\0' && dataManager.activeSymbol != kNoSymbol) {
+		snprintf(m_orderSymbol, sizeof(m_orderSymbol), "%s", symbolName(dataManager.activeSymbol));
+	}
+	ImGui::InputText("Symbol", m_orderSymbol, sizeof(m_orderSymbol), ImGuiInputTextFlags_CharsUppercase);
+
+	// Edit one template; the sell side mirrors it. Validation happens here,
+	// on edit, so a click goes straight to the socket.
+	static const char* orderTypes[] = { "LMT", "MKT" };
+	static const char* tifs[] = { "DAY", "IOC", "GTC" };
+	OrderTemplate& tmpl = m_buyTemplate;
+	int quantity = (int)tmpl.quantity;
+	int typeIndex = tmpl.orderType == "MKT" ? 1 : 0;
+	int tifIndex = tmpl.tif == "IOC" ? 1 : (tmpl.tif == "GTC" ? 2 : 0);
+	bool edited = m_buyTemplate.name.empty();
+	edited |= ImGui::InputInt("Quantity", &quantity);
+	edited |= ImGui::Combo("Type", &typeIndex, orderTypes, IM_ARRAYSIZE(orderTypes));
+	if (typeIndex == 0) {
+		edited |= ImGui::InputInt("Offset (ticks)", &tmpl.limitOffsetTicks);
+	}
+	edited |= ImGui::Combo("TIF", &tifIndex, tifs, IM_ARRAYSIZE(tifs));
+	edited |= ImGui::Checkbox("Outside RTH", &tmpl.outsideRth);
+
+	if (edited) {
+		tmpl.quantity = quantity;
+		tmpl.orderType = orderTypes[typeIndex];
+		tmpl.tif = tifs[tifIndex];
+		tmpl.action = "BUY";
+		tmpl.name = "Buy";
+		m_sellTemplate = tmpl;
+		m_sellTemplate.action = "SELL";
+		m_sellTemplate.name = "Sell";
+		tmpl.validate(m_orderTemplateError);
+	}
+
+	bool ready = m_orderTemplateError.empty() && m_orderSymbol[0] != '\0' && onOrderRequested;
+	ImGui::BeginDisabled(!ready);
+	ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.1f, 0.5f, 0.1f, 1.0f));
+	if (ImGui::Button("Buy", ImVec2(80, 0))) {
+		m_orderError.clear();
+		onOrderRequested(m_orderSymbol, m_buyTemplate, m_orderError);
+	}
+	ImGui::PopStyleColor();
 	ImGui::SameLine();
-	if (ImGui::Button("Sell")) { /* TODO: Implement order */ }
+	ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.6f, 0.1f, 0.1f, 1.0f));
+	if (ImGui::Button("Sell", ImVec2(80, 0))) {
+		m_orderError.clear();
+		onOrderRequested(m_orderSymbol, m_sellTemplate, m_orderError);
+	}
+	ImGui::PopStyleColor();
+	ImGui::EndDisabled();
+
+	const std::string& error = !m_orderTemplateError.empty() ? m_orderTemplateError : m_orderError;
+	if (!error.empty()) {
+		ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
+		ImGui::TextWrapped("%s", error.c_str());
+		ImGui::PopStyleColor();
+	}
+
+	// Latency: click -> placeOrder written to the socket, and socket -> first
+	// reply (status, execution or reject) seen by the IB thread
+	float p50 = 0.0f, p99 = 0.0f;
+	dataManager.orders.clickToWire(m_latencySamples);
+	latencySummary(m_latencySamples, p50, p99);
+	ImGui::Text("Click to wire: p50 %.0f us  p99 %.0f us", p50, p99);
+	dataManager.orders.wireToAck(m_latencySamples);
+	latencySummary(m_latencySamples, p50, p99);
+	ImGui::Text("Wire to ack:   p50 %.0f us  p99 %.0f us", p50, p99);
+	if (!m_latencySamples.empty()) {
+		ImGui::PlotLines("##WireToAck", m_latencySamples.data(), (int)m_latencySamples.size(),
+			0, nullptr, 0.0f, FLT_MAX, ImVec2(-FLT_MIN, 40));
+	}
+
+	ImGui::Separator();
+	if (ImGui::BeginTable("Orders", 9, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+		ImGui::TableSetupColumn("Id");
+		ImGui::TableSetupColumn("Symbol");
+		ImGui::TableSetupColumn("Side");
+		ImGui::TableSetupColumn("Qty");
+		ImGui::TableSetupColumn("Price");
+		ImGui::TableSetupColumn("State");
+		ImGui::TableSetupColumn("Filled");
+		ImGui::TableSetupColumn("Ack (us)");
+		ImGui::TableSetupColumn("");
+		ImGui::TableHeadersRow();
+
+		// Newest first
+		const auto& orders = dataManager.orders.orders();
+		for (auto it = orders.rbegin(); it != orders.rend(); ++it) {
+			const OrderRecord& order = it->second;
+			ImGui::TableNextRow();
+			ImGui::TableSetColumnIndex(0);
+			ImGui::Text("%d", order.orderId);
+			ImGui::TableSetColumnIndex(1);
+			ImGui::Text("%s", symbolName(order.symbol));
+			ImGui::TableSetColumnIndex(2);
+			ImGui::Text("%s", order.action.c_str());
+			ImGui::TableSetColumnIndex(3);
+			ImGui::Text("%.0f", order.quantity);
+			ImGui::TableSetColumnIndex(4);
+			if (order.orderType == "LMT") ImGui::Text("%.2f", order.limitPrice);
+			else ImGui::Text("%s", order.orderType.c_str());
+			ImGui::TableSetColumnIndex(5);
+			ImGui::Text("%s", orderPhaseName(order.phase));
+			if (!order.message.empty() && ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("%s", order.message.c_str());
+			}
+			ImGui::TableSetColumnIndex(6);
+			ImGui::Text("%.0f @ %.2f", order.filled, order.avgFillPrice);
+			ImGui::TableSetColumnIndex(7);
+			if (order.ackNs != 0) ImGui::Text("%.0f", (order.ackNs - order.wireNs) / 1000.0);
+			ImGui::TableSetColumnIndex(8);
+			if (!order.isTerminal() && order.phase != OrderPhase::PendingCancel && onCancelRequested) {
+				ImGui::PushID(order.orderId);
+				if (ImGui::SmallButton("Cancel")) onCancelRequested(order.orderId);
+				ImGui::PopID();
+			}
+		}
+		ImGui::EndTable();
+	}
 	ImGui::End();
+}
 
-	// Market Depth Window
-	// Another window exclusive to the Trading tab
+void Renderer::MarketDepthGUI(DataManager& dataManager)
+{
 	ImGui::Begin("Market Depth##Trading");
-	ImGui::Text("Market depth data will be displayed here");
-	// TODO: Display market depth from dataManager
+
+	if (m_depthSymbol[0] == '\0' && dataManager.activeSymbol != kNoSymbol) {
+		snprintf(m_depthSymbol, sizeof(m_depthSymbol), "%s", symbolName(dataManager.activeSymbol));
+	}
+	ImGui::SetNextItemWidth(100.0f);
+	bool submit = ImGui::InputText("##DepthSymbol", m_depthSymbol, sizeof(m_depthSymbol),
+		ImGuiInputTextFlags_CharsUppercase | ImGuiInputTextFlags_EnterReturnsTrue);
+	ImGui::SameLine();
+	if ((ImGui::Button("Subscribe") || submit) && m_depthSymbol[0] != '\0' && onDepthRequested) {
+		onDepthRequested(m_depthSymbol);
+	}
+
+	auto bookIt = dataManager.orderBooks.find(dataManager.depthSymbol);
+	if (bookIt == dataManager.orderBooks.end()) {
+		ImGui::Text("No depth subscription");
+		ImGui::End();
+		return;
+	}
+	const OrderBook& book = bookIt->second;
+	ImGui::SameLine();
+	ImGui::Text("%s  (%llu updates)", symbolName(dataManager.depthSymbol), (unsigned long long)book.updateCount());
+
+	if (!book.hasBid() && !book.hasAsk()) {
+		ImGui::Text("Waiting for depth...");
+		ImGui::End();
+		return;
+	}
+
+	// Ladder centred on the touch, read straight from the price-level array
+	const int halfRows = 20;
+	int64_t centre = book.hasBid() && book.hasAsk() ? (book.bestBidTick() + book.bestAskTick() + 1) / 2
+		: (book.hasBid() ? book.bestBidTick() : book.bestAskTick());
+
+	if (ImGui::BeginTable("DepthLadder", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+		ImGui::TableSetupColumn("Bid Size", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableSetupColumn("Price", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+		ImGui::TableSetupColumn("Ask Size", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableHeadersRow();
+
+		for (int64_t tick = centre + halfRows; tick >= centre - halfRows; tick--) {
+			double bid = book.bidSizeAt(tick);
+			double ask = book.askSizeAt(tick);
+			ImGui::TableNextRow();
+
+			ImGui::TableSetColumnIndex(0);
+			if (bid > 0.0) {
+				ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(0, 90, 0, 255));
+				ImGui::Text("%.0f", bid);
+			}
+
+			ImGui::TableSetColumnIndex(1);
+			ImGui::Text("%.2f", book.toPrice(tick));
+
+			ImGui::TableSetColumnIndex(2);
+			if (ask > 0.0) {
+				ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(110, 0, 0, 255));
+				ImGui::Text("%.0f", ask);
+			}
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::CollapsingHeader("Diagnostics")) {
+		if (ImGui::Button("Replay 1M depth updates")) {
+			m_depthBenchmark = OrderBook::benchmarkReplay(1000000);
+		}
+		if (m_depthBenchmark > 0.0) {
+			ImGui::SameLine();
+			ImGui::Text("%.2f M updates/s", m_depthBenchmark / 1e6);
+		}
+	}
 	ImGui::End();
 }
 void Renderer::RenderAnalysisWindows(DataManager& dataManager)
@@ -591,7 +1059,7 @@ void Renderer::RenderAnalysisWindows(DataManager& dataManager)
     // They have their own docking layout within the "AnalysisDockSpace"
 
     // Scanner Results - shows market scanner data
-    ScannerGUI(dataManager.currentScannerResult);
+    ScannerGUI(dataManager.currentScannerResult, dataManager.scannerRevision);
 
     // Technical Indicators Window
     ImGui::Begin("Technical Indicators##Analysis");  // ##Analysis for unique ID
@@ -606,16 +1074,105 @@ void Renderer::RenderAnalysisWindows(DataManager& dataManager)
     ImGui::End();
 
     // Strategy Editor Window
-    ImGui::Begin("Strategy Editor##Analysis");
-    ImGui::Text("Strategy development");
-    // TODO: Code editor for creating trading strategies
-    ImGui::End();
+    StrategyEditor(dataManager);
 
     // ========== KEY POINT ==========
     // Even though we're calling ImGui::Begin() just like in RenderTradingWindows(),
     // these windows will dock into the ANALYSIS tab's dockspace, not the Trading tab!
     // This is because they're created INSIDE the "Analysis" BeginTabItem() block.
 }
+void Renderer::StrategyEditor(DataManager& dataManager)
+{
+    ImGui::Begin("Strategy Editor##Analysis");
+    ImGui::Text("Signal expression");
+    ImGui::TextDisabled("columns: open high low close volume | sma ema rsi highest lowest abs | and or not");
+    ImGui::InputTextMultiline("##StrategySource", m_strategySource, sizeof(m_strategySource),
+        ImVec2(-FLT_MIN, ImGui::GetTextLineHeight() * 4));
+
+    if (ImGui::Button("Compile")) {
+        m_strategy.compile(m_strategySource, m_strategyError);
+        m_strategyMatches.clear();
+        m_strategySignalCount = 0;
+        m_strategyBarsPerSec = 0.0;
+    }
+
+    if (!m_strategyError.empty()) {
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
+        ImGui::TextWrapped("%s", m_strategyError.c_str());
+        ImGui::PopStyleColor();
+    }
+
+    if (!m_strategy.isValid()) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Screen")) {
+        // Evaluate the last bar of every loaded chart. Evicted charts are
+        // read where they are rather than restored.
+        m_strategyMatches.clear();
+        std::vector<CandleData> spilled;
+        for (const auto& [symbol, chartData] : dataManager.charts) {
+            SeriesColumns columns;
+            if (chartData.tier == CandleTier::Compressed) columns = SeriesColumns::fromSeries(chartData.compressed);
+            else if (chartData.tier == CandleTier::Resident) columns = SeriesColumns::fromCandles(chartData.candles);
+            else if (readCandles(chartData, spilled)) columns = SeriesColumns::fromCandles(spilled);
+            double value = m_strategy.evaluateLast(columns, m_strategyScratch);
+            if (!std::isnan(value) && (m_strategy.resultType() != ExprType::Bool || value != 0.0)) {
+                m_strategyMatches.push_back(symbol);
+            }
+        }
+    }
+
+    auto chartIt = dataManager.charts.find(dataManager.activeSymbol);
+    ImGui::SameLine();
+    ImGui::BeginDisabled(chartIt == dataManager.charts.end());
+    if (ImGui::Button("Backtest")) {
+        // Count signal bars over the whole active series
+        SeriesColumns columns = SeriesColumns::fromCandles(residentCandles(dataManager, dataManager.activeSymbol));
+        std::vector<double> result;
+        m_strategy.evaluate(columns, result, m_strategyScratch);
+        m_strategySignalCount = std::count_if(result.begin(), result.end(), [](double v) { return v != 0.0 && !std::isnan(v); });
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Benchmark")) {
+        // Re-evaluate the active series for ~250 ms on this thread
+        SeriesColumns columns = SeriesColumns::fromCandles(residentCandles(dataManager, dataManager.activeSymbol));
+        std::vector<double> result;
+        size_t bars = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed{};
+        do {
+            m_strategy.evaluate(columns, result, m_strategyScratch);
+            bars += columns.size();
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < 0.25 && columns.size() > 0);
+        m_strategyBarsPerSec = elapsed.count() > 0.0 ? bars / elapsed.count() : 0.0;
+    }
+    ImGui::EndDisabled();
+
+    ImGui::Separator();
+    ImGui::Text("Result: %s, lookback %d bars",
+        m_strategy.resultType() == ExprType::Bool ? "condition" : "number", m_strategy.lookback());
+    if (chartIt != dataManager.charts.end()) {
+        ImGui::Text("%s: %zu signal bars of %zu", symbolName(dataManager.activeSymbol),
+            m_strategySignalCount, barCount(chartIt->second));
+    }
+    if (m_strategyBarsPerSec > 0.0) {
+        ImGui::Text("Throughput: %.1f M bars/s (1 core)", m_strategyBarsPerSec / 1e6);
+    }
+    if (!m_strategyMatches.empty()) {
+        ImGui::Text("Screen matches (%zu):", m_strategyMatches.size());
+        for (const auto& symbol : m_strategyMatches) {
+            if (ImGui::Selectable(symbolName(symbol)) && onScannerRowClicked) {
+                onScannerRowClicked(symbol);
+            }
+        }
+    }
+    ImGui::End();
+}
+
 void Renderer::Portfolio(DataManager& dataManager)
 {
     // ========== Portfolio Tab Windows ==========
@@ -670,9 +1227,10 @@ void Renderer::Portfolio(DataManager& dataManager)
     ImGui::Separator();
 
     if (ImGui::BeginTable("PositionsTable", 7, 
-        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Sortable)) {
         // Setup columns
-        ImGui::TableSetupColumn("Symbol", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Symbol", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_DefaultSort, 80.0f);
         ImGui::TableSetupColumn("Position", ImGuiTableColumnFlags_WidthFixed, 80.0f);
         ImGui::TableSetupColumn("Avg Cost", ImGuiTableColumnFlags_WidthFixed, 80.0f);
         ImGui::TableSetupColumn("Mkt Price", ImGuiTableColumnFlags_WidthFixed, 80.0f);
@@ -681,42 +1239,55 @@ void Renderer::Portfolio(DataManager& dataManager)
         ImGui::TableSetupColumn("Real P&L", ImGuiTableColumnFlags_WidthFixed, 100.0f);
         ImGui::TableHeadersRow();
 
-        for (const auto& pos : dataManager.accountData.positions) {
-            ImGui::TableNextRow();
-
-            ImGui::TableSetColumnIndex(0);
-            ImGui::Text("%s", pos.symbol.c_str());
-
-            ImGui::TableSetColumnIndex(1);
-            ImGui::Text("%.0f", pos.position);
-
-            ImGui::TableSetColumnIndex(2);
-            ImGui::Text("%.2f", pos.averageCost);
+        const auto& positions = dataManager.accountData.positions;
+        if (tableCacheStale(m_positionsTable, dataManager.accountData.positionsRevision)) {
+            rebuildTableCache(m_positionsTable, 7, positions.size(),
+                [&](int a, int b, int column) {
+                    const PositionUpdate& x = positions[a];
+                    const PositionUpdate& y = positions[b];
+                    switch (column) {
+                    case 1: return x.position < y.position;
+                    case 2: return x.averageCost < y.averageCost;
+                    case 3: return x.marketPrice < y.marketPrice;
+                    case 4: return x.marketValue < y.marketValue;
+                    case 5: return x.unrealizedPNL < y.unrealizedPNL;
+                    case 6: return x.realizedPNL < y.realizedPNL;
+                    default: return SymbolTable::name(x.symbol) < SymbolTable::name(y.symbol);
+                    }
+                },
+                [&](int source, std::string* cells) {
+                    const PositionUpdate& pos = positions[source];
+                    cells[0] = SymbolTable::name(pos.symbol);
+                    cells[1] = formatNumber("%.0f", pos.position);
+                    cells[2] = formatNumber("%.2f", pos.averageCost);
+                    cells[3] = formatNumber("%.2f", pos.marketPrice);
+                    cells[4] = formatNumber("%.2f", pos.marketValue);
+                    cells[5] = formatNumber("%.2f", pos.unrealizedPNL);
+                    cells[6] = formatNumber("%.2f", pos.realizedPNL);
+                });
+        }
 
-            ImGui::TableSetColumnIndex(3);
-            ImGui::Text("%.2f", pos.marketPrice);
+        const ImVec4 profit(0.0f, 1.0f, 0.0f, 1.0f);
+        const ImVec4 loss(1.0f, 0.0f, 0.0f, 1.0f);
+        ImGuiListClipper clipper;
+        clipper.Begin((int)m_positionsTable.order.size());
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                const PositionUpdate& pos = positions[m_positionsTable.order[row]];
+                ImGui::TableNextRow();
 
-            ImGui::TableSetColumnIndex(4);
-            ImGui::Text("%.2f", pos.marketValue);
+                for (int column = 0; column < 5; column++) {
+                    ImGui::TableSetColumnIndex(column);
+                    ImGui::TextUnformatted(m_positionsTable.cell(row, column).c_str());
+                }
 
-            ImGui::TableSetColumnIndex(5);
-            // Color code P&L: green for profit, red for loss
-            if (pos.unrealizedPNL >= 0) {
-                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.0f, 1.0f, 0.0f, 1.0f));
-            } else {
-                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
-            }
-            ImGui::Text("%.2f", pos.unrealizedPNL);
-            ImGui::PopStyleColor();
+                // Color code P&L: green for profit, red for loss
+                ImGui::TableSetColumnIndex(5);
+                ImGui::TextColored(pos.unrealizedPNL >= 0 ? profit : loss, "%s", m_positionsTable.cell(row, 5).c_str());
 
-            ImGui::TableSetColumnIndex(6);
-            if (pos.realizedPNL >= 0) {
-                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.0f, 1.0f, 0.0f, 1.0f));
-            } else {
-                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.0f, 0.0f, 1.0f));
+                ImGui::TableSetColumnIndex(6);
+                ImGui::TextColored(pos.realizedPNL >= 0 ? profit : loss, "%s", m_positionsTable.cell(row, 6).c_str());
             }
-            ImGui::Text("%.2f", pos.realizedPNL);
-            ImGui::PopStyleColor();
         }
 
         ImGui::EndTable();
@@ -791,6 +1362,14 @@ void Renderer::newGUI(DataManager& dataManager) {
 			RenderAnalysisWindows(dataManager);
 			ImGui::EndTabItem();
 		}
+        // Sheet 3: Watch wall of many small charts
+        if (ImGui::BeginTabItem("Grid"))
+        {
+            ImGuiID dockspace_id = ImGui::GetID("GridDockSpace");
+            ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), ImGuiDockNodeFlags_None);
+            ChartGridGUI(dataManager);
+            ImGui::EndTabItem();
+        }
         if (ImGui::BeginTabItem("Portfolio"))
         {
             // Same structure as Trading tab, but with DIFFERENT dockspace ID
@@ -828,19 +1407,334 @@ void Renderer::newGUI(DataManager& dataManager) {
 
 int Renderer::draw(DataManager& dataManager)
 {
+	PROFILE_ZONE("Renderer::draw");
+
 	// --- Start ImGui frame ---
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
 
+	// Land finished chart builds before anything draws them
+	m_chartBuilds.pump(kChartBuildBudgetNs, [this](ChartGeometry& geometry) { installChartGeometry(geometry); });
+
 	newGUI(dataManager);  // Enable the new GUI with Portfolio tab
 	//ImGui::ShowDemoWindow();
 
-	ImGui::Render();
-	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	// F12 toggles the frame profiler overlay
+	if (ImGui::IsKeyPressed(ImGuiKey_F12, false)) {
+		m_showProfiler = !m_showProfiler;
+	}
+	if (m_showProfiler) {
+		ProfilerGUI(dataManager);
+	}
+
+	{
+		PROFILE_ZONE("ImGui::Render");
+		ImGui::Render();
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	}
 	return 0;
 }
 
+void Renderer::ProfilerGUI(DataManager& dataManager)
+{
+	ImGui::SetNextWindowSize(ImVec2(460, 420), ImGuiCond_FirstUseEver);
+	ImGui::Begin("Profiler", &m_showProfiler);
+
+	std::vector<float> frameMs;
+	Profiler::frameTimes(frameMs);
+	if (!frameMs.empty()) {
+		float total = 0.0f, worst = 0.0f;
+		for (float ms : frameMs) {
+			total += ms;
+			worst = (std::max)(worst, ms);
+		}
+		ImGui::Text("Frame: %.2f ms avg, %.2f ms max (last %zu frames)", total / frameMs.size(), worst, frameMs.size());
+		ImGui::PlotHistogram("##FrameTimes", frameMs.data(), (int)frameMs.size(), 0, nullptr,
+			0.0f, (std::max)(33.3f, worst), ImVec2(-FLT_MIN, 80.0f));
+	}
+
+	const StartupStats& startup = dataManager.startup;
+	if (startup.snapshotCharts > 0) {
+		ImGui::Text("Startup: first frame %.0f ms (warm, %zu charts in %.1f ms)",
+			startup.firstFrameMs, startup.snapshotCharts, startup.snapshotLoadMs);
+	}
+	else {
+		ImGui::Text("Startup: first frame %.0f ms (cold)", startup.firstFrameMs);
+	}
+
+	if (Profiler::isCapturing()) {
+		if (ImGui::Button("Stop capture")) {
+			std::string filename = "trace_" + std::to_string(std::time(nullptr)) + ".json";
+			Profiler::endCapture(filename);
+			m_lastTraceFile = filename;
+		}
+		ImGui::SameLine();
+		ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Capturing...");
+	}
+	else if (ImGui::Button("Start capture")) {
+		Profiler::beginCapture();
+	}
+	if (!m_lastTraceFile.empty()) {
+		ImGui::SameLine();
+		ImGui::TextDisabled("Last trace: %s", m_lastTraceFile.c_str());
+	}
+
+	// Slowest zones over roughly the last second
+	uint64_t window = 1000000000ull;
+	uint64_t now = Profiler::now();
+	std::vector<ZoneStats> zones;
+	Profiler::slowestZones(now > window ? now - window : 0, 20, zones);
+
+	if (ImGui::BeginTable("ProfilerZones", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+		ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableSetupColumn("Count", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+		ImGui::TableSetupColumn("Avg ms", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+		ImGui::TableSetupColumn("Max ms", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+		ImGui::TableHeadersRow();
+		for (const ZoneStats& zone : zones) {
+			ImGui::TableNextRow();
+			ImGui::TableSetColumnIndex(0);
+			ImGui::Text("%s", zone.name);
+			ImGui::TableSetColumnIndex(1);
+			ImGui::Text("%u", zone.count);
+			ImGui::TableSetColumnIndex(2);
+			ImGui::Text("%.3f", zone.totalNs / 1.0e6 / zone.count);
+			ImGui::TableSetColumnIndex(3);
+			ImGui::Text("%.3f", zone.maxNs / 1.0e6);
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::CollapsingHeader("Connections")) {
+		const ConnectionHealth& health = dataManager.connection;
+		if (ImGui::BeginTable("Connections", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Client");
+			ImGui::TableSetupColumn("Role");
+			ImGui::TableSetupColumn("State");
+			ImGui::TableSetupColumn("Reconnects");
+			ImGui::TableSetupColumn("Last outage");
+			ImGui::TableHeadersRow();
+			for (const ConnectionStatus& status : health.connections) {
+				ImGui::TableNextRow();
+				ImGui::TableSetColumnIndex(0);
+				ImGui::Text("%d", status.clientId);
+				ImGui::TableSetColumnIndex(1);
+				ImGui::TextUnformatted(status.role.c_str());
+				ImGui::TableSetColumnIndex(2);
+				if (status.connected) ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.3f, 1.0f), "up");
+				else ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "down");
+				ImGui::TableSetColumnIndex(3);
+				ImGui::Text("%d", status.reconnects);
+				ImGui::TableSetColumnIndex(4);
+				if (status.reconnects > 0) ImGui::Text("%.0f ms", status.lastOutageMs);
+			}
+			ImGui::EndTable();
+		}
+		if (health.outageStartNs != 0) {
+			ImGui::Text("Recovering: %.1f s, %zu gap fills pending",
+				(Profiler::now() - health.outageStartNs) / 1.0e9, health.pendingGapFills.size());
+		}
+		else if (health.recoveries > 0) {
+			ImGui::Text("Time to recovered: %.0f ms (last of %d)", health.lastRecoveryMs, health.recoveries);
+		}
+		const RequestStats& requests = health.requests;
+		ImGui::Text("Requests: %zu in flight, %zu queued; %llu done, %llu failed, %llu timed out, %llu cancelled",
+			requests.inFlight, requests.queued, (unsigned long long)requests.completed,
+			(unsigned long long)requests.failed, (unsigned long long)requests.timedOut,
+			(unsigned long long)requests.cancelled);
+		ImGui::Text("Request latency: %.0f ms last, %.0f ms max", requests.lastLatencyMs, requests.maxLatencyMs);
+		ContractCacheStats contracts = ContractCache::stats();
+		ImGui::Text("Contracts: %zu cached (%zu with details), %llu hits, %llu misses", contracts.entries,
+			contracts.complete, (unsigned long long)contracts.hits, (unsigned long long)contracts.misses);
+	}
+
+	if (ImGui::CollapsingHeader("Memory")) {
+		const MemoryUsage& memory = dataManager.memory;
+		double budgetMB = memory.budgetBytes / 1048576.0;
+		double totalMB = memory.totalBytes() / 1048576.0;
+		ImGui::Text("%.1f of %.0f MB", totalMB, budgetMB);
+		ImGui::ProgressBar(budgetMB > 0.0 ? (float)(std::min)(1.0, totalMB / budgetMB) : 0.0f, ImVec2(-FLT_MIN, 0.0f));
+		if (ImGui::BeginTable("MemoryTiers", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Tier");
+			ImGui::TableSetupColumn("Charts");
+			ImGui::TableSetupColumn("MB");
+			ImGui::TableSetupColumn("Evicted");
+			ImGui::TableHeadersRow();
+			auto row = [](const char* name, const MemoryTier& tier) {
+				ImGui::TableNextRow();
+				ImGui::TableSetColumnIndex(0);
+				ImGui::TextUnformatted(name);
+				ImGui::TableSetColumnIndex(1);
+				ImGui::Text("%zu", tier.charts);
+				ImGui::TableSetColumnIndex(2);
+				ImGui::Text("%.2f", tier.bytes / 1048576.0);
+				ImGui::TableSetColumnIndex(3);
+				ImGui::Text("%llu", (unsigned long long)tier.evictions);
+			};
+			row("GPU", memory.gpu);
+			row("Candles", memory.candles);
+			row("Compressed", memory.compressed);
+			row("Spilled (disk)", memory.spilled);
+			ImGui::EndTable();
+		}
+		ImGui::Text("Restored on access: %llu", (unsigned long long)memory.restores);
+	}
+
+	if (ImGui::CollapsingHeader("Event allocations")) {
+		if (ImGui::Button("Run 100k cycles")) {
+			benchmarkEventAllocations(100000, m_eventAllocHeap, m_eventAllocArena);
+		}
+		if (m_eventAllocHeap.seconds > 0.0) {
+			ImGui::Text("Heap:  %llu allocations, %.1f ms", (unsigned long long)m_eventAllocHeap.allocations,
+				m_eventAllocHeap.seconds * 1000.0);
+			ImGui::Text("Arena: %llu allocations, %.1f ms", (unsigned long long)m_eventAllocArena.allocations,
+				m_eventAllocArena.seconds * 1000.0);
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Candle compression")) {
+		auto showStats = [](const char* label, const CompressionStats& stats) {
+			if (stats.bars == 0) return;
+			ImGui::Text("%s: %zu bars, %.1f MB -> %.1f MB (%.1fx)", label, stats.bars,
+				stats.rawBytes / 1048576.0, stats.compressedBytes / 1048576.0, stats.ratio());
+			ImGui::Text("    encode %.1f ms, decode %.2f ms (%.0f M bars/s)", stats.encodeSeconds * 1000.0,
+				stats.decodeSeconds * 1000.0, stats.decodeSeconds > 0.0 ? stats.bars / stats.decodeSeconds / 1.0e6 : 0.0);
+		};
+		if (ImGui::Button("Loaded charts")) {
+			m_compressionCharts = CompressionStats{};
+			std::vector<CandleData> candles;
+			for (const auto& [symbol, chart] : dataManager.charts) {
+				if (!readCandles(chart, candles)) continue;
+				CompressionStats stats = measureCandleCompression(candles);
+				m_compressionCharts.bars += stats.bars;
+				m_compressionCharts.rawBytes += stats.rawBytes;
+				m_compressionCharts.compressedBytes += stats.compressedBytes;
+				m_compressionCharts.encodeSeconds += stats.encodeSeconds;
+				m_compressionCharts.decodeSeconds += stats.decodeSeconds;
+			}
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("1M synthetic 1m bars")) {
+			m_compressionSynthetic = benchmarkCandleCompression(1000000);
+		}
+		showStats("Charts", m_compressionCharts);
+		showStats("Synthetic", m_compressionSynthetic);
+	}
+	if (ImGui::CollapsingHeader("Resampling")) {
+		if (ImGui::Button("1M 1m bars to every timeframe") && !m_benchmarkRunning) {
+			m_benchmarkRunning = true;
+			TaskScheduler::submit([this]() {
+				ResampleBenchmark result = benchmarkResample(1000000);
+				TaskScheduler::postMain([this, result]() {
+					m_resampleBenchmark = result;
+					m_benchmarkRunning = false;
+				});
+			}, TaskPriority::Low);
+		}
+		if (m_benchmarkRunning) {
+			ImGui::SameLine();
+			ImGui::TextDisabled("Running...");
+		}
+		const ResampleBenchmark& bench = m_resampleBenchmark;
+		if (bench.baseBars > 0) {
+			ImGui::Text("%zu bars: rebuild %.1f ms on %u threads, %.1f ms on one", bench.baseBars,
+				bench.parallelMs, bench.threads, bench.serialMs);
+			ImGui::Text("Live append: %.1f us per bar", bench.appendUs);
+		}
+	}
+	if (ImGui::CollapsingHeader("Chart types")) {
+		if (ImGui::Button("Derive every type from 1M 1m bars") && !m_benchmarkRunning) {
+			m_benchmarkRunning = true;
+			TaskScheduler::submit([this]() {
+				ChartTypeBenchmark result = benchmarkChartTypes(1000000);
+				TaskScheduler::postMain([this, result]() {
+					m_chartTypeBenchmark = result;
+					m_benchmarkRunning = false;
+				});
+			}, TaskPriority::Low);
+		}
+		if (m_benchmarkRunning) {
+			ImGui::SameLine();
+			ImGui::TextDisabled("Running...");
+		}
+		const ChartTypeBenchmark& bench = m_chartTypeBenchmark;
+		if (bench.baseBars > 0) {
+			for (size_t type = 1; type < kChartTypeCount; type++) {
+				ImGui::Text("%s: %.1f ms on first display", chartTypeName((ChartType)type), bench.materialiseMs[type]);
+			}
+			ImGui::Text("Live append: %.1f us per bar, every type", bench.appendUs);
+		}
+	}
+	if (ImGui::CollapsingHeader("Volume profile")) {
+		if (ImGui::Button("Profile 1M 1m bars") && !m_benchmarkRunning) {
+			m_benchmarkRunning = true;
+			TaskScheduler::submit([this]() {
+				VolumeProfileBenchmark result = benchmarkVolumeProfile(1000000);
+				TaskScheduler::postMain([this, result]() {
+					m_volumeProfileBenchmark = result;
+					m_benchmarkRunning = false;
+				});
+			}, TaskPriority::Low);
+		}
+		if (m_benchmarkRunning) {
+			ImGui::SameLine();
+			ImGui::TextDisabled("Running...");
+		}
+		const VolumeProfileBenchmark& bench = m_volumeProfileBenchmark;
+		if (bench.bars > 0) {
+			ImGui::Text("%zu bars: binned in %.1f ms", bench.bars, bench.buildMs);
+			ImGui::Text("Query: %.1f us for 500 bars anywhere, %.1f us for all of them", bench.queryUs, bench.deepQueryUs);
+			ImGui::Text("Live append: %.2f us per bar", bench.appendUs);
+		}
+	}
+	if (ImGui::CollapsingHeader("Tasks")) {
+		TaskStats tasks = TaskScheduler::stats();
+		ImGui::Text("%u workers, %zu queued, %llu stolen", tasks.threads, tasks.pending,
+			(unsigned long long)tasks.stolen);
+		ImGui::Text("Run: %llu high, %llu normal, %llu low",
+			(unsigned long long)tasks.executed[(size_t)TaskPriority::High],
+			(unsigned long long)tasks.executed[(size_t)TaskPriority::Normal],
+			(unsigned long long)tasks.executed[(size_t)TaskPriority::Low]);
+		ImGui::Text("UI continuations: %zu waiting, %llu run, %.2f ms last frame, %.2f ms max",
+			tasks.mainPending, (unsigned long long)tasks.mainExecuted, tasks.lastDrainMs, tasks.maxDrainMs);
+	}
+	if (ImGui::CollapsingHeader("Chart builds")) {
+		const ChartBuildStats& builds = m_chartBuilds.stats();
+		ImGui::Text("Queued %zu, building %zu, done %llu, superseded %llu", builds.queued, builds.building,
+			(unsigned long long)builds.completed, (unsigned long long)builds.superseded);
+		ImGui::Text("UI thread: %.2f ms last frame, %.2f ms max (budget %.1f ms)", builds.lastPumpMs,
+			builds.maxPumpMs, kChartBuildBudgetNs / 1.0e6);
+	}
+	if (ImGui::CollapsingHeader("Vertex build")) {
+		const size_t sizes[2] = { 1000000, 10000000 };
+		for (int i = 0; i < 2; i++) {
+			if (i > 0) ImGui::SameLine();
+			if (ImGui::Button(i == 0 ? "1M candles" : "10M candles") && !m_benchmarkRunning) {
+				m_benchmarkRunning = true;
+				TaskScheduler::submit([this, i, candles = sizes[i]]() {
+					VertexBenchmark result = benchmarkCandleVertices(candles);
+					TaskScheduler::postMain([this, i, result]() {
+						m_vertexBenchmarks[i] = result;
+						m_benchmarkRunning = false;
+					});
+				}, TaskPriority::Low);
+			}
+		}
+		if (m_benchmarkRunning) {
+			ImGui::SameLine();
+			ImGui::TextDisabled("Running...");
+		}
+		for (const VertexBenchmark& bench : m_vertexBenchmarks) {
+			if (bench.candles == 0) continue;
+			ImGui::Text("%zu candles, %.0f MB: %.1f ms on %u threads, %.1f ms on one", bench.candles,
+				bench.bytes / 1048576.0, bench.parallelMs, bench.threads, bench.serialMs);
+			if (bench.legacyMs > 0.0) ImGui::Text("    insert-based build: %.1f ms", bench.legacyMs);
+		}
+	}
+	ImGui::End();
+}
+
 void Renderer::oldGUI(DataManager& dataManager)
 {
 
@@ -860,72 +1754,575 @@ void Renderer::oldGUI(DataManager& dataManager)
 
     //// Scanner Results Window
     const auto& scanResults = dataManager.currentScannerResult;
-    ScannerGUI(scanResults);
+    ScannerGUI(scanResults, dataManager.scannerRevision);
 
     //DrawChartGUI(dataManager);
-    std::string symbol = dataManager.activeSymbol;
+    SymbolId symbol = dataManager.activeSymbol;
     if (dataManager.charts.find(symbol) != dataManager.charts.end()) {
-        // Check if chart exists
-        if (m_chartViews.find(symbol) == m_chartViews.end()) {
-            // Create new chart if it doesn't exist
-            m_chartViews[symbol] = createChartFromData(symbol, dataManager.charts[symbol].candles);
+        CreateChartView(chartViewFor(symbol, dataManager), symbol, dataManager);
+    }
+}
+
+// The symbol's primary chart view, created on first use and brought up to date
+ChartView& Renderer::chartViewFor(SymbolId symbol, DataManager& dataManager) {
+    auto primary = m_primaryViews.find(symbol);
+    if (primary == m_primaryViews.end()) {
+        primary = m_primaryViews.emplace(symbol, createChartView(symbol)).first;
+    }
+    ChartView& view = m_chartViews[primary->second];
+    refreshChartView(primary->second, view, dataManager);
+    return view;
+}
+
+ChartViewId Renderer::createChartView(SymbolId symbol) {
+    ChartViewId id = m_nextViewId++;
+    ChartView& view = m_chartViews[id];
+    view.symbol = symbol;
+    view.title = SymbolTable::name(symbol);
+    view.shaderProgram = chartProgram();
+    view.dataRevision = UINT64_MAX;
+    return id;
+}
+
+// Another window of the same symbol, starting from the same settings.
+// Its title carries the id so ImGui keeps the windows apart.
+void Renderer::openChartView(const ChartView& from) {
+    ChartViewId id = createChartView(from.symbol);
+    ChartView& view = m_chartViews[id];
+    view.title = SymbolTable::name(from.symbol) + "##view" + std::to_string(id);
+    view.timeframe = from.timeframe;
+    view.chartType = from.chartType;
+    view.profile.enabled = from.profile.enabled;
+    m_extraViews.push_back(id);
+}
+
+// Rebuilds the view's geometry when its candles have changed since
+// (re-request, reconnect gap fill) or another timeframe or chart type was
+// picked. Geometry is built through m_chartBuilds: a new view has none
+// until its build lands, a rebuild keeps drawing the old vertex buffer
+// meanwhile.
+void Renderer::refreshChartView(ChartViewId id, ChartView& view, DataManager& dataManager) {
+    const ChartData& chartData = dataManager.charts[view.symbol];
+    view.lastUsedNs = Profiler::now();
+    bool requested = view.building && view.buildRevision == chartData.revision &&
+        view.buildTimeframe == view.timeframe && view.buildChartType == view.chartType;
+    if (view.dataRevision != chartData.revision && !requested) {
+        requestChartBuild(id, view, dataManager);
+    }
+}
+
+// Windows opened with "+"; closing one deletes it
+void Renderer::drawExtraChartViews(DataManager& dataManager) {
+    // Copied: "+" in one of these windows opens another mid-loop
+    std::vector<ChartViewId> views = m_extraViews;
+    for (ChartViewId id : views) {
+        ChartView& view = m_chartViews[id];
+        if (view.isVisible && dataManager.charts.count(view.symbol)) {
+            refreshChartView(id, view, dataManager);
+            CreateChartView(view, view.symbol, dataManager);
         }
-        CreateChartView(m_chartViews[symbol]);
+        if (view.isVisible && dataManager.charts.count(view.symbol)) continue;
+
+        releaseChartView(id);
+        m_chartViews.erase(id);
+        m_extraViews.erase(std::find(m_extraViews.begin(), m_extraViews.end(), id));
+    }
+}
+
+// Only the resample and chart type derivation (usually incremental) and a
+// copy of the prices happen here; the vertices are written by a worker
+void Renderer::requestChartBuild(ChartViewId id, ChartView& view, DataManager& dataManager) {
+    PROFILE_ZONE("Renderer::requestChartBuild");
+    const SymbolId symbol = view.symbol;
+    std::vector<CandlePrices> prices;
+    if (view.chartType == ChartType::Candles) {
+        const std::vector<CandleData>& candles = timeframeBars(dataManager, symbol, view.timeframe);
+        prices.resize(candles.size());
+        for (size_t i = 0; i < candles.size(); i++) {
+            prices[i] = { candles[i].open, candles[i].high, candles[i].low, candles[i].close };
+        }
+        view.boxSize = 0.0;
+    }
+    else {
+        prices = chartTypeBars(dataManager, symbol, view.timeframe, view.chartType);
+        view.boxSize = dataManager.charts[symbol].chartTypes.series(view.chartType, view.timeframe).boxSize();
+    }
+    if (view.vao == 0 && !view.building) {
+        printf("Creating new chart view for symbol: %s with %zu candles\n", symbolName(symbol), prices.size());
+    }
+
+    uint64_t revision = dataManager.charts[symbol].revision;
+    m_chartBuilds.request(id, symbol, revision, view.timeframe, view.chartType, std::move(prices));
+    view.building = true;
+    view.buildRevision = revision;
+    view.buildTimeframe = view.timeframe;
+    view.buildChartType = view.chartType;
+}
+
+// Swaps a finished build into its view. The view may have been released
+// or switched timeframe or chart type meanwhile; then the geometry is dropped.
+void Renderer::installChartGeometry(ChartGeometry& geometry) {
+    auto it = m_chartViews.find(geometry.view);
+    if (it == m_chartViews.end() || it->second.timeframe != geometry.timeframe ||
+        it->second.chartType != geometry.chartType) {
+        if (geometry.vao) glDeleteVertexArrays(1, &geometry.vao);
+        if (geometry.vbo) glDeleteBuffers(1, &geometry.vbo);
+        return;
+    }
+
+    ChartView& view = it->second;
+    // GL reuses names, so a cached atlas cell must not match the new VAO
+    for (ChartGrid::TileState& state : m_grid.tiles) {
+        if (state.vao == view.vao) state = ChartGrid::TileState{};
+    }
+    if (view.vao) glDeleteVertexArrays(1, &view.vao);
+    if (view.vbo) glDeleteBuffers(1, &view.vbo);
+    view.vao = geometry.vao;
+    view.vbo = geometry.vbo;
+    view.vertexBytes = geometry.vertexBytes;
+    view.numCandles = geometry.numCandles;
+    view.minPrice = geometry.minPrice;
+    view.maxPrice = geometry.maxPrice;
+    view.dataRevision = geometry.revision;
+    view.building = m_chartBuilds.pending(geometry.view);
+}
+
+void Renderer::gpuResidency(std::vector<GpuResidency>& out) const {
+    out.clear();
+    for (const auto& [id, view] : m_chartViews) {
+        if (view.gpuBytes() == 0) continue;     // Released, or not built yet
+        out.push_back({ id, view.gpuBytes(), view.lastUsedNs });
     }
 }
 
-ChartView Renderer::createChartFromData(const std::string& symbol, const std::vector<CandleData>& candles) {
-    printf("Creating new chart view for symbol: %s with %zu candles\n", 
-           symbol.c_str(), candles.size());
+void Renderer::releaseChartView(ChartViewId id) {
+    m_chartBuilds.cancel(id);
+    auto it = m_chartViews.find(id);
+    if (it == m_chartViews.end()) return;
+    ChartView& view = it->second;
+    // GL reuses names, so a cached atlas cell must not match a later VAO
+    for (ChartGrid::TileState& state : m_grid.tiles) {
+        if (state.vao == view.vao) state = ChartGrid::TileState{};
+    }
+    view.cleanup();
+    view.shaderProgram = chartProgram();
+    view.width = view.height = 0;       // So the next draw makes a new FBO
+    view.numCandles = 0;
+    view.vertexBytes = 0;
+    view.building = false;
+    view.dataRevision = UINT64_MAX;     // Rebuilt when next shown
+}
 
-    ChartView newChart;
-    newChart.title = symbol;
-    newChart.isVisible = true;
+void Renderer::ensureGridAtlas(int tileW, int tileH, int cols, int rows)
+{
+    // A failed size isn't retried every frame
+    if ((!m_grid.pages.empty() || m_grid.failed) && m_grid.tileW == tileW && m_grid.tileH == tileH &&
+        m_grid.cols == cols && m_grid.rows >= rows) {
+        return;
+    }
+    m_grid.cleanup();
+    m_grid.tileW = tileW;
+    m_grid.tileH = tileH;
+    m_grid.cols = cols;
+    m_grid.rows = rows;
+    m_grid.failed = false;
+    m_grid.tiles.assign(cols * rows, ChartGrid::TileState{});
+
+    // Cells shrink (keeping their aspect) until a row fits in one texture;
+    // rows then spill onto as many pages as they need
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (maxSize <= 0) maxSize = 4096;   // The minimum GL 3.3 guarantees
+    float scale = (std::min)(1.0f, (float)maxSize / (float)(cols * tileW));
+    m_grid.cellW = (std::max)(1, (int)(tileW * scale));
+    m_grid.cellH = (std::max)(1, (std::min)((int)(tileH * scale), (int)maxSize));
+    m_grid.rowsPerPage = (std::max)(1, (std::min)(rows, (int)maxSize / m_grid.cellH));
+
+    for (int firstRow = 0; firstRow < rows; firstRow += m_grid.rowsPerPage) {
+        ChartGrid::Page& page = m_grid.pages.emplace_back();
+        page.rows = (std::min)(m_grid.rowsPerPage, rows - firstRow);
+
+        glGenTextures(1, &page.tex);
+        glBindTexture(GL_TEXTURE_2D, page.tex);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, cols * m_grid.cellW, page.rows * m_grid.cellH, 0,
+            GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        glGenFramebuffers(1, &page.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, page.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, page.tex, 0);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            printf("Chart grid: atlas page %dx%d incomplete (0x%x)\n", cols * m_grid.cellW,
+                page.rows * m_grid.cellH, status);
+            m_grid.failed = true;
+            break;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (m_grid.failed) m_grid.cleanup();
+}
 
-    // Prepare vertex data from candles and get price range
-    auto [vertexData, priceRange] = prepareCandleDataFromVector(candles);
-    newChart.minPrice = priceRange.first;
-    newChart.maxPrice = priceRange.second;
+// One batched pass for every visible tile: a single FBO and program bind,
+// then per tile only viewport, scissor, projection and VAO change.
+void Renderer::renderGridTiles(const std::vector<std::pair<int, const ChartView*>>& tiles)
+{
+    if (tiles.empty()) return;
+    PROFILE_ZONE("Renderer::renderGridTiles");
 
-    // Initialize OpenGL objects
-    auto [vao, vbo, numCandles] = initCandleDataFromVector(vertexData);
-    newChart.vao = vao;
-	newChart.vbo = vbo;
-    newChart.numCandles = numCandles;
-    newChart.shaderProgram = createShaderProgram();
+    glUseProgram(chartProgram());
+    glEnable(GL_SCISSOR_TEST);
+    glLineWidth(1.0f);
 
-    // Create initial FBO (will be resized in CreateChartView if needed)
-    createChartFrameBuffer(newChart, 800, 600);
+    int boundPage = -1;
+    for (const auto& [slot, chart] : tiles) {
+        ChartGrid::TileState& state = m_grid.tiles[slot];
+        if (state.vao == chart->vao && state.zoom == zoomLevel) continue;  // Atlas cell is current
+        state.vao = chart->vao;
+        state.zoom = zoomLevel;
+
+        int row = slot / m_grid.cols;
+        int page = row / m_grid.rowsPerPage;
+        if (page != boundPage) {
+            glBindFramebuffer(GL_FRAMEBUFFER, m_grid.pages[page].fbo);
+            boundPage = page;
+        }
+        int x = (slot % m_grid.cols) * m_grid.cellW;
+        int y = (row % m_grid.rowsPerPage) * m_grid.cellH;
+        glViewport(x, y, m_grid.cellW, m_grid.cellH);
+        glScissor(x, y, m_grid.cellW, m_grid.cellH);
+        glClear(GL_COLOR_BUFFER_BIT);
+        if (chart->vao == 0) continue;  // Still building; the cell stays blank
+
+        float rightEdge = (float)chart->numCandles;
+        float leftEdge = rightEdge - zoomLevel;
+        glm::mat4 projection = glm::ortho(leftEdge, rightEdge, chart->minPrice - 2.0f, chart->maxPrice + 2.0f);
+        glUniformMatrix4fv(m_projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+
+        glBindVertexArray(chart->vao);
+        glDrawArrays(GL_LINES, 0, chart->numCandles * 2);
+        glDrawArrays(GL_TRIANGLES, chart->numCandles * 2, chart->numCandles * 6);
+    }
 
-    return newChart;
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void Renderer::CreateChartView(ChartView& chart)
+void Renderer::ChartGridGUI(DataManager& dataManager)
+{
+    const int maxTiles = 64;
+
+    ImGui::Begin("Chart Grid##Grid");
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::SliderInt("Columns", &m_grid.cols, 2, 8);
+    ImGui::SameLine();
+    if (ImGui::Button("Load scanner symbols") && onChartRequested) {
+        for (const auto& item : dataManager.currentScannerResult.items) {
+            if (dataManager.charts.find(item.symbol) == dataManager.charts.end()) {
+                onChartRequested(item.symbol);
+            }
+        }
+    }
+
+    // Stable alphabetical tile order
+    std::vector<SymbolId> symbols;
+    for (const auto& [symbol, chartData] : dataManager.charts) {
+        symbols.push_back(symbol);
+    }
+    std::sort(symbols.begin(), symbols.end(), [](SymbolId a, SymbolId b) { return SymbolTable::name(a) < SymbolTable::name(b); });
+    if (symbols.size() > maxTiles) symbols.resize(maxTiles);
+    ImGui::SameLine();
+    ImGui::Text("%zu charts", symbols.size());
+
+    const int cols = m_grid.cols;
+    const int rows = ((int)symbols.size() + cols - 1) / cols;
+    const float pad = 4.0f;
+    ImVec2 avail = ImGui::GetContentRegionAvail();
+    int tileW = (int)((avail.x - pad * (cols - 1)) / cols);
+    int tileH = (int)(tileW * 0.6f);
+
+    if (symbols.empty() || tileW < 16) {
+        ImGui::End();
+        return;
+    }
+    ensureGridAtlas(tileW, tileH, cols, rows);
+    if (m_grid.failed) {
+        ImGui::TextDisabled("No framebuffer for the grid at this size; try fewer columns");
+        ImGui::End();
+        return;
+    }
+
+    ImGui::BeginChild("GridTiles");
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    auto tileMin = [&](int slot) {
+        return ImVec2(origin.x + (slot % cols) * (tileW + pad), origin.y + (slot / cols) * (tileH + pad));
+    };
+
+    // Pass 1: find tiles inside the scroll region and render them in one batch
+    std::vector<std::pair<int, const ChartView*>> visibleTiles;
+    for (int slot = 0; slot < (int)symbols.size(); slot++) {
+        ImVec2 p0 = tileMin(slot);
+        if (!ImGui::IsRectVisible(p0, ImVec2(p0.x + tileW, p0.y + tileH))) continue;
+
+        SymbolId symbol = symbols[slot];
+        bool known = m_primaryViews.find(symbol) != m_primaryViews.end();
+        ChartView& view = chartViewFor(symbol, dataManager);
+        if (!known) view.isVisible = false;  // Grid-only until opened in the Trading tab
+        visibleTiles.emplace_back(slot, &view);
+    }
+    renderGridTiles(visibleTiles);
+
+    // Pass 2: hand each visible atlas cell to ImGui (flipped vertically)
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    size_t next = 0;
+    for (int slot = 0; slot < (int)symbols.size(); slot++) {
+        ImVec2 p0 = tileMin(slot);
+        ImGui::SetCursorScreenPos(p0);
+        bool visible = next < visibleTiles.size() && visibleTiles[next].first == slot;
+        if (!visible) {
+            ImGui::Dummy(ImVec2((float)tileW, (float)tileH));
+            continue;
+        }
+        next++;
+
+        const ChartGrid::Page& page = m_grid.pages[(slot / cols) / m_grid.rowsPerPage];
+        int pageRow = (slot / cols) % m_grid.rowsPerPage;
+        float u0 = (float)(slot % cols) / cols;
+        float u1 = (float)((slot % cols) + 1) / cols;
+        float v0 = (float)pageRow / page.rows;
+        float v1 = (float)(pageRow + 1) / page.rows;
+        ImGui::Image((ImTextureID)(intptr_t)page.tex, ImVec2((float)tileW, (float)tileH),
+            ImVec2(u0, v1), ImVec2(u1, v0));
+        if (ImGui::IsItemClicked()) {
+            // Open the full chart in the Trading tab
+            dataManager.activeSymbol = symbols[slot];
+            m_chartViews[m_primaryViews[symbols[slot]]].isVisible = true;
+        }
+        drawList->AddText(ImVec2(p0.x + 4.0f, p0.y + 2.0f), IM_COL32(255, 255, 255, 255), symbolName(symbols[slot]));
+        const ChartView* tile = visibleTiles[next - 1].second;
+        if (tile->vao == 0 && tile->building) {
+            drawList->AddText(ImVec2(p0.x + 4.0f, p0.y + 18.0f), IM_COL32(160, 160, 160, 255), "Loading...");
+        }
+    }
+    ImGui::EndChild();
+    ImGui::End();
+}
+
+void Renderer::CreateChartView(ChartView& chart, SymbolId symbol, DataManager& dataManager)
 {
     ImGui::Begin(chart.title.c_str(), &chart.isVisible);
     DisableTitleFocusColors();
+    // Tick mode ends when another chart takes over the tick chart
+    const TickChartData& tickChart = dataManager.tickChart;
+    if (chart.ticks.enabled && tickChart.symbol != symbol) chart.ticks.enabled = false;
+    for (size_t tf = 0; tf < kTimeframeCount; tf++) {
+        if (tf > 0) ImGui::SameLine();
+        bool selected = chart.timeframe == (Timeframe)tf;
+        if (selected) ImGui::PushStyleColor(ImGuiCol_Button, ImGui::GetStyleColorVec4(ImGuiCol_ButtonActive));
+        if (ImGui::SmallButton(timeframeName((Timeframe)tf)) && !selected) {
+            chart.timeframe = (Timeframe)tf;
+            chart.dataRevision = UINT64_MAX;    // chartViewFor rebuilds it next frame
+        }
+        if (selected) ImGui::PopStyleColor();
+    }
+    ImGui::SameLine(0.0f, 16.0f);
+    for (size_t type = 0; type < kChartTypeCount; type++) {
+        if (type > 0) ImGui::SameLine();
+        bool selected = !chart.ticks.enabled && chart.chartType == (ChartType)type;
+        if (selected) ImGui::PushStyleColor(ImGuiCol_Button, ImGui::GetStyleColorVec4(ImGuiCol_ButtonActive));
+        if (ImGui::SmallButton(chartTypeName((ChartType)type)) && !selected) {
+            chart.ticks.enabled = false;
+            if (chart.chartType != (ChartType)type) {
+                chart.chartType = (ChartType)type;
+                chart.dataRevision = UINT64_MAX;    // Derived once, then kept up to date with the chart
+            }
+        }
+        if (selected) ImGui::PopStyleColor();
+    }
+    ImGui::SameLine();
+    if (chart.ticks.enabled) ImGui::PushStyleColor(ImGuiCol_Button, ImGui::GetStyleColorVec4(ImGuiCol_ButtonActive));
+    if (ImGui::SmallButton("Ticks") && !chart.ticks.enabled) {
+        chart.ticks.enabled = true;
+        if (tickChart.symbol != symbol && onTickChartRequested) onTickChartRequested(symbol);
+    }
+    else if (chart.ticks.enabled) {
+        ImGui::PopStyleColor();
+    }
+    if (!chart.ticks.enabled) {
+        ImGui::SameLine(0.0f, 16.0f);
+        bool profile = chart.profile.enabled;
+        if (profile) ImGui::PushStyleColor(ImGuiCol_Button, ImGui::GetStyleColorVec4(ImGuiCol_ButtonActive));
+        if (ImGui::SmallButton("Profile")) chart.profile.enabled = !profile;
+        if (profile) ImGui::PopStyleColor();
+        if (chart.profile.enabled) {
+            ImGui::SameLine();
+            if (ImGui::SmallButton(chart.profile.timeAtPrice ? "TPO" : "Vol")) {
+                chart.profile.timeAtPrice = !chart.profile.timeAtPrice;
+            }
+        }
+    }
+    ImGui::SameLine(0.0f, 16.0f);
+    if (ImGui::SmallButton("+")) openChartView(chart);
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Another window of %s, e.g. at another timeframe", symbolName(symbol));
+    if (!chart.ticks.enabled && chart.boxSize > 0.0 &&
+        (chart.chartType == ChartType::Renko || chart.chartType == ChartType::Range)) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("box %g", chart.boxSize);
+    }
+    if (chart.ticks.enabled) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%zu prints, %d per px%s%s", tickChart.series.size(), 1 << chart.ticks.shownZoom,
+            tickChart.loadingHistory ? ", loading history..." : "", chart.ticks.zoom < 0 ? ", fit" : "");
+        if (!tickChart.error.empty() && ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("History incomplete: %s", tickChart.error.c_str());
+        }
+    }
     ImVec2 avail = ImGui::GetContentRegionAvail();
     
-    if (avail.x > 0 && avail.y > 0)
+    if (chart.ticks.enabled && avail.x > 0 && avail.y > 0)
     {
-        // Optional: resize FBO if ImGui window resized
         if ((int)avail.x != chart.width || (int)avail.y != chart.height)
         {
             glDeleteTextures(1, &chart.colorTex);
             glDeleteFramebuffers(1, &chart.fbo);
-            // Delete OLD resources including RBO!
             createChartFrameBuffer(chart, (int)avail.x, (int)avail.y);
         }
+        renderTicksToFBO(chart, tickChart.series);
+        ImGui::Image((ImTextureID)(intptr_t)chart.colorTex, avail, ImVec2(0, 1), ImVec2(1, 0));
+
+        // Wheel zooms by powers of two about the right edge, drag scrolls,
+        // double-click fits everything again
+        TickView& ticks = chart.ticks;
+        if (ImGui::IsItemHovered()) {
+            ImGuiIO& io = ImGui::GetIO();
+            if (io.MouseWheel != 0.0f) {
+                int zoom = ticks.shownZoom + (io.MouseWheel > 0.0f ? -1 : 1);
+                if (zoom >= 0) {
+                    ticks.scroll = zoom > ticks.shownZoom ? ticks.scroll / 2 : ticks.scroll * 2;
+                    ticks.zoom = zoom;
+                }
+            }
+            if (ImGui::IsMouseDragging(ImGuiMouseButton_Left) && io.MouseDelta.x != 0.0f) {
+                long long scroll = (long long)ticks.scroll + (long long)io.MouseDelta.x;
+                ticks.scroll = (size_t)(std::max)(scroll, 0LL);
+                if (ticks.zoom < 0) ticks.zoom = ticks.shownZoom;
+            }
+            if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+                ticks.zoom = -1;
+                ticks.scroll = 0;
+            }
+        }
+    }
+    else if (chart.vao == 0 && chart.building)
+    {
+        // Placeholder until the first build lands
+        ImGui::TextDisabled("Loading %s...", chart.title.c_str());
+    }
+    else if (avail.x > 0 && avail.y > 0)
+    {
+        // The profile panel takes its width from the candles while there's room for both
+        float profileWidth = chart.profile.enabled && avail.x > 3.0f * kProfileWidth ? kProfileWidth : 0.0f;
+        ImVec2 chartSize(avail.x - profileWidth, avail.y);
+
+        // Optional: resize FBO if ImGui window resized
+        if ((int)chartSize.x != chart.width || (int)chartSize.y != chart.height)
+        {
+            glDeleteTextures(1, &chart.colorTex);
+            glDeleteFramebuffers(1, &chart.fbo);
+            // Delete OLD resources including RBO!
+            createChartFrameBuffer(chart, (int)chartSize.x, (int)chartSize.y);
+        }
 
         renderChartToFBO(chart, chart.shaderProgram, chart.vao, chart.numCandles);
 
         // Show FBO texture inside ImGui
-        ImGui::Image((ImTextureID)(intptr_t)chart.colorTex, avail, ImVec2(0, 1), ImVec2(1, 0));
+        ImGui::Image((ImTextureID)(intptr_t)chart.colorTex, chartSize, ImVec2(0, 1), ImVec2(1, 0));
+        if (profileWidth > 0.0f) {
+            ImGui::SameLine(0.0f, 0.0f);
+            drawVolumeProfile(chart, symbol, dataManager, ImVec2(profileWidth, avail.y));
+        }
     }
 
     ImGui::End();
 }
 
+// Volume (or time) at price of the bars on screen, drawn on the candles'
+// price axis so every row lines up with the candles beside it. Zooming
+// and live bars only move the window; the histogram is a VolumeProfile
+// query, requeried when the window or the bars change.
+void Renderer::drawVolumeProfile(ChartView& chart, SymbolId symbol, DataManager& dataManager, ImVec2 size)
+{
+    PROFILE_ZONE("Renderer::drawVolumeProfile");
+    const std::vector<CandleData>& bars = timeframeBars(dataManager, symbol, chart.timeframe);
+    ChartData& data = dataManager.charts[symbol];
+    VolumeProfile& profile = data.volumeProfiles[(size_t)chart.timeframe];
+    profile.update(bars, chart.timeframe, data.revision);
+
+    // Renko and range bricks have no time axis to line up with, so they get the whole history
+    size_t end = bars.size();
+    size_t begin = 0;
+    if (chart.chartType != ChartType::Renko && chart.chartType != ChartType::Range) {
+        size_t visible = (size_t)std::ceil(zoomLevel);
+        begin = end > visible ? end - visible : 0;
+    }
+    ProfileView& view = chart.profile;
+    if (begin != view.begin || end != view.end || data.revision != view.revision || chart.timeframe != view.timeframe) {
+        profile.query(begin, end, view.histogram);
+        view.begin = begin;
+        view.end = end;
+        view.revision = data.revision;
+        view.timeframe = chart.timeframe;
+    }
+
+    ImVec2 p0 = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton("##profile", size);
+    bool hovered = ImGui::IsItemHovered();
+    const ProfileHistogram& histogram = view.histogram;
+
+    // The price range renderChartToFBO projects
+    const float bottom = chart.minPrice - 2.0f;
+    const float top = chart.maxPrice + 2.0f;
+    if (histogram.bars == 0 || !(top > bottom)) return;
+    const float pixelsPerPrice = size.y / (top - bottom);
+    auto priceY = [&](double price) { return p0.y + (float)(top - price) * pixelsPerPrice; };
+
+    auto amountAt = [&](size_t bin) { return view.timeAtPrice ? (double)histogram.time[bin] : histogram.volume[bin]; };
+    double peak = 0.0;
+    for (size_t bin = 0; bin < VolumeProfile::kBins; bin++) peak = (std::max)(peak, amountAt(bin));
+    if (peak <= 0.0) return;
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->PushClipRect(p0, ImVec2(p0.x + size.x, p0.y + size.y), true);
+    drawList->AddRectFilled(p0, ImVec2(p0.x + size.x, p0.y + size.y), IM_COL32(20, 20, 24, 255));
+    for (size_t bin = 0; bin < VolumeProfile::kBins; bin++) {
+        double amount = amountAt(bin);
+        if (amount <= 0.0) continue;
+        double low = histogram.origin + bin * histogram.binWidth;
+        float y0 = priceY(low + histogram.binWidth);
+        float y1 = (std::max)(priceY(low), y0 + 1.0f);
+        if (y1 < p0.y || y0 > p0.y + size.y) continue;
+        bool valueArea = bin >= histogram.valueLowBin && bin <= histogram.valueHighBin;
+        ImU32 colour = bin == histogram.pocBin ? IM_COL32(230, 180, 60, 255)
+            : valueArea ? IM_COL32(90, 130, 200, 220) : IM_COL32(70, 80, 100, 160);
+        drawList->AddRectFilled(ImVec2(p0.x, y0), ImVec2(p0.x + (float)(amount / peak) * size.x, y1), colour);
+    }
+    float pocY = priceY(histogram.binPrice(histogram.pocBin));
+    drawList->AddLine(ImVec2(p0.x, pocY), ImVec2(p0.x + size.x, pocY), IM_COL32(230, 180, 60, 255));
+    drawList->PopClipRect();
+
+    if (hovered) {
+        double price = top - (ImGui::GetIO().MousePos.y - p0.y) / pixelsPerPrice;
+        double bin = std::floor((price - histogram.origin) / histogram.binWidth);
+        if (bin >= 0.0 && bin < (double)VolumeProfile::kBins) {
+            ImGui::SetTooltip("%.2f: %.0f volume, %u bars\nPOC %.2f, value area %.2f - %.2f\n%zu bars on screen",
+                histogram.binPrice((size_t)bin), histogram.volume[(size_t)bin], histogram.time[(size_t)bin],
+                histogram.binPrice(histogram.pocBin), histogram.binPrice(histogram.valueLowBin),
+                histogram.binPrice(histogram.valueHighBin), histogram.bars);
+        }
+    }
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void Renderer::processInput(GLFWwindow* window)
@@ -954,5 +2351,8 @@ void Renderer::init(GLFWwindow* window) {
 
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
+
+    // Compile the candle shader now rather than on the frame the first chart appears
+    chartProgram();
 }
 
@@ -24,22 +24,67 @@ using json = nlohmann::json;
 #include <unordered_map>
 #include <string>
 
+#include "expression.h"
+#include "order.h"
+#include "event_batch.h"
+#include "candle_store.h"
+#include "resample.h"
+#include "candle_vertices.h"
+#include "chart_builds.h"
+#include "tick_chart.h"
+#include "volume_profile.h"
+
 // Forward declarations
 struct CandleData;
 struct ScannerResult;
 struct DataManager;
+struct GpuResidency;
 
 struct CandleVertex {
     float x, y;
     float r, g, b;
 };
+// A chart view in tick mode: the tick chart's prints (DataManager::tickChart)
+// as a line of M4 columns, one per pixel. The vertex buffer holds only the
+// visible columns and is rebuilt when the prints, zoom, scroll or width change.
+struct TickView {
+	bool enabled = false;
+	int zoom = -1;              // log2 prints per pixel column; -1 fits every print
+	size_t scroll = 0;          // Columns back from the newest; 0 follows live prints
+	GLuint vao = 0;
+	GLuint vbo = 0;
+	size_t vboBytes = 0;
+	int vertices = 0;
+	float minPrice = 0.0f;
+	float maxPrice = 0.0f;
+	int shownZoom = 0;          // Resolved zoom of the last build
+	uint64_t builtRevision = UINT64_MAX;    // TickSeries::revision it was built from...
+	int builtZoom = 0;          // ...and the view it was built for
+	size_t builtScroll = 0;
+	int builtWidth = 0;
+};
+
+// The volume profile panel docked right of the candles: the bars on screen
+// binned by price on the chart's own price axis. The histogram is queried
+// from ChartData::volumeProfiles only when those bars change.
+struct ProfileView {
+	bool enabled = true;
+	bool timeAtPrice = false;   // Market profile: bars at each price instead of volume
+	ProfileHistogram histogram;
+	size_t begin = 0;           // Bars the histogram covers...
+	size_t end = 0;
+	uint64_t revision = UINT64_MAX;     // ...as of this ChartData::revision
+	Timeframe timeframe = Timeframe::M1;
+};
+
 struct ChartView {
+	SymbolId symbol = kNoSymbol;
 	GLuint fbo = 0;
 	GLuint shaderProgram = 0;
 	GLuint vao = 0;
 	GLuint vbo = 0;        
 	GLuint rbo = 0;        
-	GLuint numCandles;
+	GLuint numCandles = 0;
 	GLuint colorTex = 0;
 	int width = 0;
 	int height = 0;
@@ -50,15 +95,33 @@ struct ChartView {
 	float maxPrice = -1e9f;
 
 	bool isVisible = true;
+	uint64_t dataRevision = 0;  // ChartData::revision the vertex buffer was built from
+	Timeframe timeframe = Timeframe::M15;   // Bars are resampled from the 1-minute base
+	ChartType chartType = ChartType::Candles;   // Derived from those bars, see chartTypeBars()
+	double boxSize = 0.0;       // Renko and range bars
+	bool building = false;      // A ChartBuildQueue job is on its way
+	uint64_t buildRevision = 0; // What it was requested for
+	Timeframe buildTimeframe = Timeframe::M15;
+	ChartType buildChartType = ChartType::Candles;
+	size_t vertexBytes = 0;
+	uint64_t lastUsedNs = 0;    // Last frame it was drawn, for the memory budget
+	TickView ticks;
+	ProfileView profile;
+
+	// RGB8 colour textures are stored padded to 4 bytes per pixel
+	size_t gpuBytes() const { return vertexBytes + ticks.vboBytes + (fbo ? (size_t)width * height * 4 : 0); }
+    // shaderProgram is shared between all charts and owned by the Renderer
     void cleanup() {
         if (vao) glDeleteVertexArrays(1, &vao);
         if (vbo) glDeleteBuffers(1, &vbo);
-        if (shaderProgram) glDeleteProgram(shaderProgram);
         if (fbo) glDeleteFramebuffers(1, &fbo);
         if (rbo) glDeleteRenderbuffers(1, &rbo);
         if (colorTex) glDeleteTextures(1, &colorTex);
+        if (ticks.vao) glDeleteVertexArrays(1, &ticks.vao);
+        if (ticks.vbo) glDeleteBuffers(1, &ticks.vbo);
 
         vao = vbo = shaderProgram = fbo = rbo = colorTex = 0;
+        ticks = TickView{};
     }
     
 };
@@ -66,13 +129,65 @@ struct ChartView {
 struct Candle {
     float open, high, low, close;
 };
+
+// Watch-wall grid. Tiles are drawn into atlas textures of rowsPerPage
+// rows each, one FBO per page; tile i lives in cell (i % cols, i / cols)
+// of the grid, on page (i / cols) / rowsPerPage. Pages stay within
+// GL_MAX_TEXTURE_SIZE: cells wider than that allows are rendered smaller
+// and stretched on screen.
+struct ChartGrid {
+	struct Page {
+		GLuint fbo = 0;
+		GLuint tex = 0;
+		int rows = 0;
+	};
+	std::vector<Page> pages;
+	int tileW = 0;              // Requested (on-screen) tile size
+	int tileH = 0;
+	int cellW = 0;              // Atlas cell size, clamped to the texture limit
+	int cellH = 0;
+	int cols = 4;
+	int rows = 0;
+	int rowsPerPage = 0;
+	bool failed = false;        // A page framebuffer was incomplete
+
+	// What each atlas cell currently holds, so unchanged tiles are not redrawn
+	struct TileState {
+		GLuint vao = 0;
+		float zoom = 0.0f;
+	};
+	std::vector<TileState> tiles;
+
+	void cleanup() {
+		for (Page& page : pages) {
+			if (page.fbo) glDeleteFramebuffers(1, &page.fbo);
+			if (page.tex) glDeleteTextures(1, &page.tex);
+		}
+		pages.clear();
+		tiles.clear();
+	}
+};
+
+// Row order and formatted cells for a clipped, sortable table. Rebuilt
+// only when the data revision or the sort spec changes; drawing a frame
+// touches just the visible rows.
+struct TableCache {
+	uint64_t revision = ~0ull;      // Data revision the cache was built from
+	int sortColumn = -1;
+	bool ascending = true;
+	int columns = 0;
+	std::vector<int> order;         // Display row -> source row
+	std::vector<std::string> cells; // Display row * columns + column
+
+	const std::string& cell(int row, int column) const { return cells[(size_t)row * columns + column]; }
+};
 class Renderer
 {
 public:
     Renderer();
     ~Renderer();
     void init(GLFWwindow* window);
-    void ScannerGUI(const ScannerResult& scanResults);
+    void ScannerGUI(const ScannerResult& scanResults, uint64_t revision);
     void OverlayTickerGUI();
     void DrawChartGUI(DataManager& dataManager);
     void DockSetting();
@@ -81,14 +196,35 @@ public:
     void RenderTradingWindows(DataManager& dataManager);
     void RenderAnalysisWindows(DataManager& dataManager);
     void Portfolio(DataManager& dataManager);
+    void StrategyEditor(DataManager& dataManager);
+    void ChartGridGUI(DataManager& dataManager);
+    void ProfilerGUI(DataManager& dataManager);
+    void MarketDepthGUI(DataManager& dataManager);
+    void OrderEntryGUI(DataManager& dataManager);
+    void TimeAndSalesGUI(DataManager& dataManager);
+    void WatchlistGUI(DataManager& dataManager);
+
+    // Chart views for the memory budget. A released view keeps its window
+    // and settings; its geometry is rebuilt the next time it is shown.
+    void gpuResidency(std::vector<GpuResidency>& out) const;
+    void releaseChartView(ChartViewId id);
     int draw(class DataManager& dataManager);
     void oldGUI(DataManager& dataManager);
-    void CreateChartView(ChartView& aaplChart);
+    void CreateChartView(ChartView& chart, SymbolId symbol, DataManager& dataManager);
     static void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 
     // Callback for symbol input
     std::function<void(const std::string&)> onSymbolEntered;
-    std::function<void(const std::string&)> onScannerRowClicked;
+    std::function<void(SymbolId)> onScannerRowClicked;
+    std::function<void(SymbolId)> onChartRequested;
+    std::function<void(const std::string&)> onDepthRequested;
+    std::function<void(const std::string&)> onTapeRequested;
+    std::function<void(SymbolId)> onTickChartRequested;
+    std::function<bool(const std::string&, const OrderTemplate&, std::string&)> onOrderRequested;
+    std::function<void(int)> onCancelRequested;
+    std::function<void(const std::string&)> onWatchlistAdd;
+    std::function<void()> onWatchlistClear;
+    std::function<void(SymbolId)> onWatchlistRowClicked;
 
 private:
     // TC2000-style global symbol capture
@@ -98,7 +234,60 @@ private:
     std::vector<CandleVertex> vertices;
 
     // Chart management
-    std::unordered_map<std::string, ChartView> m_chartViews;
+    // Every chart window. Each symbol has a primary view (its chart window
+    // and grid tile); "+" opens further views of it, each with its own
+    // timeframe and chart type over the same base bars.
+    std::unordered_map<ChartViewId, ChartView> m_chartViews;
+    std::unordered_map<SymbolId, ChartViewId> m_primaryViews;
+    std::vector<ChartViewId> m_extraViews;      // In the order they were opened
+    ChartViewId m_nextViewId = 1;
+    ChartBuildQueue m_chartBuilds;
+    static constexpr uint64_t kChartBuildBudgetNs = 2000000;   // UI thread time per frame for chart uploads
+    GLuint m_chartProgram = 0;      // One candle shader shared by every chart
+    GLint m_projectionLoc = -1;
+    ChartGrid m_grid;
+    TableCache m_scannerTable;
+    TableCache m_positionsTable;
+
+    char m_orderSymbol[16] = "";
+    OrderTemplate m_buyTemplate;        // Re-validated only when the inputs change
+    OrderTemplate m_sellTemplate;
+    std::string m_orderTemplateError;
+    std::string m_orderError;
+    std::vector<float> m_latencySamples;
+
+    char m_tapeSymbol[16] = "";
+    TapeFilter m_tapeFilter;
+
+    char m_watchlistInput[256] = "";
+    bool m_watchlistFlash = true;
+    bool m_watchlistSimulate = false;
+    float m_watchlistTickRate = 5.0f;   // Simulated ticks per row per second
+    size_t m_watchlistFormatted = 0;    // Rows re-formatted this frame
+
+    char m_depthSymbol[16] = "";
+    double m_depthBenchmark = 0.0;     // Book updates/s from the replay benchmark
+
+    bool m_showProfiler = false;
+    std::string m_lastTraceFile;
+    EventAllocStats m_eventAllocHeap;
+    EventAllocStats m_eventAllocArena;
+    CompressionStats m_compressionCharts;   // Every loaded chart
+    CompressionStats m_compressionSynthetic;
+    ResampleBenchmark m_resampleBenchmark;
+    ChartTypeBenchmark m_chartTypeBenchmark;
+    VolumeProfileBenchmark m_volumeProfileBenchmark;
+    VertexBenchmark m_vertexBenchmarks[2];  // 1M and 10M candles
+    bool m_benchmarkRunning = false;        // One pool benchmark at a time
+
+    // Strategy Editor state
+    char m_strategySource[512] = "close > sma(close,50) and rsi(14) < 30";
+    CompiledExpression m_strategy;
+    ExprScratch m_strategyScratch;
+    std::string m_strategyError;
+    std::vector<SymbolId> m_strategyMatches;      // Symbols whose last bar passes the screen
+    size_t m_strategySignalCount = 0;
+    double m_strategyBarsPerSec = 0.0;
 
 
     // 2. Zooming Variables
@@ -114,17 +303,29 @@ private:
     static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
     std::vector<float> prepareCandleDataFromJson(const std::string& filename);
-    std::pair<std::vector<float>, std::pair<float, float>> prepareCandleDataFromVector(const std::vector<struct CandleData>& candles);
     std::pair<GLuint, int> initCandleDataFromJson(std::string jsonFile);
-    std::tuple<GLuint, GLuint, int> initCandleDataFromVector(const std::vector<float>& candleVertices);
     unsigned int createShaderProgram();
 
     void onScroll(double xoffset, double yoffset);
     void createChartFrameBuffer(ChartView& chart, int w, int h);
     void renderChartToFBO(ChartView& chart, GLuint shaderProgram, GLuint VAO, int numCandles);
+    void renderTicksToFBO(ChartView& chart, const TickSeries& series);
+    std::vector<M4Column> m_tickColumns;    // Scratch for renderTicksToFBO
+    std::vector<float> m_tickVertices;
+    static constexpr float kProfileWidth = 110.0f;
+    void drawVolumeProfile(ChartView& chart, SymbolId symbol, DataManager& dataManager, ImVec2 size);
 
     void DisableTitleFocusColors();
-    ChartView createChartFromData(const std::string& symbol, const std::vector<struct CandleData>& candles);
+    ChartView& chartViewFor(SymbolId symbol, DataManager& dataManager);
+    ChartViewId createChartView(SymbolId symbol);
+    void openChartView(const ChartView& from);
+    void refreshChartView(ChartViewId id, ChartView& view, DataManager& dataManager);
+    void drawExtraChartViews(DataManager& dataManager);
+    void requestChartBuild(ChartViewId id, ChartView& view, DataManager& dataManager);
+    void installChartGeometry(ChartGeometry& geometry);
+    GLuint chartProgram();
+    void ensureGridAtlas(int tileW, int tileH, int cols, int rows);
+    void renderGridTiles(const std::vector<std::pair<int, const ChartView*>>& tiles);
 
 
     // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
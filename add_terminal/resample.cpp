@@ -0,0 +1,317 @@
+#include "resample.h"
+#include "DataManager.h"
+#include "memory_budget.h"
+#include "profiler.h"
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <map>
+
+namespace {
+
+constexpr size_t kParallelChunkBars = 32768;    // Below this a chunk isn't worth a thread
+
+int64_t floorDiv(int64_t a, int64_t b)
+{
+	int64_t q = a / b;
+	return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+int64_t bucketSeconds(Timeframe timeframe)
+{
+	switch (timeframe) {
+	case Timeframe::M1: return 60;
+	case Timeframe::M5: return 300;
+	case Timeframe::M15: return 900;
+	case Timeframe::H1: return 3600;
+	case Timeframe::H4: return 14400;
+	default: return 86400;
+	}
+}
+
+// Equal keys share a bucket. Intraday keys are the bucket's start time
+// counted from the session open; daily and weekly keys are day numbers.
+int64_t bucketKey(int64_t time, Timeframe timeframe, int64_t sessionOpen)
+{
+	int64_t day = floorDiv(time, 86400);
+	switch (timeframe) {
+	case Timeframe::D1:
+		return day;
+	case Timeframe::W1:
+		return day - (day + 3 - floorDiv(day + 3, 7) * 7);   // Monday; 1970-01-01 was a Thursday
+	default: {
+		int64_t size = bucketSeconds(timeframe);
+		int64_t sinceOpen = time - day * 86400 - sessionOpen;
+		return day * 86400 + sessionOpen + floorDiv(sinceOpen, size) * size;
+	}
+	}
+}
+
+// times[0] is base[begin]. An unparseable date joins the bar before it
+// rather than splitting a bucket.
+void parseTimes(const CandleData* base, size_t begin, size_t end, int64_t* times)
+{
+	int64_t previous = 0;
+	for (size_t i = begin; i < end; i++) {
+		int64_t& time = times[i - begin];
+		if (!CompressedSeries::parseBarTime(base[i].date, time)) time = previous;
+		previous = time;
+	}
+}
+
+// Most common time of day of each day's first bar
+int64_t detectSessionOpen(const int64_t* times, size_t count)
+{
+	std::map<int64_t, size_t> firstBars;
+	int64_t lastDay = INT64_MIN;
+	for (size_t i = 0; i < count; i++) {
+		int64_t day = floorDiv(times[i], 86400);
+		if (day != lastDay) firstBars[times[i] - day * 86400]++;
+		lastDay = day;
+	}
+	int64_t open = 0;
+	size_t best = 0;
+	for (const auto& [secondOfDay, days] : firstBars) {
+		if (days > best) {
+			best = days;
+			open = secondOfDay;
+		}
+	}
+	return open;
+}
+
+// Appends the bars for base[begin, end) to out; begin must start a bucket
+// and times[0] is base[begin]. Returns the first base index of the last
+// bar written.
+size_t aggregate(const CandleData* base, const int64_t* times, size_t begin, size_t end,
+	Timeframe timeframe, int64_t sessionOpen, std::vector<CandleData>& out)
+{
+	const bool dateOnly = timeframe == Timeframe::D1 || timeframe == Timeframe::W1;
+	size_t lastStart = begin;
+	int64_t key = 0;
+	for (size_t i = begin; i < end; i++) {
+		const CandleData& bar = base[i];
+		int64_t barKey = bucketKey(times[i - begin], timeframe, sessionOpen);
+		if (i == begin || barKey != key) {
+			key = barKey;
+			lastStart = i;
+			out.push_back({ dateOnly ? bar.date.substr(0, 8) : bar.date, bar.open, bar.high, bar.low, bar.close, bar.volume });
+			continue;
+		}
+		CandleData& current = out.back();
+		current.high = (std::max)(current.high, bar.high);
+		current.low = (std::min)(current.low, bar.low);
+		current.close = bar.close;
+		current.volume += bar.volume;
+	}
+	return lastStart;
+}
+
+// Pool workers plus the calling thread, which works while it waits
+unsigned resampleThreads(size_t bars)
+{
+	unsigned threads = TaskScheduler::threadCount() + 1;
+	return (unsigned)(std::min)((size_t)threads, (std::max)((size_t)1, bars / kParallelChunkBars));
+}
+
+} // namespace
+
+const char* timeframeName(Timeframe timeframe)
+{
+	switch (timeframe) {
+	case Timeframe::M1: return "1m";
+	case Timeframe::M5: return "5m";
+	case Timeframe::M15: return "15m";
+	case Timeframe::H1: return "1h";
+	case Timeframe::H4: return "4h";
+	case Timeframe::D1: return "1D";
+	case Timeframe::W1: return "1W";
+	default: return "?";
+	}
+}
+
+size_t ResampledSeries::bytes() const
+{
+	return m_bars.capacity() * sizeof(CandleData) + m_dateBytes;
+}
+
+void ResampledSeries::clear()
+{
+	m_bars = std::vector<CandleData>();
+	m_dateBytes = 0;
+	m_built = false;
+	m_lastStartDate.clear();
+	m_firstDate.clear();
+}
+
+void ResampledSeries::update(const std::vector<CandleData>& base, Timeframe timeframe, uint64_t revision)
+{
+	if (m_built && revision == m_revision) return;
+	m_revision = revision;
+
+	// Incremental only if everything before the last bucket is as it was
+	bool incremental = m_built && !m_bars.empty() && m_lastStart < base.size() &&
+		base[m_lastStart].date == m_lastStartDate && base.front().date == m_firstDate;
+	if (!incremental) {
+		rebuild(base, timeframe, resampleThreads(base.size()));
+		return;
+	}
+
+	PROFILE_ZONE("ResampledSeries::update");
+	std::vector<int64_t> times(base.size() - m_lastStart);
+	parseTimes(base.data(), m_lastStart, base.size(), times.data());
+	m_dateBytes -= stringHeapBytes(m_bars.back().date);
+	m_bars.pop_back();
+	size_t firstNew = m_bars.size();
+	m_lastStart = aggregate(base.data(), times.data(), m_lastStart, base.size(), timeframe, m_sessionOpen, m_bars);
+	m_lastStartDate = base[m_lastStart].date;
+	for (size_t i = firstNew; i < m_bars.size(); i++) m_dateBytes += stringHeapBytes(m_bars[i].date);
+}
+
+// Chunks are cut on bucket boundaries so no bucket spans two threads; the
+// per-chunk results are then concatenated in order
+void ResampledSeries::rebuild(const std::vector<CandleData>& base, Timeframe timeframe, unsigned threads)
+{
+	PROFILE_ZONE("ResampledSeries::rebuild");
+	m_bars.clear();
+	m_dateBytes = 0;
+	m_built = true;
+	if (base.empty()) {
+		m_lastStart = 0;
+		m_lastStartDate.clear();
+		m_firstDate.clear();
+		return;
+	}
+
+	const size_t count = base.size();
+	std::vector<int64_t> times(count);
+	threads = (std::max)(1u, threads);
+	std::vector<size_t> bounds(threads + 1);
+	for (unsigned t = 0; t <= threads; t++) bounds[t] = count * t / threads;
+
+	TaskGroup parsing;
+	for (unsigned t = 1; t < threads; t++) {
+		parsing.run([&, t]() { parseTimes(base.data(), bounds[t], bounds[t + 1], times.data() + bounds[t]); });
+	}
+	parseTimes(base.data(), bounds[0], bounds[1], times.data());
+	parsing.wait();
+
+	m_sessionOpen = detectSessionOpen(times.data(), count);
+	for (unsigned t = 1; t < threads; t++) {
+		size_t& cut = bounds[t];
+		cut = (std::max)(cut, bounds[t - 1]);
+		while (cut > bounds[t - 1] && cut < count &&
+			bucketKey(times[cut], timeframe, m_sessionOpen) == bucketKey(times[cut - 1], timeframe, m_sessionOpen)) {
+			cut++;
+		}
+	}
+
+	std::vector<std::vector<CandleData>> chunks(threads);
+	std::vector<size_t> lastStarts(threads, 0);
+	TaskGroup jobs;
+	auto run = [&](unsigned t) {
+		if (bounds[t] >= bounds[t + 1]) return;
+		chunks[t].reserve((bounds[t + 1] - bounds[t]) * 60 / bucketSeconds(timeframe) + 1);
+		lastStarts[t] = aggregate(base.data(), times.data() + bounds[t], bounds[t], bounds[t + 1], timeframe, m_sessionOpen, chunks[t]);
+	};
+	for (unsigned t = 1; t < threads; t++) jobs.run([&run, t]() { run(t); });
+	run(0);
+	jobs.wait();
+
+	size_t total = 0;
+	for (const auto& chunk : chunks) total += chunk.size();
+	m_bars.reserve(total);
+	for (unsigned t = 0; t < threads; t++) {
+		if (chunks[t].empty()) continue;
+		std::move(chunks[t].begin(), chunks[t].end(), std::back_inserter(m_bars));
+		m_lastStart = lastStarts[t];
+	}
+	m_lastStartDate = base[m_lastStart].date;
+	m_firstDate = base.front().date;
+	for (const CandleData& bar : m_bars) m_dateBytes += stringHeapBytes(bar.date);
+}
+
+void DailyHistory::assign(const std::vector<CandleData>& bars)
+{
+	m_history = bars;
+	m_built = false;
+}
+
+const std::vector<CandleData>& DailyHistory::merge(const std::vector<CandleData>& baseDays, uint64_t revision)
+{
+	if (m_built && revision == m_revision) return m_merged;
+	m_built = true;
+	m_revision = revision;
+
+	// Both are "yyyyMMdd", which sorts lexically
+	auto end = m_history.end();
+	if (!baseDays.empty()) {
+		end = std::lower_bound(m_history.begin(), m_history.end(), baseDays.front().date,
+			[](const CandleData& bar, const std::pmr::string& date) { return bar.date < date; });
+	}
+	m_merged.assign(m_history.begin(), end);
+	m_merged.insert(m_merged.end(), baseDays.begin(), baseDays.end());
+	return m_merged;
+}
+
+void DailyHistory::clearMerged()
+{
+	m_merged = std::vector<CandleData>();
+	m_built = false;
+}
+
+size_t DailyHistory::bytes() const
+{
+	return (m_history.capacity() + m_merged.capacity()) * sizeof(CandleData);
+}
+
+const std::vector<CandleData>& timeframeBars(DataManager& dataManager, SymbolId symbol, Timeframe timeframe)
+{
+	std::vector<CandleData>& base = residentCandles(dataManager, symbol);
+	if (timeframe == Timeframe::M1) return base;
+
+	ChartData& chart = dataManager.charts[symbol];
+	ResampledSeries& series = chart.timeframes[(size_t)timeframe];
+	if ((timeframe == Timeframe::D1 || timeframe == Timeframe::W1) && !chart.dailyHistory.empty()) {
+		ResampledSeries& days = chart.timeframes[(size_t)Timeframe::D1];
+		days.update(base, Timeframe::D1, chart.revision);
+		const std::vector<CandleData>& merged = chart.dailyHistory.merge(days.bars(), chart.revision);
+		if (timeframe == Timeframe::D1) return merged;
+		series.update(merged, timeframe, chart.revision);
+		return series.bars();
+	}
+	series.update(base, timeframe, chart.revision);
+	return series.bars();
+}
+
+ResampleBenchmark benchmarkResample(size_t baseBars)
+{
+	const int kAppends = 100;
+	ResampleBenchmark result;
+	std::vector<CandleData> base;
+	syntheticMinuteBars(baseBars + kAppends, base);
+	std::vector<CandleData> appends(base.end() - kAppends, base.end());
+	base.resize(baseBars);
+	result.baseBars = base.size();
+	result.threads = resampleThreads(base.size());
+
+	TimeframeCache cache;
+	uint64_t start = Profiler::now();
+	for (size_t tf = 1; tf < kTimeframeCount; tf++) cache[tf].rebuild(base, (Timeframe)tf, 1);
+	result.serialMs = (Profiler::now() - start) / 1.0e6;
+
+	start = Profiler::now();
+	for (size_t tf = 1; tf < kTimeframeCount; tf++) cache[tf].rebuild(base, (Timeframe)tf, result.threads);
+	result.parallelMs = (Profiler::now() - start) / 1.0e6;
+
+	// Live-style: one new minute bar at a time
+	uint64_t revision = 1;
+	start = Profiler::now();
+	for (const CandleData& bar : appends) {
+		base.push_back(bar);
+		revision++;
+		for (size_t tf = 1; tf < kTimeframeCount; tf++) cache[tf].update(base, (Timeframe)tf, revision);
+	}
+	result.appendUs = (Profiler::now() - start) / 1.0e3 / kAppends;
+	return result;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "symbols.h"
+
+struct CandleData;
+class DataManager;
+
+enum class Timeframe : uint8_t { M1, M5, M15, H1, H4, D1, W1, Count };
+constexpr size_t kTimeframeCount = (size_t)Timeframe::Count;
+
+const char* timeframeName(Timeframe timeframe);
+
+struct ResampleBenchmark {
+	size_t baseBars = 0;
+	unsigned threads = 0;
+	double parallelMs = 0.0;            // All timeframes
+	double serialMs = 0.0;
+	double appendUs = 0.0;              // One new base bar, all timeframes
+};
+
+// Bars of one timeframe derived from a 1-minute base series.
+//
+// Buckets are session-aware: intraday buckets are anchored at the session
+// open (the most common first bar of the day, 09:30 for US RTH data), so
+// 1h bars run 09:30-10:30 and the last one of the day is short; daily bars
+// are one per trading day and weekly bars start on Monday. Each bar is
+// labelled with the date of its first base bar.
+//
+// update() is incremental. The base may grow and its newest bars may be
+// rewritten (live bar, gap fill); only the last output bar and anything
+// after it are recomputed. Anything else is detected and rebuilt, split
+// across threads for long series.
+class ResampledSeries {
+public:
+	// No-op while revision (ChartData::revision) is unchanged
+	void update(const std::vector<CandleData>& base, Timeframe timeframe, uint64_t revision);
+	void clear();
+
+	const std::vector<CandleData>& bars() const { return m_bars; }
+	size_t bytes() const;                       // As counted by the memory budget
+
+private:
+	std::vector<CandleData> m_bars;
+	size_t m_dateBytes = 0;             // Heap held by m_bars' dates
+	bool m_built = false;
+	uint64_t m_revision = 0;
+	int64_t m_sessionOpen = 0;          // Seconds after midnight
+	size_t m_lastStart = 0;             // First base bar of the last output bar
+	std::pmr::string m_lastStartDate;   // Its date, to detect a rewritten base
+	std::pmr::string m_firstDate;
+
+	void rebuild(const std::vector<CandleData>& base, Timeframe timeframe, unsigned threads);
+	friend ResampleBenchmark benchmarkResample(size_t baseBars);
+};
+
+// Every derived timeframe of one chart; M1 is the base itself
+using TimeframeCache = std::array<ResampledSeries, kTimeframeCount>;
+
+// A year of daily bars from their own request, so D1 and W1 reach further
+// back than the month of 1-minute base. Days the base covers still come
+// from the base (and stay live with it); the history only adds the days
+// before its first one.
+class DailyHistory {
+public:
+	void assign(const std::vector<CandleData>& bars);
+	bool empty() const { return m_history.empty(); }
+
+	// The history before baseDays' first day, then baseDays (the base
+	// resampled to D1). No-op while revision is unchanged.
+	const std::vector<CandleData>& merge(const std::vector<CandleData>& baseDays, uint64_t revision);
+	void clearMerged();                 // Dropped with the resampled series; the history stays
+
+	size_t bytes() const;               // Daily dates fit the small-string buffer
+
+private:
+	std::vector<CandleData> m_history;
+	std::vector<CandleData> m_merged;
+	bool m_built = false;
+	uint64_t m_revision = 0;
+};
+
+// A chart's bars at a timeframe. The base is restored if it was evicted,
+// the symbol's shared cache entry brought up to date and returned. D1 and
+// W1 are built on the chart's DailyHistory once it has one.
+const std::vector<CandleData>& timeframeBars(DataManager& dataManager, SymbolId symbol, Timeframe timeframe);
+
+// Resamples a synthetic 1-minute base to every timeframe: full rebuilds in
+// parallel and on one thread, then an incremental one-bar append
+ResampleBenchmark benchmarkResample(size_t baseBars);
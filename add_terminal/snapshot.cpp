@@ -0,0 +1,441 @@
+#include "snapshot.h"
+#include "DataManager.h"
+#include "contracts.h"
+#include "memory_budget.h"
+#include "profiler.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <type_traits>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint32_t kMagic = 0x50534157;     // "WASP", warm start
+constexpr uint32_t kVersion = 2;         // 2: watchlist symbols
+constexpr uint32_t kContractMagic = 0x5443434B;     // "KCCT", contract cache
+constexpr uint32_t kContractVersion = 2;     // 1 could key options and futures by underlying
+
+// Read-only view of a whole file
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& filename)
+	{
+#ifdef _WIN32
+		m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE) return;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) return;
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_mapping) return;
+		m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_data) m_size = (size_t)size.QuadPart;
+#else
+		m_fd = open(filename.c_str(), O_RDONLY);
+		if (m_fd < 0) return;
+		struct stat st;
+		if (fstat(m_fd, &st) != 0 || st.st_size == 0) return;
+		void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+		if (data == MAP_FAILED) return;
+		m_data = static_cast<const char*>(data);
+		m_size = (size_t)st.st_size;
+#endif
+	}
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (m_data) UnmapViewOfFile(m_data);
+		if (m_mapping) CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+		if (m_data) munmap(const_cast<char*>(m_data), m_size);
+		if (m_fd >= 0) close(m_fd);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
+
+class SnapshotWriter {
+public:
+	template <typename T>
+	void pod(T value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void str(std::string_view text)
+	{
+		pod<uint32_t>((uint32_t)text.size());
+		m_buffer.append(text.data(), text.size());
+	}
+
+	void symbol(SymbolId id) { str(SymbolTable::name(id)); }
+
+	const std::string& buffer() const { return m_buffer; }
+
+private:
+	std::string m_buffer;
+};
+
+// Bounds-checked cursor over the mapped file. After the first short read
+// every read returns a zero value and ok() stays false.
+class SnapshotReader {
+public:
+	SnapshotReader(const char* data, size_t size) : m_cursor(data), m_end(data + size) {}
+
+	template <typename T>
+	T pod()
+	{
+		T value{};
+		if (!take(sizeof(T))) return value;
+		std::memcpy(&value, m_cursor - sizeof(T), sizeof(T));
+		return value;
+	}
+
+	std::string_view str()
+	{
+		uint32_t length = pod<uint32_t>();
+		if (!take(length)) return {};
+		return std::string_view(m_cursor - length, length);
+	}
+
+	SymbolId symbol()
+	{
+		std::string_view name = str();
+		return name.empty() ? kNoSymbol : SymbolTable::intern(name);
+	}
+
+	// Element count that can't claim more entries than bytes remain, so a
+	// corrupt count fails cleanly instead of reserving gigabytes
+	uint32_t count(size_t minBytesEach)
+	{
+		uint32_t n = pod<uint32_t>();
+		if ((size_t)(m_end - m_cursor) / minBytesEach < n) m_ok = false;
+		return m_ok ? n : 0;
+	}
+
+	bool ok() const { return m_ok; }
+
+private:
+	bool take(size_t bytes)
+	{
+		if (!m_ok || (size_t)(m_end - m_cursor) < bytes) {
+			m_ok = false;
+			return false;
+		}
+		m_cursor += bytes;
+		return true;
+	}
+
+	const char* m_cursor;
+	const char* m_end;
+	bool m_ok = true;
+};
+
+// Write beside the old file and swap, so a crash mid-write leaves the
+// previous one intact
+bool replaceFile(const std::string& filename, const std::string& contents, std::string& error)
+{
+	std::string tempName = filename + ".tmp";
+	{
+		std::ofstream file(tempName, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			error = "Cannot write " + tempName;
+			return false;
+		}
+		file.write(contents.data(), (std::streamsize)contents.size());
+		if (!file) {
+			error = "Write failed: " + tempName;
+			return false;
+		}
+	}
+	std::error_code ec;
+	std::filesystem::rename(tempName, filename, ec);
+	if (ec) {
+		error = "Cannot replace " + filename + ": " + ec.message();
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+bool saveSnapshot(const DataManager& dataManager, const std::string& filename, std::string& error)
+{
+	PROFILE_ZONE("saveSnapshot");
+	SnapshotWriter out;
+	out.pod(kMagic);
+	out.pod(kVersion);
+
+	// Evicted charts are decoded for the write but stay evicted
+	std::vector<CandleData> evicted;
+	out.pod<uint32_t>((uint32_t)dataManager.charts.size());
+	for (const auto& [symbol, chart] : dataManager.charts) {
+		const std::vector<CandleData>* candles = &chart.candles;
+		if (chart.tier != CandleTier::Resident) {
+			if (!readCandles(chart, evicted)) evicted.clear();
+			candles = &evicted;
+		}
+		out.symbol(symbol);
+		out.pod<uint32_t>((uint32_t)candles->size());
+		for (const CandleData& candle : *candles) {
+			out.str(candle.date);
+			out.pod(candle.open);
+			out.pod(candle.high);
+			out.pod(candle.low);
+			out.pod(candle.close);
+			out.pod<int64_t>(candle.volume);
+		}
+	}
+	out.symbol(dataManager.activeSymbol);
+	out.symbol(dataManager.depthSymbol);
+	out.symbol(dataManager.tapeSymbol);
+
+	const ScannerResult& scanner = dataManager.currentScannerResult;
+	out.pod<int32_t>(scanner.reqId);
+	out.pod<uint32_t>((uint32_t)scanner.items.size());
+	for (const ScannerResultItem& item : scanner.items) {
+		out.pod<int32_t>(item.rank);
+		out.symbol(item.symbol);
+		out.str(item.secType);
+		out.str(item.currency);
+		out.pod<int64_t>(item.conId);
+	}
+
+	const AccountData& account = dataManager.accountData;
+	out.pod<uint32_t>((uint32_t)account.accountValues.size());
+	for (const auto& [key, value] : account.accountValues) {
+		out.str(value.key);
+		out.str(value.value);
+		out.str(value.currency);
+		out.str(value.accountName);
+	}
+	out.pod<uint32_t>((uint32_t)account.positions.size());
+	for (const PositionUpdate& position : account.positions) {
+		out.str(position.account);
+		out.symbol(position.symbol);
+		out.str(position.secType);
+		out.pod(position.position);
+		out.pod(position.marketPrice);
+		out.pod(position.marketValue);
+		out.pod(position.averageCost);
+		out.pod(position.unrealizedPNL);
+		out.pod(position.realizedPNL);
+	}
+	out.pod(account.totalValue);
+	out.pod(account.availableFunds);
+	out.pod(account.buyingPower);
+
+	// Subscribed rows only; simulated ones are not worth keeping
+	const Watchlist& watchlist = dataManager.watchlist;
+	uint32_t watched = 0;
+	for (const Watchlist::Row& row : watchlist.rows()) watched += row.reqId > 0;
+	out.pod(watched);
+	for (const Watchlist::Row& row : watchlist.rows()) {
+		if (row.reqId > 0) out.symbol(row.symbol);
+	}
+
+	return replaceFile(filename, out.buffer(), error);
+}
+
+bool loadSnapshot(DataManager& dataManager, const std::string& filename, std::string& error)
+{
+	PROFILE_ZONE("loadSnapshot");
+	MappedFile file(filename);
+	if (!file.data()) {
+		error = "No snapshot at " + filename;
+		return false;
+	}
+
+	SnapshotReader in(file.data(), file.size());
+	if (in.pod<uint32_t>() != kMagic || in.pod<uint32_t>() != kVersion) {
+		error = filename + " is not a snapshot from this version";
+		return false;
+	}
+
+	// Decode into a scratch DataManager so a truncated file changes nothing
+	DataManager loaded;
+
+	uint32_t chartCount = in.count(8);
+	for (uint32_t i = 0; i < chartCount && in.ok(); i++) {
+		SymbolId symbol = in.symbol();
+		ChartData& chart = loaded.charts[symbol];
+		chart.symbol = symbol;
+		chart.reqId = 0;
+		chart.revision = 1;
+		uint32_t candleCount = in.count(44);
+		chart.candles.resize(candleCount);
+		for (CandleData& candle : chart.candles) {
+			candle.date = in.str();
+			candle.open = in.pod<double>();
+			candle.high = in.pod<double>();
+			candle.low = in.pod<double>();
+			candle.close = in.pod<double>();
+			candle.volume = (long)in.pod<int64_t>();
+		}
+	}
+	loaded.activeSymbol = in.symbol();
+	loaded.depthSymbol = in.symbol();
+	loaded.tapeSymbol = in.symbol();
+
+	ScannerResult& scanner = loaded.currentScannerResult;
+	scanner.reqId = in.pod<int32_t>();
+	uint32_t itemCount = in.count(24);
+	for (uint32_t i = 0; i < itemCount && in.ok(); i++) {
+		ScannerResultItem item;
+		item.rank = in.pod<int32_t>();
+		item.symbol = in.symbol();
+		item.secType = in.str();
+		item.currency = in.str();
+		item.conId = (long)in.pod<int64_t>();
+		scanner.items.push_back(std::move(item));
+	}
+
+	AccountData& account = loaded.accountData;
+	uint32_t valueCount = in.count(16);
+	for (uint32_t i = 0; i < valueCount && in.ok(); i++) {
+		AccountValueUpdate value;
+		value.key = in.str();
+		value.value = in.str();
+		value.currency = in.str();
+		value.accountName = in.str();
+		account.accountValues[value.key] = std::move(value);
+	}
+	uint32_t positionCount = in.count(60);
+	for (uint32_t i = 0; i < positionCount && in.ok(); i++) {
+		PositionUpdate position;
+		position.account = in.str();
+		position.symbol = in.symbol();
+		position.secType = in.str();
+		position.position = in.pod<double>();
+		position.marketPrice = in.pod<double>();
+		position.marketValue = in.pod<double>();
+		position.averageCost = in.pod<double>();
+		position.unrealizedPNL = in.pod<double>();
+		position.realizedPNL = in.pod<double>();
+		account.positions.push_back(std::move(position));
+	}
+	account.totalValue = in.pod<double>();
+	account.availableFunds = in.pod<double>();
+	account.buyingPower = in.pod<double>();
+
+	// Placeholder reqIds; App re-subscribes each row with a real one
+	uint32_t watchCount = in.count(4);
+	for (uint32_t i = 0; i < watchCount && in.ok(); i++) {
+		loaded.watchlist.add(in.symbol(), -(int)(i + 1));
+	}
+
+	if (!in.ok()) {
+		error = filename + " is truncated or corrupt";
+		return false;
+	}
+
+	dataManager.charts = std::move(loaded.charts);
+	dataManager.activeSymbol = loaded.activeSymbol;
+	dataManager.depthSymbol = loaded.depthSymbol;
+	dataManager.tapeSymbol = loaded.tapeSymbol;
+	dataManager.currentScannerResult = std::move(loaded.currentScannerResult);
+	dataManager.scannerRevision++;
+	dataManager.accountData.accountValues = std::move(account.accountValues);
+	dataManager.accountData.positions = std::move(account.positions);
+	dataManager.accountData.totalValue = account.totalValue;
+	dataManager.accountData.availableFunds = account.availableFunds;
+	dataManager.accountData.buyingPower = account.buyingPower;
+	dataManager.accountData.positionsRevision++;
+	dataManager.watchlist = std::move(loaded.watchlist);
+	return true;
+}
+
+bool saveContractCache(const std::string& filename, std::string& error)
+{
+	PROFILE_ZONE("saveContractCache");
+	std::vector<std::pair<SymbolId, ContractInfo>> contracts = ContractCache::entries();
+	SnapshotWriter out;
+	out.pod(kContractMagic);
+	out.pod(kContractVersion);
+	out.pod<uint32_t>((uint32_t)contracts.size());
+	for (const auto& [symbol, info] : contracts) {
+		out.symbol(symbol);
+		out.pod<int64_t>(info.conId);
+		out.str(info.secType);
+		out.str(info.currency);
+		out.str(info.exchange);
+		out.str(info.primaryExchange);
+		out.pod(info.minTick);
+		out.str(info.longName);
+	}
+	if (!replaceFile(filename, out.buffer(), error)) return false;
+	ContractCache::markSaved();
+	return true;
+}
+
+bool loadContractCache(const std::string& filename, std::string& error)
+{
+	PROFILE_ZONE("loadContractCache");
+	MappedFile file(filename);
+	if (!file.data()) {
+		error = "No contract cache at " + filename;
+		return false;
+	}
+
+	SnapshotReader in(file.data(), file.size());
+	if (in.pod<uint32_t>() != kContractMagic || in.pod<uint32_t>() != kContractVersion) {
+		error = filename + " is not a contract cache from this version";
+		return false;
+	}
+
+	std::vector<std::pair<SymbolId, ContractInfo>> loaded;
+	uint32_t count = in.count(41);
+	for (uint32_t i = 0; i < count && in.ok(); i++) {
+		SymbolId symbol = in.symbol();
+		ContractInfo info;
+		info.conId = (long)in.pod<int64_t>();
+		info.secType = in.str();
+		info.currency = in.str();
+		info.exchange = in.str();
+		info.primaryExchange = in.str();
+		info.minTick = in.pod<double>();
+		info.longName = in.str();
+		loaded.emplace_back(symbol, std::move(info));
+	}
+	if (!in.ok()) {
+		error = filename + " is truncated or corrupt";
+		return false;
+	}
+
+	// Anything learned this run is newer than the file
+	for (const auto& [symbol, info] : loaded) ContractCache::learn(symbol, info);
+	ContractCache::markSaved();
+	return true;
+}
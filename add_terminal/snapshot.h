@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+class DataManager;
+
+// Warm-start snapshot of DataManager: charts, the last scanner result,
+// account data, watchlist symbols, and which chart, depth and tape symbols
+// were open. Written at shutdown and memory-mapped at launch, so the first
+// frame has data before TWS has answered anything.
+//
+// Binary and versioned. Symbols are stored by name since ids are only
+// valid within one process. A snapshot from another version is rejected
+// rather than migrated; the app just starts cold.
+bool saveSnapshot(const DataManager& dataManager, const std::string& filename, std::string& error);
+
+// Fills an empty DataManager. Does not touch anything but dataManager and
+// the symbol table, so it can run on a worker during GL/ImGui init.
+bool loadSnapshot(DataManager& dataManager, const std::string& filename, std::string& error);
+
+// The contract cache (contracts.h) in its own file: conIds stay valid for
+// the life of an instrument, so they outlive any one snapshot format.
+// Loading adds to the cache; call it before the IB threads start so their
+// first requests already go by conId.
+bool saveContractCache(const std::string& filename, std::string& error);
+bool loadContractCache(const std::string& filename, std::string& error);
@@ -0,0 +1,113 @@
+#include "symbols.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t kChunkBits = 12;
+constexpr size_t kChunkSize = size_t(1) << kChunkBits;
+constexpr size_t kMaxChunks = 1024;        // Room for ~4M symbols
+
+struct Entry {
+	std::string name;
+	std::atomic<long> conId{ 0 };
+};
+
+struct StringHash {
+	using is_transparent = void;
+	size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+};
+
+struct TableState {
+	std::shared_mutex mutex;
+	std::unordered_map<std::string, SymbolId, StringHash, std::equal_to<>> ids;
+	std::unordered_map<long, SymbolId> byConId;
+
+	// Chunks are allocated once and never move, so name() needs no lock.
+	// Id 0 is reserved for kNoSymbol and keeps an empty name.
+	std::unique_ptr<Entry[]> chunks[kMaxChunks];
+	std::atomic<uint32_t> count{ 1 };
+
+	TableState() { chunks[0].reset(new Entry[kChunkSize]); }
+
+	Entry& entry(SymbolId id) { return chunks[id >> kChunkBits][id & (kChunkSize - 1)]; }
+};
+
+TableState& table()
+{
+	static TableState s;
+	return s;
+}
+
+} // namespace
+
+SymbolId SymbolTable::intern(std::string_view symbol)
+{
+	if (symbol.empty()) return kNoSymbol;
+	TableState& t = table();
+	{
+		std::shared_lock<std::shared_mutex> lock(t.mutex);
+		auto it = t.ids.find(symbol);
+		if (it != t.ids.end()) return it->second;
+	}
+
+	std::unique_lock<std::shared_mutex> lock(t.mutex);
+	auto it = t.ids.find(symbol);
+	if (it != t.ids.end()) return it->second;
+
+	SymbolId id = t.count.load(std::memory_order_relaxed);
+	if ((id >> kChunkBits) >= kMaxChunks) return kNoSymbol;
+	if (!t.chunks[id >> kChunkBits]) t.chunks[id >> kChunkBits].reset(new Entry[kChunkSize]);
+	t.entry(id).name.assign(symbol);
+	t.ids.emplace(std::string(symbol), id);
+	t.count.store(id + 1, std::memory_order_release);
+	return id;
+}
+
+SymbolId SymbolTable::find(std::string_view symbol)
+{
+	TableState& t = table();
+	std::shared_lock<std::shared_mutex> lock(t.mutex);
+	auto it = t.ids.find(symbol);
+	return it != t.ids.end() ? it->second : kNoSymbol;
+}
+
+const std::string& SymbolTable::name(SymbolId id)
+{
+	TableState& t = table();
+	if (id >= t.count.load(std::memory_order_acquire)) id = kNoSymbol;
+	return t.entry(id).name;
+}
+
+void SymbolTable::bindConId(SymbolId id, long conId)
+{
+	if (id == kNoSymbol || conId == 0) return;
+	TableState& t = table();
+	std::unique_lock<std::shared_mutex> lock(t.mutex);
+	t.entry(id).conId.store(conId, std::memory_order_relaxed);
+	t.byConId[conId] = id;
+}
+
+long SymbolTable::conId(SymbolId id)
+{
+	TableState& t = table();
+	if (id >= t.count.load(std::memory_order_acquire)) return 0;
+	return t.entry(id).conId.load(std::memory_order_relaxed);
+}
+
+SymbolId SymbolTable::fromConId(long conId)
+{
+	TableState& t = table();
+	std::shared_lock<std::shared_mutex> lock(t.mutex);
+	auto it = t.byConId.find(conId);
+	return it != t.byConId.end() ? it->second : kNoSymbol;
+}
+
+size_t SymbolTable::size()
+{
+	return table().count.load(std::memory_order_acquire) - 1;
+}
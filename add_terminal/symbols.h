@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Compact id for a contract symbol. Ids are dense, start at 1 and are never
+// reused, so they can key maps and index arrays. 0 means "no symbol".
+using SymbolId = uint32_t;
+constexpr SymbolId kNoSymbol = 0;
+
+// Process-wide symbol table.
+//
+// Strings are interned once at the edges (user input, IB callbacks) and
+// everything in between passes ids around. Interning takes a lock; name()
+// does not, since names live in fixed chunks that never move.
+class SymbolTable {
+public:
+	static SymbolId intern(std::string_view symbol);
+	static SymbolId find(std::string_view symbol);     // kNoSymbol if never interned
+	static const std::string& name(SymbolId id);        // Empty for kNoSymbol
+
+	// IB contract id, when a callback has told us one
+	static void bindConId(SymbolId id, long conId);
+	static long conId(SymbolId id);                     // 0 if unknown
+	static SymbolId fromConId(long conId);
+
+	static size_t size();
+};
+
+inline const char* symbolName(SymbolId id)
+{
+	return SymbolTable::name(id).c_str();
+}
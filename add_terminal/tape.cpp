@@ -0,0 +1,80 @@
+#include "tape.h"
+
+TradeTape::TradeTape(size_t capacity)
+{
+	size_t size = 1;
+	while (size < capacity) size <<= 1;
+	m_ring.resize(size);
+	m_index.resize(size);
+	m_mask = size - 1;
+}
+
+void TradeTape::clear()
+{
+	m_head = 0;
+	m_indexHead = m_indexTail = 0;
+	m_lastPrice = 0.0;
+	m_lastDirection = 0;
+}
+
+size_t TradeTape::size() const
+{
+	return m_head < m_ring.size() ? (size_t)m_head : m_ring.size();
+}
+
+size_t TradeTape::filteredSize() const
+{
+	return m_filter.isActive() ? (size_t)(m_indexHead - m_indexTail) : size();
+}
+
+const TradePrint& TradeTape::newestFiltered(size_t i) const
+{
+	if (!m_filter.isActive()) return newest(i);
+	return m_ring[m_index[(m_indexHead - 1 - i) & m_mask] & m_mask];
+}
+
+void TradeTape::push(TradePrint print)
+{
+	// Zero-plus/zero-minus ticks keep the previous direction
+	if (m_lastPrice != 0.0 && print.price != m_lastPrice) {
+		m_lastDirection = print.price > m_lastPrice ? 1 : -1;
+	}
+	print.direction = m_lastDirection;
+	m_lastPrice = print.price;
+
+	uint64_t seq = m_head++;
+	m_ring[seq & m_mask] = print;
+
+	if (m_filter.isActive()) {
+		// Trim first: the slot the entry goes into may still hold the tail
+		trimIndex();
+		if (m_filter.accepts(print)) appendIndex(seq);
+	}
+}
+
+void TradeTape::appendIndex(uint64_t seq)
+{
+	if (m_indexHead - m_indexTail == m_index.size()) m_indexTail++;   // Full: drop the oldest
+	m_index[m_indexHead++ & m_mask] = seq;
+}
+
+// Drop index entries whose prints the ring has overwritten
+void TradeTape::trimIndex()
+{
+	uint64_t oldest = m_head - size();
+	while (m_indexTail < m_indexHead && m_index[m_indexTail & m_mask] < oldest) {
+		m_indexTail++;
+	}
+}
+
+void TradeTape::setFilter(const TapeFilter& filter)
+{
+	if (filter == m_filter) return;
+	m_filter = filter;
+	m_indexHead = m_indexTail = 0;
+	if (!m_filter.isActive()) return;
+
+	for (uint64_t seq = m_head - size(); seq < m_head; seq++) {
+		if (m_filter.accepts(m_ring[seq & m_mask])) appendIndex(seq);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TradePrint {
+	int64_t time;           // Unix seconds
+	double price;
+	double size;
+	int8_t direction;       // Tick test: +1 uptick, -1 downtick
+	char exchange[7];       // Fixed so the ring never allocates per print
+};
+
+// Size/price filter for the tape. Zero means "no bound".
+struct TapeFilter {
+	double minSize = 0.0;
+	double minPrice = 0.0;
+	double maxPrice = 0.0;
+
+	bool isActive() const { return minSize > 0.0 || minPrice > 0.0 || maxPrice > 0.0; }
+	bool accepts(const TradePrint& print) const {
+		return print.size >= minSize && print.price >= minPrice && (maxPrice <= 0.0 || print.price <= maxPrice);
+	}
+	bool operator==(const TapeFilter& other) const {
+		return minSize == other.minSize && minPrice == other.minPrice && maxPrice == other.maxPrice;
+	}
+};
+
+// Time & sales for one symbol: a fixed ring of the most recent prints.
+//
+// While a filter is set, the tape also keeps a ring of sequence numbers of
+// the prints that pass it. The index is built once when the filter changes
+// and extended on each push, so the UI can jump straight to the i-th
+// matching print without scanning.
+class TradeTape {
+public:
+	explicit TradeTape(size_t capacity = 1 << 16);     // Rounded up to a power of two
+
+	void push(TradePrint print);
+	void clear();
+
+	void setFilter(const TapeFilter& filter);
+	const TapeFilter& filter() const { return m_filter; }
+
+	size_t size() const;                // Prints retained
+	size_t filteredSize() const;        // Retained prints passing the filter
+	uint64_t totalPrints() const { return m_head; }
+
+	// 0 = newest
+	const TradePrint& newest(size_t i) const { return m_ring[(m_head - 1 - i) & m_mask]; }
+	const TradePrint& newestFiltered(size_t i) const;
+
+private:
+	std::vector<TradePrint> m_ring;
+	size_t m_mask;
+	uint64_t m_head = 0;                // Sequence number of the next print
+
+	TapeFilter m_filter;
+	std::vector<uint64_t> m_index;      // Sequence numbers passing m_filter
+	uint64_t m_indexHead = 0;
+	uint64_t m_indexTail = 0;           // Oldest index entry still in m_ring
+
+	double m_lastPrice = 0.0;
+	int8_t m_lastDirection = 0;
+
+	void trimIndex();
+	void appendIndex(uint64_t seq);
+};
@@ -0,0 +1,269 @@
+#include "task_scheduler.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Worker {
+	std::mutex mutex;
+	std::deque<std::function<void()>> queues[kTaskPriorityCount];
+	std::thread thread;
+};
+
+std::mutex g_lifecycle;                     // start/stop
+std::vector<std::unique_ptr<Worker>> g_workers;
+std::atomic<bool> g_running{ false };       // Set and cleared under g_sleepMutex
+std::atomic<unsigned> g_threadCount{ 0 };
+std::atomic<size_t> g_pending{ 0 };
+std::atomic<unsigned> g_nextWorker{ 0 };
+std::atomic<uint64_t> g_executed[kTaskPriorityCount];
+std::atomic<uint64_t> g_stolen{ 0 };
+std::mutex g_sleepMutex;
+std::condition_variable g_wake;
+
+constexpr int kGroupSpins = 64;             // Yields in TaskGroup::wait before it sleeps
+constexpr auto kGroupSleep = std::chrono::milliseconds(1);  // Then looks for eligible work again
+
+thread_local int t_worker = -1;             // Index into g_workers on pool threads
+
+std::mutex g_mainMutex;
+std::deque<std::function<void()>> g_mainQueue;
+uint64_t g_mainExecuted = 0;                // UI thread only
+double g_lastDrainMs = 0.0;
+double g_maxDrainMs = 0.0;
+
+bool popFrom(Worker& worker, size_t priority, bool back, std::function<void()>& out)
+{
+	std::lock_guard<std::mutex> lock(worker.mutex);
+	auto& queue = worker.queues[priority];
+	if (queue.empty()) return false;
+	if (back) {
+		out = std::move(queue.back());
+		queue.pop_back();
+	}
+	else {
+		out = std::move(queue.front());
+		queue.pop_front();
+	}
+	return true;
+}
+
+// Own queue first, then the others starting after self, one priority at a time
+bool take(int self, std::function<void()>& out, size_t& priority, size_t lowest = kTaskPriorityCount - 1)
+{
+	const size_t count = g_workers.size();
+	for (priority = 0; priority <= lowest; priority++) {
+		if (self >= 0 && popFrom(*g_workers[self], priority, true, out)) return true;
+		for (size_t i = 1; i <= count; i++) {
+			size_t victim = (size_t)(self + (int)i) % count;
+			if ((int)victim == self) continue;
+			if (popFrom(*g_workers[victim], priority, false, out)) {
+				if (self >= 0) g_stolen++;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void execute(std::function<void()>& task, size_t priority)
+{
+	g_pending--;
+	task();
+	g_executed[priority]++;
+}
+
+void workerLoop(int index)
+{
+	t_worker = index;
+	char name[32];
+	snprintf(name, sizeof(name), "Worker %d", index);
+	Profiler::setThreadName(name);
+
+	std::function<void()> task;
+	size_t priority = 0;
+	while (true) {
+		if (take(index, task, priority)) {
+			execute(task, priority);
+			task = nullptr;
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(g_sleepMutex);
+		g_wake.wait(lock, []() { return g_pending > 0 || !g_running; });
+		if (!g_running && g_pending == 0) return;
+	}
+}
+
+void startLocked(unsigned threads)
+{
+	if (g_running) return;
+	if (threads == 0) {
+		unsigned hardware = std::thread::hardware_concurrency();
+		threads = hardware > 1 ? hardware - 1 : 1;
+	}
+	// Queues exist before g_running lets submitters in; threads start after,
+	// since a worker that sees !g_running with nothing pending exits
+	for (unsigned i = 0; i < threads; i++) g_workers.push_back(std::make_unique<Worker>());
+	{
+		std::lock_guard<std::mutex> lock(g_sleepMutex);
+		g_running = true;
+	}
+	g_threadCount = threads;
+	for (unsigned i = 0; i < threads; i++) g_workers[i]->thread = std::thread(workerLoop, (int)i);
+	printf("Task scheduler: %u worker threads\n", threads);
+}
+
+} // namespace
+
+void TaskScheduler::start(unsigned threads)
+{
+	std::lock_guard<std::mutex> lock(g_lifecycle);
+	startLocked(threads);
+}
+
+void TaskScheduler::stop()
+{
+	std::lock_guard<std::mutex> lock(g_lifecycle);
+	if (!g_running) return;
+	{
+		std::lock_guard<std::mutex> sleep(g_sleepMutex);
+		g_running = false;
+	}
+	g_threadCount = 0;
+	g_wake.notify_all();
+	for (auto& worker : g_workers) worker->thread.join();
+	g_workers.clear();
+
+	std::lock_guard<std::mutex> main(g_mainMutex);
+	g_mainQueue.clear();
+}
+
+unsigned TaskScheduler::threadCount()
+{
+	return g_threadCount;
+}
+
+void TaskScheduler::submit(std::function<void()> task, TaskPriority priority)
+{
+	bool queued = false;
+	{
+		// Under the sleep lock so a worker can't check g_pending and then miss
+		// the notify, and stop() can't clear g_running between the check and
+		// the push and leave the task behind once the workers have exited
+		std::unique_lock<std::mutex> lock(g_sleepMutex);
+		if (g_running) {
+			int self = t_worker;
+			size_t index = self >= 0 ? (size_t)self : g_nextWorker++ % g_workers.size();
+			Worker& worker = *g_workers[index];
+			{
+				std::lock_guard<std::mutex> queueLock(worker.mutex);
+				worker.queues[(size_t)priority].push_back(std::move(task));
+			}
+			g_pending++;
+			queued = true;
+		}
+	}
+	if (!queued) {
+		task();
+		g_executed[(size_t)priority]++;
+		return;
+	}
+	g_wake.notify_one();
+}
+
+bool TaskScheduler::runOne(TaskPriority lowest)
+{
+	// Workers keep draining while stop() joins them; a group waiting on one
+	// may have its tasks on that worker's own queue
+	if (t_worker < 0 && !g_running) return false;
+	std::function<void()> task;
+	size_t priority = 0;
+	if (!take(t_worker, task, priority, (size_t)lowest)) return false;
+	execute(task, priority);
+	return true;
+}
+
+void TaskScheduler::postMain(std::function<void()> task)
+{
+	std::lock_guard<std::mutex> lock(g_mainMutex);
+	g_mainQueue.push_back(std::move(task));
+}
+
+size_t TaskScheduler::drainMain(uint64_t budgetNs)
+{
+	PROFILE_ZONE("TaskScheduler::drainMain");
+	const uint64_t startNs = Profiler::now();
+	size_t ran = 0;
+	while (ran == 0 || Profiler::now() - startNs < budgetNs) {
+		std::function<void()> task;
+		{
+			std::lock_guard<std::mutex> lock(g_mainMutex);
+			if (g_mainQueue.empty()) break;
+			task = std::move(g_mainQueue.front());
+			g_mainQueue.pop_front();
+		}
+		task();
+		ran++;
+	}
+	g_mainExecuted += ran;
+	g_lastDrainMs = (Profiler::now() - startNs) / 1.0e6;
+	g_maxDrainMs = (std::max)(g_maxDrainMs, g_lastDrainMs);
+	return ran;
+}
+
+TaskStats TaskScheduler::stats()
+{
+	TaskStats stats;
+	stats.threads = (unsigned)g_workers.size();
+	stats.pending = g_pending;
+	for (size_t p = 0; p < kTaskPriorityCount; p++) stats.executed[p] = g_executed[p];
+	stats.stolen = g_stolen;
+	{
+		std::lock_guard<std::mutex> lock(g_mainMutex);
+		stats.mainPending = g_mainQueue.size();
+	}
+	stats.mainExecuted = g_mainExecuted;
+	stats.lastDrainMs = g_lastDrainMs;
+	stats.maxDrainMs = g_maxDrainMs;
+	return stats;
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+	m_pending++;
+	TaskScheduler::submit([this, task = std::move(task)]() {
+		task();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_pending == 0) m_done.notify_all();
+	}, m_priority);
+}
+
+void TaskGroup::wait()
+{
+	int spins = 0;
+	while (m_pending > 0) {
+		if (TaskScheduler::runOne(m_priority)) {
+			spins = 0;
+		}
+		else if (spins < kGroupSpins) {
+			spins++;
+			std::this_thread::yield();
+		}
+		else {
+			// The rest is running elsewhere. Wake now and then anyway: a
+			// running task may queue more work this thread could take.
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait_for(lock, kGroupSleep, [this]() { return m_pending == 0; });
+		}
+	}
+	// The last task notifies under the lock; let it let go before the group can be destroyed
+	std::lock_guard<std::mutex> lock(m_mutex);
+}
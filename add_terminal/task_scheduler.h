@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+enum class TaskPriority : uint8_t { High, Normal, Low, Count };
+constexpr size_t kTaskPriorityCount = (size_t)TaskPriority::Count;
+
+struct TaskStats {
+	unsigned threads = 0;
+	size_t pending = 0;                         // Queued on the pool, not yet started
+	uint64_t executed[kTaskPriorityCount] = {};
+	uint64_t stolen = 0;                        // Taken from another worker's queue
+	size_t mainPending = 0;                     // Continuations waiting for the UI thread
+	uint64_t mainExecuted = 0;
+	double lastDrainMs = 0.0;
+	double maxDrainMs = 0.0;
+};
+
+// Process-wide work-stealing thread pool plus the UI thread's
+// continuation queue.
+//
+// Each worker owns one deque per priority. A task submitted from a worker
+// goes on the back of that worker's own deque and is popped LIFO while it
+// is still in cache; other submitters deal tasks round-robin. An idle
+// worker steals FIFO from the front of the others. Every worker looks for
+// High work everywhere before Normal, and Normal before Low, so user
+// facing work (the chart being opened) overtakes screens and imports.
+//
+// Tasks must not throw; use async() for a result or an exception.
+// Anything that touches GL or the DataManager goes back to the UI thread
+// through postMain(), which App::update drains under a time budget.
+class TaskScheduler {
+public:
+	// threads = 0: one per hardware thread, less one for the UI thread.
+	// Called by App::start.
+	static void start(unsigned threads = 0);
+	// Runs what is queued, joins the workers and drops pending continuations
+	static void stop();
+	static unsigned threadCount();              // 0 while the pool isn't running
+
+	// While the pool isn't running (before start(), or once stop() has
+	// begun) the task runs on the calling thread before this returns, so a
+	// task still draining at shutdown can submit more without a deadlock.
+	static void submit(std::function<void()> task, TaskPriority priority = TaskPriority::Normal);
+
+	template <typename F>
+	static auto async(F&& fn, TaskPriority priority = TaskPriority::Normal)
+		-> std::future<std::invoke_result_t<std::decay_t<F>>>
+	{
+		using Result = std::invoke_result_t<std::decay_t<F>>;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+		std::future<Result> result = task->get_future();
+		submit([task]() { (*task)(); }, priority);
+		return result;
+	}
+
+	// Runs one queued task of at least the given priority on the calling
+	// thread; false if there was none
+	static bool runOne(TaskPriority lowest = TaskPriority::Low);
+
+	// From any thread; runs on the UI thread in a later drainMain()
+	static void postMain(std::function<void()> task);
+	// UI thread: runs continuations in order until budgetNs is spent (at
+	// least one). Returns how many ran.
+	static size_t drainMain(uint64_t budgetNs);
+
+	static TaskStats stats();
+};
+
+// Fork/join over the pool. wait() runs queued tasks while it waits, so a
+// task may start a group of its own without tying up its worker. It only
+// picks up work at the group's priority or above, so a High group on the
+// UI thread never ends up running a long Low task. With nothing it may
+// run, it spins briefly and then sleeps until the group's last task ends.
+class TaskGroup {
+public:
+	explicit TaskGroup(TaskPriority priority = TaskPriority::Normal) : m_priority(priority) {}
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+	~TaskGroup() { wait(); }
+
+	void run(std::function<void()> task);
+	void wait();
+
+private:
+	TaskPriority m_priority;
+	std::atomic<size_t> m_pending{ 0 };
+	std::mutex m_mutex;                         // Guards the last decrement against wait() returning
+	std::condition_variable m_done;
+};
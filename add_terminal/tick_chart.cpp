@@ -0,0 +1,147 @@
+#include "tick_chart.h"
+#include "candle_vertices.h"
+#include "profiler.h"
+
+namespace {
+
+// The price continues the column; ties keep the earlier extreme
+inline void include(M4Column& column, float price)
+{
+	float low = column.low();
+	float high = column.high();
+	if (price < low) {
+		column.early = high;
+		column.late = price;
+	}
+	else if (price > high) {
+		column.early = low;
+		column.late = price;
+	}
+	column.last = price;
+}
+
+// left is immediately followed by right
+M4Column merge(const M4Column& left, const M4Column& right)
+{
+	bool lowFromLeft = left.low() <= right.low();
+	bool highFromLeft = left.high() >= right.high();
+	float low = lowFromLeft ? left.low() : right.low();
+	float high = highFromLeft ? left.high() : right.high();
+
+	bool lowFirst;
+	if (lowFromLeft != highFromLeft) {
+		lowFirst = lowFromLeft;
+	}
+	else {
+		const M4Column& both = lowFromLeft ? left : right;
+		lowFirst = both.early == both.low();
+	}
+	return M4Column{ left.first, lowFirst ? low : high, lowFirst ? high : low, right.last };
+}
+
+} // namespace
+
+void TickSeries::append(int64_t time, double price)
+{
+	const size_t index = m_prices.size();
+	m_times.push_back(time);
+	m_prices.push_back(price);
+	m_revision++;
+
+	const float p = (float)price;
+	if (m_levels.empty()) m_levels.emplace_back();
+	for (size_t i = 0; i < m_levels.size(); i++) {
+		std::vector<M4Column>& level = m_levels[i];
+		if ((index >> (kFirstCachedLevel + i)) == level.size()) level.push_back(M4Column{ p, p, p, p });
+		else include(level.back(), p);
+	}
+
+	// Grow the pyramid once its top has more than two columns
+	while (m_levels.back().size() > 2) {
+		const std::vector<M4Column>& below = m_levels.back();
+		std::vector<M4Column> level((below.size() + 1) / 2);
+		for (size_t c = 0; c < level.size(); c++) {
+			level[c] = 2 * c + 1 < below.size() ? merge(below[2 * c], below[2 * c + 1]) : below[2 * c];
+		}
+		m_levels.push_back(std::move(level));
+	}
+}
+
+void TickSeries::clear()
+{
+	std::vector<int64_t>().swap(m_times);
+	std::vector<double>().swap(m_prices);
+	std::vector<std::vector<M4Column>>().swap(m_levels);
+	m_revision++;
+}
+
+size_t TickSeries::bytes() const
+{
+	size_t total = m_times.capacity() * sizeof(int64_t) + m_prices.capacity() * sizeof(double);
+	for (const auto& level : m_levels) total += level.capacity() * sizeof(M4Column);
+	return total;
+}
+
+void TickSeries::columns(unsigned level, size_t firstColumn, size_t count, std::vector<M4Column>& out) const
+{
+	out.clear();
+	const size_t span = (size_t)1 << level;
+	const size_t total = (m_prices.size() + span - 1) >> level;
+	if (firstColumn >= total) return;
+	count = (std::min)(count, total - firstColumn);
+	out.reserve(count);
+
+	if (level < kFirstCachedLevel) {
+		for (size_t c = firstColumn; c < firstColumn + count; c++) {
+			size_t begin = c << level;
+			size_t end = (std::min)(begin + span, m_prices.size());
+			float p = (float)m_prices[begin];
+			M4Column column{ p, p, p, p };
+			for (size_t i = begin + 1; i < end; i++) include(column, (float)m_prices[i]);
+			out.push_back(column);
+		}
+		return;
+	}
+
+	const size_t cached = level - kFirstCachedLevel;
+	if (cached < m_levels.size()) {
+		const std::vector<M4Column>& columns = m_levels[cached];
+		out.assign(columns.begin() + firstColumn, columns.begin() + firstColumn + count);
+		return;
+	}
+
+	// Coarser than the pyramid goes: at most a few top columns per column
+	const std::vector<M4Column>& top = m_levels.back();
+	const size_t group = (size_t)1 << (cached - (m_levels.size() - 1));
+	for (size_t c = firstColumn; c < firstColumn + count; c++) {
+		size_t begin = c * group;
+		size_t end = (std::min)(begin + group, top.size());
+		M4Column column = top[begin];
+		for (size_t j = begin + 1; j < end; j++) column = merge(column, top[j]);
+		out.push_back(column);
+	}
+}
+
+void tickLineVertices(const std::vector<M4Column>& columns, std::vector<float>& out,
+	float& minPrice, float& maxPrice)
+{
+	PROFILE_ZONE("tickLineVertices");
+	out.resize(columns.size() * 4 * kFloatsPerVertex);
+	minPrice = 1e9f;
+	maxPrice = -1e9f;
+	float* vertex = out.data();
+	for (size_t c = 0; c < columns.size(); c++) {
+		const M4Column& column = columns[c];
+		const float x = (float)c + 0.5f;
+		for (float y : { column.first, column.early, column.late, column.last }) {
+			vertex[0] = x;
+			vertex[1] = y;
+			vertex[2] = 0.3f;
+			vertex[3] = 0.7f;
+			vertex[4] = 1.0f;
+			vertex += kFloatsPerVertex;
+		}
+		minPrice = (std::min)(minPrice, column.low());
+		maxPrice = (std::max)(maxPrice, column.high());
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One pixel column of a line chart, reduced M4-style: its first and last
+// price and its two extremes in the order they occurred. A polyline
+// through the four rasterises exactly like one through every point in the
+// column, so a view never needs more than four points per pixel.
+struct M4Column {
+	float first;
+	float early;                        // Whichever extreme came first
+	float late;
+	float last;
+
+	float low() const { return (std::min)(early, late); }
+	float high() const { return (std::max)(early, late); }
+};
+
+// Every trade print of a session as one line, x = print number.
+//
+// Columns are cached on ingest: level k of the pyramid has one M4Column
+// per 2^k prints, and each append updates the open column of every level.
+// A view zoomed to 2^k prints per pixel and scrolled by whole columns is
+// then a copy of width columns, however many millions of prints the
+// session holds. Below kFirstCachedLevel the columns cover so few prints
+// that they are reduced from the prices when asked for; above the top
+// level they are merged from it.
+class TickSeries {
+public:
+	static constexpr unsigned kFirstCachedLevel = 3;
+
+	void append(int64_t time, double price);    // Oldest first
+	void clear();
+
+	size_t size() const { return m_prices.size(); }
+	bool empty() const { return m_prices.empty(); }
+	int64_t time(size_t i) const { return m_times[i]; }
+	double price(size_t i) const { return m_prices[i]; }
+	int64_t lastTime() const { return m_times.empty() ? 0 : m_times.back(); }
+	uint64_t revision() const { return m_revision; }   // Bumped by every append
+	size_t bytes() const;
+
+	// Columns [firstColumn, firstColumn + count) of 2^level prints each,
+	// clipped to the prints there are. The last one may still be filling.
+	void columns(unsigned level, size_t firstColumn, size_t count, std::vector<M4Column>& out) const;
+
+private:
+	std::vector<int64_t> m_times;       // Unix seconds
+	std::vector<double> m_prices;
+	std::vector<std::vector<M4Column>> m_levels;   // [k - kFirstCachedLevel]
+	uint64_t m_revision = 0;
+};
+
+// Line strip vertices (candle_vertices.h layout) for columns, four per
+// column at x = column index + 0.5, with the price range they span
+void tickLineVertices(const std::vector<M4Column>& columns, std::vector<float>& out,
+	float& minPrice, float& maxPrice);
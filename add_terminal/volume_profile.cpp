@@ -0,0 +1,295 @@
+#include "volume_profile.h"
+#include "candle_store.h"
+#include "event.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PROFILE_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t kIngestChunk = 256;    // Prices gathered to floats this many bars at a time
+constexpr double kGridMargin = 0.25;    // Of the price range, each side, before a rebuild
+constexpr double kValueAreaShare = 0.7;
+constexpr size_t kAppendHeadroom = 4096;
+
+// Bin index of each price, clamped to the grid; false if any was off it
+bool binPrices(const float* prices, size_t count, float origin, float scale, uint16_t* out)
+{
+	const float top = (float)(VolumeProfile::kBins - 1);
+	size_t i = 0;
+	bool inside = true;
+#ifdef PROFILE_SIMD_SSE2
+	const __m128 vOrigin = _mm_set1_ps(origin);
+	const __m128 vScale = _mm_set1_ps(scale);
+	const __m128 vZero = _mm_setzero_ps();
+	const __m128 vTop = _mm_set1_ps(top);
+	const __m128 vLimit = _mm_set1_ps((float)VolumeProfile::kBins);
+	__m128 outside = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(prices + i), vOrigin), vScale);
+		outside = _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(x, vZero), _mm_cmpge_ps(x, vLimit)));
+		__m128i bins = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(x, vZero), vTop));
+		_mm_storel_epi64((__m128i*)(out + i), _mm_packs_epi32(bins, bins));
+	}
+	inside = _mm_movemask_ps(outside) == 0;
+#endif
+	for (; i < count; i++) {
+		float x = (prices[i] - origin) * scale;
+		if (!(x >= 0.0f && x < (float)VolumeProfile::kBins)) inside = false;
+		out[i] = (uint16_t)(x >= 0.0f ? (x < top ? x : top) : 0.0f);
+	}
+	return inside;
+}
+
+} // namespace
+
+void VolumeProfile::update(const std::vector<CandleData>& bars, Timeframe timeframe, uint64_t revision)
+{
+	if (m_built && revision == m_revision && timeframe == m_timeframe) return;
+	m_revision = revision;
+
+	// Incremental only if everything before the last bar is as it was
+	const size_t known = m_volume.size();
+	bool incremental = m_built && timeframe == m_timeframe && known > 0 && known <= bars.size() &&
+		bars[known - 1].date == m_lastDate && bars.front().date == m_firstDate;
+	m_timeframe = timeframe;
+	if (incremental) {
+		PROFILE_ZONE("VolumeProfile::update");
+		incremental = ingest(bars, known - 1);
+	}
+	if (!incremental) rebuild(bars);
+
+	m_firstDate = bars.empty() ? std::pmr::string() : bars.front().date;
+	m_lastDate = bars.empty() ? std::pmr::string() : bars.back().date;
+}
+
+void VolumeProfile::rebuild(const std::vector<CandleData>& bars)
+{
+	PROFILE_ZONE("VolumeProfile::rebuild");
+	m_built = true;
+	m_bin.clear();
+	m_lowBin.clear();
+	m_highBin.clear();
+	m_volume.clear();
+	m_prefixVolume.clear();
+	m_prefixTime.clear();
+	m_sealed = 0;
+	if (bars.empty()) return;
+
+	double low = 1e300;
+	double high = -1e300;
+	for (const CandleData& bar : bars) {
+		low = (std::min)(low, bar.low);
+		high = (std::max)(high, bar.high);
+	}
+	double range = high - low;
+	if (!(range > 0.0)) range = (std::max)(std::abs(high) * 0.01, 0.01);
+	m_binWidth = range * (1.0 + 2.0 * kGridMargin) / kBins;
+	m_origin = low - range * kGridMargin;
+
+	// Room for a session of live bars, so the first append doesn't copy everything
+	const size_t capacity = bars.size() + kAppendHeadroom;
+	m_bin.reserve(capacity);
+	m_lowBin.reserve(capacity);
+	m_highBin.reserve(capacity);
+	m_volume.reserve(capacity);
+	m_prefixVolume.reserve((capacity / kBlockBars + 1) * kBins);
+	m_prefixTime.reserve((capacity / kBlockBars + 1) * kBins);
+	ingest(bars, 0);    // Only non-finite prices can be off the grid; they are clamped
+}
+
+bool VolumeProfile::ingest(const std::vector<CandleData>& bars, size_t begin)
+{
+	const size_t count = bars.size();
+	m_bin.resize(count);
+	m_lowBin.resize(count);
+	m_highBin.resize(count);
+	m_volume.resize(count);
+
+	const float origin = (float)m_origin;
+	const float scale = (float)(1.0 / m_binWidth);
+	float typical[kIngestChunk];
+	float low[kIngestChunk];
+	float high[kIngestChunk];
+	bool inside = true;
+	for (size_t chunk = begin; chunk < count; chunk += kIngestChunk) {
+		const size_t n = (std::min)(kIngestChunk, count - chunk);
+		for (size_t j = 0; j < n; j++) {
+			const CandleData& bar = bars[chunk + j];
+			typical[j] = (float)((bar.high + bar.low + bar.close) / 3.0);
+			low[j] = (float)(std::min)(bar.low, bar.high);
+			high[j] = (float)(std::max)(bar.low, bar.high);
+			m_volume[chunk + j] = (float)bar.volume;
+		}
+		inside &= binPrices(typical, n, origin, scale, &m_bin[chunk]);
+		inside &= binPrices(low, n, origin, scale, &m_lowBin[chunk]);
+		inside &= binPrices(high, n, origin, scale, &m_highBin[chunk]);
+	}
+
+	// The last bar stays out of sealed blocks, it may be rewritten
+	while ((m_sealed + 1) * kBlockBars < count) seal();
+	return inside;
+}
+
+void VolumeProfile::seal()
+{
+	const size_t block = m_sealed;
+	m_prefixVolume.resize((block + 1) * kBins);
+	m_prefixTime.resize((block + 1) * kBins);
+	double* volume = &m_prefixVolume[block * kBins];
+	uint32_t* time = &m_prefixTime[block * kBins];
+	if (block > 0) {
+		std::copy(volume - kBins, volume, volume);
+		std::copy(time - kBins, time, time);
+	}
+
+	int32_t timeDelta[kBins + 1] = {};
+	accumulate(block * kBlockBars, (block + 1) * kBlockBars, volume, timeDelta);
+	int32_t covering = 0;
+	for (size_t bin = 0; bin < kBins; bin++) {
+		covering += timeDelta[bin];
+		time[bin] += (uint32_t)covering;
+	}
+	m_sealed++;
+}
+
+// Volume goes to the typical price's bin; a bar's time covers every bin
+// from its low to its high, recorded as +1/-1 at the ends
+void VolumeProfile::accumulate(size_t begin, size_t end, double* volume, int32_t* timeDelta) const
+{
+	for (size_t i = begin; i < end; i++) {
+		volume[m_bin[i]] += m_volume[i];
+		timeDelta[m_lowBin[i]]++;
+		timeDelta[m_highBin[i] + 1]--;
+	}
+}
+
+void VolumeProfile::query(size_t begin, size_t end, ProfileHistogram& out) const
+{
+	out.volume.assign(kBins, 0.0);
+	out.time.assign(kBins, 0);
+	out.origin = m_origin;
+	out.binWidth = m_binWidth;
+	end = (std::min)(end, m_volume.size());
+	begin = (std::min)(begin, end);
+	out.bars = end - begin;
+	out.totalVolume = 0.0;
+	out.pocBin = out.valueLowBin = out.valueHighBin = 0;
+	if (begin == end) return;
+
+	int32_t timeDelta[kBins + 1] = {};
+	const size_t firstBlock = (begin + kBlockBars - 1) / kBlockBars;   // First wholly inside
+	const size_t lastBlock = (std::min)(end / kBlockBars, m_sealed);   // One past the last
+	if (lastBlock > firstBlock) {
+		const double* volumeTo = &m_prefixVolume[(lastBlock - 1) * kBins];
+		const uint32_t* timeTo = &m_prefixTime[(lastBlock - 1) * kBins];
+		for (size_t bin = 0; bin < kBins; bin++) {
+			out.volume[bin] = volumeTo[bin];
+			out.time[bin] = timeTo[bin];
+		}
+		if (firstBlock > 0) {
+			const double* volumeFrom = &m_prefixVolume[(firstBlock - 1) * kBins];
+			const uint32_t* timeFrom = &m_prefixTime[(firstBlock - 1) * kBins];
+			for (size_t bin = 0; bin < kBins; bin++) {
+				out.volume[bin] = (std::max)(out.volume[bin] - volumeFrom[bin], 0.0);
+				out.time[bin] -= timeFrom[bin];
+			}
+		}
+		accumulate(begin, firstBlock * kBlockBars, out.volume.data(), timeDelta);
+		accumulate(lastBlock * kBlockBars, end, out.volume.data(), timeDelta);
+	}
+	else {
+		accumulate(begin, end, out.volume.data(), timeDelta);
+	}
+
+	int32_t covering = 0;
+	for (size_t bin = 0; bin < kBins; bin++) {
+		covering += timeDelta[bin];
+		out.time[bin] += (uint32_t)covering;
+		out.totalVolume += out.volume[bin];
+		if (out.volume[bin] > out.volume[out.pocBin]) out.pocBin = bin;
+	}
+
+	// Grow from the POC towards the heavier neighbour until the share is reached
+	size_t low = out.pocBin;
+	size_t high = out.pocBin;
+	double inArea = out.volume[out.pocBin];
+	while (inArea < out.totalVolume * kValueAreaShare && (low > 0 || high + 1 < kBins)) {
+		double below = low > 0 ? out.volume[low - 1] : -1.0;
+		double above = high + 1 < kBins ? out.volume[high + 1] : -1.0;
+		if (above >= below) inArea += out.volume[++high];
+		else inArea += out.volume[--low];
+	}
+	out.valueLowBin = low;
+	out.valueHighBin = high;
+}
+
+void VolumeProfile::clear()
+{
+	std::vector<uint16_t>().swap(m_bin);
+	std::vector<uint16_t>().swap(m_lowBin);
+	std::vector<uint16_t>().swap(m_highBin);
+	std::vector<float>().swap(m_volume);
+	std::vector<double>().swap(m_prefixVolume);
+	std::vector<uint32_t>().swap(m_prefixTime);
+	m_sealed = 0;
+	m_built = false;
+	m_firstDate.clear();
+	m_lastDate.clear();
+}
+
+size_t VolumeProfile::bytes() const
+{
+	return (m_bin.capacity() + m_lowBin.capacity() + m_highBin.capacity()) * sizeof(uint16_t) +
+		m_volume.capacity() * sizeof(float) + m_prefixVolume.capacity() * sizeof(double) +
+		m_prefixTime.capacity() * sizeof(uint32_t);
+}
+
+VolumeProfileBenchmark benchmarkVolumeProfile(size_t bars)
+{
+	const int kAppends = 100;
+	const int kQueries = 1000;
+	const size_t kWindow = 500;
+	VolumeProfileBenchmark result;
+	std::vector<CandleData> base;
+	syntheticMinuteBars(bars + kAppends, base);
+	std::vector<CandleData> appends(base.end() - kAppends, base.end());
+	base.resize(bars);
+	result.bars = base.size();
+
+	VolumeProfile profile;
+	uint64_t revision = 1;
+	uint64_t start = Profiler::now();
+	profile.update(base, Timeframe::M1, revision);
+	result.buildMs = (Profiler::now() - start) / 1.0e6;
+
+	// Windows wherever a pan might put them
+	ProfileHistogram histogram;
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<size_t> offset(0, base.size() > kWindow ? base.size() - kWindow : 0);
+	start = Profiler::now();
+	for (int i = 0; i < kQueries; i++) {
+		size_t begin = offset(rng);
+		profile.query(begin, begin + kWindow, histogram);
+	}
+	result.queryUs = (Profiler::now() - start) / 1.0e3 / kQueries;
+
+	start = Profiler::now();
+	for (int i = 0; i < kQueries; i++) profile.query(0, base.size(), histogram);
+	result.deepQueryUs = (Profiler::now() - start) / 1.0e3 / kQueries;
+
+	start = Profiler::now();
+	for (const CandleData& bar : appends) {
+		base.push_back(bar);
+		profile.update(base, Timeframe::M1, ++revision);
+	}
+	result.appendUs = (Profiler::now() - start) / 1.0e3 / kAppends;
+	return result;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "resample.h"
+
+struct CandleData;
+
+// Volume and time at price over a range of bars, on the profile's grid
+struct ProfileHistogram {
+	std::vector<double> volume;         // Per bin
+	std::vector<uint32_t> time;         // Bars whose low-high range covers the bin (market profile)
+	double origin = 0.0;                // Price at the bottom of bin 0
+	double binWidth = 0.0;
+	size_t bars = 0;
+	double totalVolume = 0.0;
+	size_t pocBin = 0;                  // Point of control: the most volume
+	size_t valueLowBin = 0;             // Value area: 70% of the volume around the POC
+	size_t valueHighBin = 0;
+
+	double binPrice(size_t bin) const { return origin + (bin + 0.5) * binWidth; }
+};
+
+struct VolumeProfileBenchmark {
+	size_t bars = 0;
+	double buildMs = 0.0;
+	double queryUs = 0.0;               // A 500-bar window anywhere in the series
+	double deepQueryUs = 0.0;           // Every bar
+	double appendUs = 0.0;
+};
+
+// Volume-by-price over any window of a chart's bars, cheap enough to
+// recompute every frame as the window zooms and pans.
+//
+// Bars are binned once, on ingest: typical price, low and high become bin
+// indices on a fixed grid (kBins over the series' range plus a margin),
+// four bars at a time with SSE2. Every kBlockBars bars a cumulative
+// histogram is sealed, so a window's profile is the difference of two
+// sealed rows plus the bars in the partial blocks at either end: at most
+// 2 * kBlockBars bars and kBins bins, however deep the history.
+//
+// update() is incremental like ResampledSeries: the last bar is re-binned
+// (live bar) and appends are binned; the grid is rebuilt when a price
+// leaves it or the bars change anywhere else.
+class VolumeProfile {
+public:
+	static constexpr size_t kBins = 512;
+	static constexpr size_t kBlockBars = 1024;
+
+	// No-op while revision (ChartData::revision) and timeframe are unchanged
+	void update(const std::vector<CandleData>& bars, Timeframe timeframe, uint64_t revision);
+	void clear();
+
+	// Bars [begin, end) as of the last update()
+	void query(size_t begin, size_t end, ProfileHistogram& out) const;
+
+	size_t size() const { return m_volume.size(); }
+	Timeframe timeframe() const { return m_timeframe; }
+	size_t bytes() const;
+
+private:
+	std::vector<uint16_t> m_bin;        // Typical price bin, where the volume goes
+	std::vector<uint16_t> m_lowBin;
+	std::vector<uint16_t> m_highBin;
+	std::vector<float> m_volume;
+	std::vector<double> m_prefixVolume; // Sealed block k: bins of bars [0, (k + 1) * kBlockBars)
+	std::vector<uint32_t> m_prefixTime;
+	size_t m_sealed = 0;                // Blocks sealed; never includes the last bar
+
+	double m_origin = 0.0;
+	double m_binWidth = 0.0;
+	bool m_built = false;
+	uint64_t m_revision = 0;
+	Timeframe m_timeframe = Timeframe::M1;
+	std::pmr::string m_firstDate;
+	std::pmr::string m_lastDate;        // Of the last bar, re-binned on the next update
+
+	void rebuild(const std::vector<CandleData>& bars);
+	bool ingest(const std::vector<CandleData>& bars, size_t begin);    // False if a price is off the grid
+	void seal();
+	void accumulate(size_t begin, size_t end, double* volume, int32_t* timeDelta) const;
+};
+
+// Builds the profile of a synthetic 1-minute series, then times window
+// queries and live appends
+VolumeProfileBenchmark benchmarkVolumeProfile(size_t bars);
@@ -0,0 +1,130 @@
+#include "watchlist.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+
+bool Watchlist::add(SymbolId symbol, int reqId)
+{
+	if (symbol == kNoSymbol || contains(symbol)) return false;
+
+	uint32_t index = (uint32_t)m_rows.size();
+	Row& row = m_rows.emplace_back();
+	row.symbol = symbol;
+	row.reqId = reqId;
+	row.dirty = (uint8_t)((1u << ColumnCount) - 1);
+	m_byReqId[reqId] = index;
+	m_bySymbol[symbol] = index;
+
+	m_dirtyRows.resize((m_rows.size() + 63) / 64, 0);
+	m_dirtyRows[index >> 6] |= 1ull << (index & 63);
+	return true;
+}
+
+void Watchlist::clear()
+{
+	m_rows.clear();
+	m_dirtyRows.clear();
+	m_byReqId.clear();
+	m_bySymbol.clear();
+}
+
+bool Watchlist::set(uint32_t index, Column column, double& field, double value, uint64_t nowNs)
+{
+	if (field == value) return false;
+
+	Row& row = m_rows[index];
+	if (field != 0.0) {
+		row.flashDirection[column] = value > field ? 1 : -1;
+		row.flashNs[column] = nowNs;
+	}
+	field = value;
+	row.dirty |= (uint8_t)(1u << column);
+	m_dirtyRows[index >> 6] |= 1ull << (index & 63);
+	return true;
+}
+
+void Watchlist::apply(const QuoteTick& tick, uint64_t nowNs)
+{
+	auto it = m_byReqId.find(tick.reqId);
+	if (it == m_byReqId.end()) return;    // Straggler from a removed row
+
+	uint32_t index = it->second;
+	Row& row = m_rows[index];
+	switch (tick.type) {
+	case QuoteTickType::Last:
+		if (set(index, Last, row.last, tick.value, nowNs)) row.dirty |= 1u << Change;
+		break;
+	case QuoteTickType::Close:
+		set(index, Change, row.close, tick.value, nowNs);
+		break;
+	case QuoteTickType::Bid:
+		set(index, Bid, row.bid, tick.value, nowNs);
+		break;
+	case QuoteTickType::Ask:
+		set(index, Ask, row.ask, tick.value, nowNs);
+		break;
+	case QuoteTickType::Volume:
+		set(index, Volume, row.volume, tick.value, nowNs);
+		break;
+	}
+}
+
+void Watchlist::formatRow(Row& row)
+{
+	uint8_t dirty = row.dirty;
+	if (dirty & (1u << Symbol)) snprintf(row.cells[Symbol], kCellSize, "%s", symbolName(row.symbol));
+	if (dirty & (1u << Last))   snprintf(row.cells[Last], kCellSize, "%.2f", row.last);
+	if (dirty & (1u << Change)) snprintf(row.cells[Change], kCellSize, "%+.2f%%", row.changePercent());
+	if (dirty & (1u << Bid))    snprintf(row.cells[Bid], kCellSize, "%.2f", row.bid);
+	if (dirty & (1u << Ask))    snprintf(row.cells[Ask], kCellSize, "%.2f", row.ask);
+	if (dirty & (1u << Volume)) {
+		double v = row.volume;
+		if (v >= 1e9)      snprintf(row.cells[Volume], kCellSize, "%.2fB", v / 1e9);
+		else if (v >= 1e6) snprintf(row.cells[Volume], kCellSize, "%.2fM", v / 1e6);
+		else if (v >= 1e3) snprintf(row.cells[Volume], kCellSize, "%.1fK", v / 1e3);
+		else               snprintf(row.cells[Volume], kCellSize, "%.0f", v);
+	}
+	row.dirty = 0;
+}
+
+size_t Watchlist::formatDirty()
+{
+	size_t formatted = 0;
+	for (size_t word = 0; word < m_dirtyRows.size(); word++) {
+		uint64_t bits = m_dirtyRows[word];
+		while (bits) {
+			size_t index = word * 64 + (size_t)std::countr_zero(bits);
+			bits &= bits - 1;
+			formatRow(m_rows[index]);
+			formatted++;
+		}
+		m_dirtyRows[word] = 0;
+	}
+	return formatted;
+}
+
+void Watchlist::simulate(size_t ticks, uint64_t nowNs)
+{
+	if (m_rows.empty()) return;
+
+	for (size_t i = 0; i < ticks; i++) {
+		// xorshift64: cheap and good enough to spread ticks over rows
+		m_simState ^= m_simState << 13;
+		m_simState ^= m_simState >> 7;
+		m_simState ^= m_simState << 17;
+		uint32_t index = (uint32_t)(m_simState % m_rows.size());
+		Row& row = m_rows[index];
+
+		if (row.close == 0.0) {
+			set(index, Change, row.close, 20.0 + (double)(m_simState >> 40 & 0xFFF) / 16.0, nowNs);
+			set(index, Last, row.last, row.close, nowNs);
+		}
+		double step = ((int)(m_simState >> 24 & 7) - 3) * 0.01;
+		double last = (std::max)(0.01, row.last + step);
+		if (set(index, Last, row.last, last, nowNs)) row.dirty |= 1u << Change;
+		set(index, Bid, row.bid, last - 0.01, nowNs);
+		set(index, Ask, row.ask, last + 0.01, nowNs);
+		set(index, Volume, row.volume, row.volume + 100.0 * (double)(m_simState >> 56 & 15), nowNs);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "symbols.h"
+
+// One tickPrice/tickSize value for a watchlist subscription
+enum class QuoteTickType : uint8_t { Last, Close, Bid, Ask, Volume };
+
+struct QuoteTick {
+	int reqId;
+	QuoteTickType type;
+	double value;
+};
+
+// Quote board for many symbols.
+//
+// Ticks only store the new value and set a bit in the row's dirty mask
+// plus the row's bit in a board-wide bitset. Once per frame formatDirty()
+// walks just the set bits and re-formats only the cells that changed, so a
+// frame costs the rows that ticked, not the rows listed.
+class Watchlist {
+public:
+	enum Column { Symbol, Last, Change, Bid, Ask, Volume, ColumnCount };
+	static constexpr size_t kCellSize = 16;
+	static constexpr uint64_t kFlashNs = 400000000;     // Cell highlight after a change
+
+	struct Row {
+		SymbolId symbol = kNoSymbol;
+		int reqId = 0;
+		double last = 0.0;
+		double close = 0.0;
+		double bid = 0.0;
+		double ask = 0.0;
+		double volume = 0.0;
+
+		uint8_t dirty = 0;                      // Bit per Column awaiting format
+		int8_t flashDirection[ColumnCount] = {}; // +1 up, -1 down, 0 none
+		uint64_t flashNs[ColumnCount] = {};     // When the cell last changed
+		char cells[ColumnCount][kCellSize] = {};
+
+		double changePercent() const { return close != 0.0 && last != 0.0 ? (last - close) / close * 100.0 : 0.0; }
+	};
+
+	bool add(SymbolId symbol, int reqId);       // False if already listed
+	void clear();
+
+	bool contains(SymbolId symbol) const { return m_bySymbol.count(symbol) > 0; }
+	size_t size() const { return m_rows.size(); }
+	const Row& row(size_t i) const { return m_rows[i]; }
+	const std::vector<Row>& rows() const { return m_rows; }
+
+	void apply(const QuoteTick& tick, uint64_t nowNs);
+	// Re-formats the dirty cells; returns the number of rows touched
+	size_t formatDirty();
+
+	// Synthetic ticks across every row, for load testing without TWS
+	void simulate(size_t ticks, uint64_t nowNs);
+
+private:
+	std::vector<Row> m_rows;
+	std::vector<uint64_t> m_dirtyRows;          // Bit per row
+	std::unordered_map<int, uint32_t> m_byReqId;
+	std::unordered_map<SymbolId, uint32_t> m_bySymbol;
+	uint64_t m_simState = 0x9E3779B97F4A7C15ull;
+
+	bool set(uint32_t index, Column column, double& field, double value, uint64_t nowNs);
+	void formatRow(Row& row);
+};